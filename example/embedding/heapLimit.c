@@ -0,0 +1,54 @@
+// Runs a script under a heap limit. Every allocation that would grow the heap
+// past the limit fails with an "Out of memory" error, which the script catches
+// with Fiber.try, and the VM keeps running within the limit.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cardinal.h"
+
+static const char* script =
+"var tries = [\n"
+"	[\"typed array\", Fn.new { Float64Array.new(10000000) }],\n"
+"	[\"string doubling\", Fn.new {\n"
+"		var s = \"x\"\n"
+"		while (true) s = s + s\n"
+"	}],\n"
+"	[\"string builder\", Fn.new {\n"
+"		var sb = StringBuilder.new()\n"
+"		while (true) sb.add(\"0123456789abcdef\")\n"
+"	}],\n"
+"	[\"list\", Fn.new {\n"
+"		var list = []\n"
+"		while (true) list.add(list.count)\n"
+"	}],\n"
+"	[\"interpolation\", Fn.new {\n"
+"		var s = \"x\"\n"
+"		while (true) s = \"%(s)%(s)\"\n"
+"	}]\n"
+"]\n"
+"for (try in tries) {\n"
+"	var error = Fiber.new(try[1]).try()\n"
+"	IO.println(try[0] + \": \" + error.toString)\n"
+"}\n"
+"IO.println(\"still running: \" + (1..3).toList.toString)\n";
+
+int main() {
+	CardinalConfiguration config;
+	memset(&config, 0, sizeof(config));
+
+	// Collect early, and never let the heap grow past 4MB.
+	config.initialHeapSize = 1024 * 1024;
+	config.maxHeapSize = 4 * 1024 * 1024;
+	config.rootDirectory = ".";
+
+	CardinalVM* vm = cardinalNewVM(&config);
+	CardinalLangResult result = cardinalInterpret(vm, "heapLimit", script);
+
+	size_t usage, peak, limit;
+	cardinalGetMemoryStatistics(vm, &usage, &peak, &limit);
+	printf("peak heap: %lu of %lu bytes\n", (unsigned long) peak, (unsigned long) limit);
+
+	cardinalFreeVM(vm);
+	return result == CARDINAL_SUCCESS && peak <= limit ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+// Calls script methods from the host through the slots of a method handle.
+// The same handle and slots are reused for every call, both from the host
+// itself and from inside a foreign method that a script is running.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cardinal.h"
+
+static const char* geometry =
+"class Geometry {\n"
+"	static hypot(a, b) { (a * a + b * b).sqrt }\n"
+"	static describe(name) { \"%(name) has %(name.count) letters\" }\n"
+"	static checked(n) {\n"
+"		if (n < 0) Fiber.abort(\"negative side\")\n"
+"		return n\n"
+"	}\n"
+"}\n";
+
+static const char* script =
+"var total = Host.sumOfHypots(100)\n"
+"IO.println(\"script sum: \" + total.toString)\n"
+"var after = 0\n"
+"for (i in 1..10) after = after + i\n"
+"IO.println(\"script continues: \" + after.toString)\n";
+
+static CardinalValue* hypot = NULL;
+
+// Sums the hypotenuses of the triangles with sides i and i + 1 for i in [0, n).
+static double sumOfHypots(CardinalVM* vm, int n) {
+	double sum = 0;
+	for (int i = 0; i < n; i++) {
+		cardinalSetSlotDouble(vm, hypot, 1, i);
+		cardinalSetSlotDouble(vm, hypot, 2, i + 1);
+		if (cardinalCallSlots(vm, hypot) != CARDINAL_SUCCESS) return -1;
+		sum += cardinalGetSlotDouble(vm, hypot, 0);
+	}
+	return sum;
+}
+
+// Host.sumOfHypots(_), which calls back into the script while it is running.
+static void hostSumOfHypots(CardinalVM* vm) {
+	int n = (int) cardinalGetArgumentDouble(vm, 1);
+	cardinalReturnDouble(vm, sumOfHypots(vm, n));
+}
+
+int main() {
+	CardinalConfiguration config;
+	memset(&config, 0, sizeof(config));
+	config.rootDirectory = ".";
+
+	CardinalVM* vm = cardinalNewVM(&config);
+	cardinalDefineStaticMethod(vm, NULL, "Host", "sumOfHypots(_)", hostSumOfHypots);
+
+	bool ok = cardinalInterpretModule(vm, "geometry", geometry, "geometry") == CARDINAL_SUCCESS;
+	hypot = cardinalGetMethod(vm, "geometry", "Geometry", "hypot(_,_)");
+	CardinalValue* describe = cardinalGetMethod(vm, "geometry", "Geometry", "describe(_)");
+	CardinalValue* checked = cardinalGetMethod(vm, "geometry", "Geometry", "checked(_)");
+
+	// Many calls through the same slots.
+	printf("host sum: %.6f\n", sumOfHypots(vm, 100));
+
+	const char* names[] = { "triangle", "square", "hexagon" };
+	for (int i = 0; i < 3; i++) {
+		cardinalSetSlotString(vm, describe, 1, names[i], -1);
+		ok = ok && cardinalCallSlots(vm, describe) == CARDINAL_SUCCESS;
+		printf("%s\n", cardinalGetSlotString(vm, describe, 0));
+	}
+
+	// A failed call leaves the slots ready for the next one.
+	cardinalSetSlotDouble(vm, checked, 1, -1);
+	ok = ok && cardinalCallSlots(vm, checked) == CARDINAL_RUNTIME_ERROR;
+	cardinalSetSlotDouble(vm, checked, 1, 3);
+	ok = ok && cardinalCallSlots(vm, checked) == CARDINAL_SUCCESS;
+	printf("checked after error: %g\n", cardinalGetSlotDouble(vm, checked, 0));
+
+	// Slots the method does not have are ignored, and a slot read as the wrong
+	// type gives the documented default.
+	cardinalSetSlotDouble(vm, checked, 5, 1);
+	cardinalSetSlotDouble(vm, checked, -1, 1);
+	ok = ok && cardinalGetSlotString(vm, checked, 0) == NULL;
+	ok = ok && !cardinalGetSlotBool(vm, checked, 0);
+	ok = ok && cardinalGetSlotDouble(vm, describe, 0) == 0.0;
+	ok = ok && cardinalGetSlotValue(vm, checked, 7) == NULL;
+	ok = ok && cardinalIsSlotNull(vm, checked, 2);
+
+	// The script calls the host, which calls the script through the slots. The
+	// script must keep running on its own fiber afterwards.
+	ok = ok && cardinalInterpret(vm, "slots", script) == CARDINAL_SUCCESS;
+
+	cardinalReleaseObject(vm, hypot);
+	cardinalReleaseObject(vm, describe);
+	cardinalReleaseObject(vm, checked);
+	cardinalFreeVM(vm);
+	return ok ? 0 : 1;
+}
@@ -36,6 +36,8 @@
 typedef struct CardinalVM CardinalVM;
 
 // Define for the Cardinal values that you store inside the c++ host application
+// Functions that create one return NULL when the VM holds too many of them at
+// once, which only happens on 32-bit targets after 65535 unreleased values.
 typedef struct CardinalValue CardinalValue;
 
 // A generic allocation function that handles all explicit memory management
@@ -129,6 +131,19 @@ typedef struct CardinalConfiguration {
 	/// If zero, defaults to 10MB.
 	size_t initialHeapSize;
 	
+	/// The maximum number of bytes Cardinal may have in use. When an allocation
+	/// crosses this limit, a garbage collection is forced first. If the heap is
+	/// still too large afterwards, the running fiber fails with a runtime error
+	/// that can be caught with `Fiber.try`.
+	///
+	/// Methods that allocate an amount chosen by the script, like creating a
+	/// typed array, joining strings or growing a list or string builder, fail
+	/// before allocating. Other allocations fail the fiber at its next call or
+	/// loop.
+	///
+	/// If zero, the heap size is not limited.
+	size_t maxHeapSize;
+	
 	/// The root directoy
 	const char* rootDirectory;
 	
@@ -139,6 +154,15 @@ typedef struct CardinalConfiguration {
 	/// Maximum call depth size
 	/// The default is 0 (sets max calldepth to 255)
 	int callDepth;
+	
+	/// The number of stack slots a new fiber starts with. The stack grows on
+	/// demand, so this can be small when many fibers are used.
+	/// The default is 0 (sets the initial stack to 16 slots)
+	int fiberStackSize;
+	
+	/// The number of call frames a new fiber starts with.
+	/// The default is 0 (sets the initial number of call frames to 8)
+	int fiberCallFrames;
 
 } CardinalConfiguration;
 
@@ -155,6 +179,11 @@ void cardinalFreeVM(CardinalVM* vm);
 // Set the root directory
 void cardinalSetRootDirectory(CardinalVM* vm, const char* path);
 
+// Retrieves the memory usage of [vm]: the number of bytes currently in use, the
+// highest number of bytes in use since the VM was created and the heap limit
+// (zero if the heap is not limited).
+void cardinalGetMemoryStatistics(CardinalVM* vm, size_t* usage, size_t* peak, size_t* limit);
+
 
 ///////////////////////////////////////////////////////////////////////////////////
 //// Methods dealing with running Cardinal Code.
@@ -235,6 +264,9 @@ void cardinalSetDebugMode(CardinalVM* vm, bool set);
 //// [cardinalGetMethod] creates a method that operates on a variable from a module
 //// [cardinalGetMethodObject] creates a method that operates on a host object
 //// [cardinalCall] calls a created method
+//// [cardinalCallSlots] calls a created method with the arguments in its slots
+//// [cardinalSetSlotDouble] sets an argument slot of a method to a number
+//// [cardinalGetSlotDouble] gets a number from a slot of a method
 //// [createModule] creates a module
 //// [removeModule] removes a module
 //// [cardinalRemoveVariable] removes a variable
@@ -245,6 +277,8 @@ void cardinalSetDebugMode(CardinalVM* vm, bool set);
 //// [cardinalObjectListAdd] adds an element to the list
 //// [cardinalCreateObjectMap] create a new map
 //// [cardinalObjectMapSet] sets a key in the map to a certain value
+//// [cardinalCreateTypedArray] create a new typed array
+//// [cardinalGetTypedArray] gets the elements of a typed array
 ////
 ///////////////////////////////////////////////////////////////////////////////////
 
@@ -299,6 +333,49 @@ CardinalValue* cardinalGetMethodObject(CardinalVM* vm, const char* module, Cardi
 // Call a created method
 CardinalValue* cardinalCall(CardinalVM* vm, CardinalValue* method, int args, ...);
 
+//// 
+//// The following methods call a created method without creating host objects.
+//// Slots 1 to n of a method hold its arguments and slot 0 holds the result of
+//// the last call. The arguments are cleared after every call.
+//// Setting a slot that the method does not have does nothing, and getting it
+//// returns the same as getting a slot of the wrong type.
+//// 
+
+// Call a created method with the arguments in its slots
+CardinalLangResult cardinalCallSlots(CardinalVM* vm, CardinalValue* method);
+
+// Set the argument in [slot] to the number [value]
+void cardinalSetSlotDouble(CardinalVM* vm, CardinalValue* method, int slot, double value);
+
+// Set the argument in [slot] to the bool [value]
+void cardinalSetSlotBool(CardinalVM* vm, CardinalValue* method, int slot, bool value);
+
+// Set the argument in [slot] to a new string with [text] of length [length]
+void cardinalSetSlotString(CardinalVM* vm, CardinalValue* method, int slot, const char* text, int length);
+
+// Set the argument in [slot] to null
+void cardinalSetSlotNull(CardinalVM* vm, CardinalValue* method, int slot);
+
+// Set the argument in [slot] to the host object [value]
+void cardinalSetSlotValue(CardinalVM* vm, CardinalValue* method, int slot, CardinalValue* value);
+
+// Get [slot] as a number, or 0 if it is not a number
+double cardinalGetSlotDouble(CardinalVM* vm, CardinalValue* method, int slot);
+
+// Get [slot] as a bool, or false if it is not a bool
+bool cardinalGetSlotBool(CardinalVM* vm, CardinalValue* method, int slot);
+
+// Get [slot] as a const char*, valid until the next call of the method, or
+// NULL if it is not a string
+const char* cardinalGetSlotString(CardinalVM* vm, CardinalValue* method, int slot);
+
+// Check whether [slot] is null, true if the method has no such slot
+bool cardinalIsSlotNull(CardinalVM* vm, CardinalValue* method, int slot);
+
+// Get [slot] as a new host object, which has to be released, or NULL if the
+// method has no such slot
+CardinalValue* cardinalGetSlotValue(CardinalVM* vm, CardinalValue* method, int slot);
+
 // Creates a module
 void createModule(CardinalVM* vm, const char* name);
 
@@ -330,6 +407,28 @@ CardinalValue* cardinalCreateObjectMap(CardinalVM* vm);
 // Adds an element to the list
 void cardinalObjectMapSet(CardinalVM* vm, CardinalValue* list, CardinalValue* key, CardinalValue* val);
 
+//// 
+//// The following methods expose typed arrays
+//// 
+
+// The element types of a typed array
+typedef enum CardinalArrayType {
+	CARDINAL_ARRAY_FLOAT64,
+	CARDINAL_ARRAY_INT32,
+	CARDINAL_ARRAY_BYTE
+} CardinalArrayType;
+
+// Creates a new typed array of [count] elements of [type], all set to zero.
+// Returns NULL if [count] is larger than 2147483647
+CardinalValue* cardinalCreateTypedArray(CardinalVM* vm, CardinalArrayType type, size_t count);
+
+// Get the elements of the typed array [val], which can be read and written
+// directly. They are stored as doubles, int32_t's or uint8_t's, depending on
+// the type of the array. The buffer stays valid as long as the array is alive.
+// The type and the number of elements are stored in [type] and [count] unless
+// they are NULL. Returns NULL if [val] is not a typed array
+void* cardinalGetTypedArray(CardinalVM* vm, CardinalValue* val, CardinalArrayType* type, size_t* count);
+
 
 ///////////////////////////////////////////////////////////////////////////////////
 //// Methods below can be used to define classes and methods to the VM.
@@ -16,9 +16,12 @@ CardinalVM* createVM(const char* path) {
 	config.reallocateFn = NULL;
 	config.minHeapSize = 0;
 	config.heapGrowthPercent = 0;
+	config.maxHeapSize = 0;
 	config.debugCallback = NULL;
 	config.stackMax = 0;
 	config.callDepth = 0;
+	config.fiberStackSize = 0;
+	config.fiberCallFrames = 0;
 	
 	// Set the path correctly
 	config.rootDirectory = path;
@@ -8,6 +8,7 @@
 #include "cardinal_compiler.h"
 #include "cardinal_vm.h"
 #include "cardinal_debug.h"
+#include "cardinal_number.h"
 
 
 // This is written in bottom-up order, so the tokenization comes first, then
@@ -78,6 +79,20 @@ typedef enum TokenType {
     TOKEN_NUMBER,
     TOKEN_STRING,
 
+    // A portion of a string literal preceding an interpolated expression. This
+    // string:
+    //
+    //     "a %(b) c %(d) e"
+    //
+    // is tokenized to:
+    //
+    //     TOKEN_INTERPOLATION "a "
+    //     TOKEN_NAME          b
+    //     TOKEN_INTERPOLATION " c "
+    //     TOKEN_NAME          d
+    //     TOKEN_STRING        " e"
+    TOKEN_INTERPOLATION,
+
     TOKEN_LINE, // \n
 	
 	TOKEN_PUBLIC,
@@ -147,6 +162,18 @@ typedef struct Parser {
 	/// literal. Unlike the raw token, this will have escape sequences translated
 	/// to their literal equivalent.
 	ByteBuffer string;
+
+	/// The unescaped text of the previous token if it's a string literal. The
+	/// parser is one token ahead, and inside an interpolation that token may be
+	/// a string literal too.
+	ByteBuffer previousString;
+
+	/// The number of unmatched "(" in each interpolated expression being lexed.
+	/// A ")" only ends the innermost interpolation when its count drops to zero.
+	int parens[MAX_INTERPOLATION_NESTING];
+
+	/// The number of interpolated expressions being lexed.
+	int numParens;
 	
 	/// If a number literal is currently being parsed this will hold its value.
 	double number;
@@ -326,6 +353,10 @@ typedef struct CardinalCompiler {
 	
 	/// Indicates whether debug symbols need to be added
 	bool debug;
+
+	/// The number of strings the string literal compiled last left on the stack
+	/// to be concatenated, or zero if the last expression was no string literal.
+	int stringParts;
 	
 	/// Table for undefined fields
 	ObjMap* undefined;
@@ -474,6 +505,7 @@ static void initCompiler(Compiler* compiler, Parser* parser, Compiler* parent, b
 	compiler->numParams = 0;
 	compiler->loop = NULL;
 	compiler->enclosingClass = NULL;
+	compiler->stringParts = 0;
 	compiler->undefined = NULL;
 	compiler->constants = NULL;
 	
@@ -687,7 +719,7 @@ static void readNumber(Parser* parser) {
 	}
 	
 	char* end;
-	parser->number = strtod(parser->tokenStart, &end);
+	parser->number = cardinalParseNumber(parser->tokenStart, &end);
 
 	if (end == parser->tokenStart) {
 		lexError(parser, "Invalid number literal.");
@@ -794,11 +826,25 @@ static void readUnicodeEscape(Parser* parser) {
 // Finishes lexing a string literal.
 static void readString(Parser* parser) {
 	cardinalByteBufferClear(parser->vm, &parser->string);
+	TokenType type = TOKEN_STRING;
 
 	for (;;) {
 		char c = nextChar(parser);
 		if (c == '"') break;
 
+		// A "%(" starts an interpolated expression. Any other "%" is just text.
+		if (c == '%' && peekChar(parser) == '(') {
+			if (parser->numParens < MAX_INTERPOLATION_NESTING) {
+				nextChar(parser);
+				parser->parens[parser->numParens++] = 1;
+				type = TOKEN_INTERPOLATION;
+				break;
+			}
+
+			lexError(parser, "Interpolation may only nest %d levels deep.",
+			         MAX_INTERPOLATION_NESTING);
+		}
+
 		if (c == '\0') {
 			lexError(parser, "Unterminated string.");
 
@@ -812,6 +858,7 @@ static void readString(Parser* parser) {
 			switch (nextChar(parser)) {
 				case '"':  addStringChar(parser, '"'); break;
 				case '\\': addStringChar(parser, '\\'); break;
+				case '%':  addStringChar(parser, '%'); break;
 				case '0':  addStringChar(parser, '\0'); break;
 				case 'a':  addStringChar(parser, '\a'); break;
 				case 'b':  addStringChar(parser, '\b'); break;
@@ -832,13 +879,18 @@ static void readString(Parser* parser) {
 		}
 	}
 
-	makeToken(parser, TOKEN_STRING);
+	makeToken(parser, type);
 }
 
 // Lex the next token and store it in [parser.current].
 static void nextToken(Parser* parser) {
 	parser->previous = parser->current;
 
+	// Keep the text of a string literal with the token it belongs to.
+	ByteBuffer string = parser->previousString;
+	parser->previousString = parser->string;
+	parser->string = string;
+
 	// If we are out of tokens, don't try to tokenize any more. We *do* still
 	// copy the TOKEN_EOF to previous so that code that expects it to be consumed
 	// will still work.
@@ -849,8 +901,24 @@ static void nextToken(Parser* parser) {
 
 		char c = nextChar(parser);
 		switch (c) {
-			case '(': makeToken(parser, TOKEN_LEFT_PAREN); return;
-			case ')': makeToken(parser, TOKEN_RIGHT_PAREN); return;
+			case '(':
+				// Count the unmatched "(" of an interpolated expression.
+				if (parser->numParens > 0) parser->parens[parser->numParens - 1]++;
+				makeToken(parser, TOKEN_LEFT_PAREN);
+				return;
+
+			case ')':
+				// The ")" matching the "%(" ends the interpolated expression, and the
+				// rest of the string literal follows it.
+				if (parser->numParens > 0 &&
+				        --parser->parens[parser->numParens - 1] == 0) {
+					parser->numParens--;
+					readString(parser);
+					return;
+				}
+
+				makeToken(parser, TOKEN_RIGHT_PAREN);
+				return;
 			case '[': makeToken(parser, TOKEN_LEFT_BRACKET); return;
 			case ']': makeToken(parser, TOKEN_RIGHT_BRACKET); return;
 			case '{': makeToken(parser, TOKEN_LEFT_BRACE); return;
@@ -1635,6 +1703,7 @@ static void expression(Compiler* compiler);
 static void statement(Compiler* compiler);
 static void definition(Compiler* compiler);
 static void parsePrecedence(Compiler* compiler, bool allowAssignment, Precedence precedence);
+static void parseInfix(Compiler* compiler, bool allowAssignment, Precedence precedence);
 
 ///////////////////////////////////////////////////////////////////////////////////
 //// GRAMMER
@@ -2575,10 +2644,11 @@ static void module_(Compiler* compiler, bool allowAssignment) {
 // Parses a string literal and adds it to the constant table.
 static int stringConstant(Compiler* compiler) {
 	// Define a constant for the literal.
-	int constant = addConstant(compiler, cardinalNewString(compiler->parser->vm,
-	                           (char*)compiler->parser->string.data, compiler->parser->string.count));
+	int constant = addConstant(compiler, cardinalNewInternedString(compiler->parser->vm,
+	                           (char*)compiler->parser->previousString.data,
+	                           compiler->parser->previousString.count));
 
-	cardinalByteBufferClear(compiler->parser->vm, &compiler->parser->string);
+	cardinalByteBufferClear(compiler->parser->vm, &compiler->parser->previousString);
 
 	return constant;
 }
@@ -2590,6 +2660,68 @@ static void string(Compiler* compiler, bool allowAssignment) {
 	// Compile the code to load the constant.
 	//emitShort(compiler, CODE_CONSTANT, constant);
 	emitValue(compiler, CODE_CONSTANT, constant, CONSTANT_BYTE);
+
+	// The literal may start a concatenation.
+	compiler->stringParts = 1;
+}
+
+// Counts one more string in a concatenation of [parts] strings, before it is
+// pushed. If there already are as many as one CODE_CONCAT_N takes, those are
+// joined first.
+static int addConcatPart(Compiler* compiler, int parts) {
+	if (parts == MAX_CONCAT_PARTS) {
+		emitValue(compiler, CODE_CONCAT_N, parts, 1);
+		parts = 1;
+	}
+	return parts + 1;
+}
+
+// Compiles a string literal with interpolated expressions. The text between the
+// expressions and the results of calling "toString" on them are pushed, to be
+// joined by a single CODE_CONCAT_N.
+static void stringInterpolation(Compiler* compiler, bool allowAssignment) {
+	UNUSED(allowAssignment);
+	int parts = 0;
+
+	do {
+		// The text before the expression, if there is any.
+		if (compiler->parser->previousString.count > 0) {
+			parts = addConcatPart(compiler, parts);
+			emitValue(compiler, CODE_CONSTANT, stringConstant(compiler), CONSTANT_BYTE);
+		}
+
+		parts = addConcatPart(compiler, parts);
+		expression(compiler);
+		callMethod(compiler, 0, "toString", 8);
+	} while (match(compiler, TOKEN_INTERPOLATION));
+
+	// The text after the last expression.
+	consume(compiler, TOKEN_STRING, "Expect end of string interpolation.");
+	if (compiler->parser->previousString.count > 0) {
+		parts = addConcatPart(compiler, parts);
+		emitValue(compiler, CODE_CONSTANT, stringConstant(compiler), CONSTANT_BYTE);
+	}
+
+	compiler->stringParts = parts;
+}
+
+// Compiles the "+" operators following the [parts] strings of a string literal
+// into one concatenation, as long as they bind at least as tightly as
+// [precedence]. Since every "+" in such a chain is called on a string, the
+// operands are pushed first and joined at once, instead of creating a new
+// string for each "+".
+static void concatenation(Compiler* compiler, int parts, Precedence precedence) {
+	if (precedence <= PREC_TERM) {
+		while (match(compiler, TOKEN_PLUS)) {
+			// An infix operator cannot end an expression.
+			ignoreNewlines(compiler);
+
+			parts = addConcatPart(compiler, parts);
+			parsePrecedence(compiler, false, (Precedence)(PREC_TERM + 1));
+		}
+	}
+
+	if (parts > 1) emitValue(compiler, CODE_CONCAT_N, parts, 1);
 }
 
 static void super_(Compiler* compiler, bool allowAssignment) {
@@ -3058,6 +3190,7 @@ GrammarRule rules[] = {
 	/* TOKEN_NAME          */ { name, NULL, namedSignature, PREC_NONE, NULL },
 	/* TOKEN_NUMBER        */ PREFIX(number),
 	/* TOKEN_STRING        */ PREFIX(string),
+	/* TOKEN_INTERPOLATION */ PREFIX(stringInterpolation),
 	/* TOKEN_LINE          */ UNUSED_T,
 	/* TOKEN_PUBLIC        */ UNUSED_T,
 	/* TOKEN_PRIVATE       */ UNUSED_T,
@@ -3089,6 +3222,19 @@ void parsePrecedence(Compiler* compiler, bool allowAssignment,
 
 	prefix(compiler, allowAssignment);
 
+	// A string literal may be followed by more strings to concatenate.
+	if (compiler->stringParts > 0) {
+		int parts = compiler->stringParts;
+		compiler->stringParts = 0;
+		concatenation(compiler, parts, precedence);
+	}
+
+	parseInfix(compiler, allowAssignment, precedence);
+}
+
+// Compiles the infix operators following an operand that was already compiled,
+// as long as they bind at least as tightly as [precedence].
+static void parseInfix(Compiler* compiler, bool allowAssignment, Precedence precedence) {
 	while (precedence <= rules[compiler->parser->current.type].precedence) {
 		nextToken(compiler->parser);
 		GrammarFn infix = rules[compiler->parser->previous.type].infix;
@@ -3215,6 +3361,12 @@ static int getNumArguments(const uint8_t* bytecode, const Value* constants, int
 		case CODE_AND:
 		case CODE_OR:
 			return OFFSET_BYTE;
+			
+		case CODE_FOR_RANGE_SETUP:
+			return LOCAL_BYTE + OFFSET_BYTE;
+			
+		case CODE_FOR_RANGE:
+			return LOCAL_BYTE + 1 + 2 * OFFSET_BYTE;
 		
 		case CODE_METHOD_INSTANCE:
 		case CODE_METHOD_STATIC:
@@ -3224,6 +3376,9 @@ static int getNumArguments(const uint8_t* bytecode, const Value* constants, int
 		case CODE_IMPORT_VARIABLE:
 			return 4;
 
+		case CODE_CONCAT_N:
+			return 1;
+
 		case CODE_CLOSURE: {
 			#define READ_BYTE()  (bytecode[ip + 1])
 			#define READ_SHORT() ((bytecode[ip + 1] << 8) | bytecode[ip + 2])
@@ -3344,6 +3499,12 @@ static void forStatement(Compiler* compiler) {
 	//   it should exit the loop.
 	// - The .iteratorValue() method is used to get the value at the current
 	//   iterator position.
+	//
+	// When the sequence expression is a range like `from..to` or `from...to`,
+	// [from] and [to] are kept in hidden locals instead. If both turn out to be
+	// numbers, CODE_FOR_RANGE counts through them without creating a range or
+	// calling any methods. Otherwise the range is created after all and the
+	// loop works as above.
 
 	// Create a scope for the hidden local variables used for the iterator.
 	pushScope(compiler);
@@ -3360,18 +3521,70 @@ static void forStatement(Compiler* compiler) {
 
 	// Evaluate the sequence expression and store it in a hidden local variable.
 	// The space in the variable name ensures it won't collide with a user-defined
-	// variable.
-	expression(compiler);
+	// variable. A range is only counted if it is the whole expression, so the
+	// operands are parsed separately from the rest of it.
+	bool isRange = false;
+	bool isInclusive = false;
+	parsePrecedence(compiler, true, PREC_TERM);
+	if (match(compiler, TOKEN_DOTDOT) || match(compiler, TOKEN_DOTDOTDOT)) {
+		isInclusive = compiler->parser->previous.type == TOKEN_DOTDOT;
+		ignoreNewlines(compiler);
+		parsePrecedence(compiler, false, PREC_TERM);
+		
+		if (peek(compiler) == TOKEN_RIGHT_PAREN) {
+			isRange = true;
+		}
+		else {
+			callMethod(compiler, 1, isInclusive ? "..(_)" : "...(_)", isInclusive ? 5 : 6);
+			parseInfix(compiler, true, PREC_LOWEST);
+		}
+	}
+	else {
+		parseInfix(compiler, true, PREC_LOWEST);
+	}
 	int seqSlot = defineLocal(compiler, "seq ", 4);
+	
+	// The upper end of a range.
+	int toSlot = -1;
+	if (isRange) toSlot = defineLocal(compiler, "to ", 3);
 
 	// Create another hidden local for the iterator object.
 	null(compiler, false);
 	int iterSlot = defineLocal(compiler, "iter ", 5);
 
 	consume(compiler, TOKEN_RIGHT_PAREN, "Expect ')' after loop expression.");
+	
+	if (isRange) {
+		emit(compiler, CODE_FOR_RANGE_SETUP);
+		emitValueArg(compiler, seqSlot, LOCAL_BYTE);
+		int numbersJump = emitValueArg(compiler, 0, OFFSET_BYTE);
+		
+		// The ends are not both numbers, so create the range object and clear
+		// [toSlot] to tell CODE_FOR_RANGE to leave the loop to the methods.
+		loadLocal(compiler, seqSlot);
+		loadLocal(compiler, toSlot);
+		callMethod(compiler, 1, isInclusive ? "..(_)" : "...(_)", isInclusive ? 5 : 6);
+		emitValue(compiler, CODE_STORE_LOCAL, seqSlot, LOCAL_BYTE);
+		emit(compiler, CODE_POP);
+		null(compiler, false);
+		emitValue(compiler, CODE_STORE_LOCAL, toSlot, LOCAL_BYTE);
+		emit(compiler, CODE_POP);
+		
+		patchJump(compiler, numbersJump);
+	}
 
 	Loop loop;
 	startLoop(compiler, &loop);
+	
+	int exitJump = -1;
+	int bodyJump = -1;
+	if (isRange) {
+		emit(compiler, CODE_FOR_RANGE);
+		emitValueArg(compiler, seqSlot, LOCAL_BYTE);
+		emitByteArg(compiler, isInclusive);
+		exitJump = emitValueArg(compiler, 0, OFFSET_BYTE);
+		bodyJump = emitValueArg(compiler, 0, OFFSET_BYTE);
+	}
 
 	// Advance the iterator by calling the ".iterate" method on the sequence.
 	loadLocal(compiler, seqSlot);
@@ -3382,6 +3595,11 @@ static void forStatement(Compiler* compiler) {
 	// Store the iterator back in its local for the next iteration.
 	emitValue(compiler, CODE_STORE_LOCAL, iterSlot, LOCAL_BYTE);
 	// TODO: We can probably get this working with a bit less stack juggling.
+	
+	// Both offsets of CODE_FOR_RANGE start after its last argument.
+	if (isRange) {
+		setByteCode(compiler, exitJump, compiler->bytecode.count - bodyJump - OFFSET_BYTE, OFFSET_BYTE);
+	}
 
 	testExitLoop(compiler);
 
@@ -3390,6 +3608,8 @@ static void forStatement(Compiler* compiler) {
 	loadLocal(compiler, iterSlot);
 
 	callMethod(compiler, 1, "iteratorValue(_)", 16);
+	
+	if (isRange) patchJump(compiler, bodyJump);
 
 	// Bind the loop variable in its own scope. This ensures we get a fresh
 	// variable each iteration so that closures for it don't all see the same one.
@@ -4275,7 +4495,10 @@ ObjFn* cardinalCompile(CardinalVM* vm, ObjModule* module,
 	parser.skipNewlines = true;
 	parser.hasError = false;
 
+	parser.numParens = 0;
+
 	cardinalByteBufferInit(vm, &parser.string);
+	cardinalByteBufferInit(vm, &parser.previousString);
 
 	// Read the first token.
 	nextToken(&parser);
@@ -4316,6 +4539,10 @@ ObjFn* cardinalCompile(CardinalVM* vm, ObjModule* module,
 		}
 	}
 	
+	// Free the text of a string literal an error left behind.
+	cardinalByteBufferClear(vm, &parser.string);
+	cardinalByteBufferClear(vm, &parser.previousString);
+
 	ObjFn* fn = endCompiler(&compiler, "(script)", 8);
 	cardinalSetCompiler(vm, NULL);
 	return fn;
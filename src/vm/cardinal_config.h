@@ -101,11 +101,11 @@
 // flexible array of [count] objects of [arrayType].
 #define ALLOCATE_FLEX(vm, mainType, arrayType, count) \
     ((mainType*)cardinalReallocate(vm, NULL, 0, \
-    sizeof(mainType) + sizeof(arrayType) * count))
+    sizeof(mainType) + sizeof(arrayType) * (count)))
 
 // Use the VM's allocator to allocate an array of [count] elements of [type].
 #define ALLOCATE_ARRAY(vm, type, count) \
-    ((type*)cardinalReallocate(vm, NULL, 0, sizeof(type) * count))
+    ((type*)cardinalReallocate(vm, NULL, 0, sizeof(type) * (count)))
 
 // Use the VM's allocator to free the previously allocated memory at [pointer].
 #define DEALLOCATE(vm, pointer) cardinalReallocate(vm, pointer, 0, 0)
@@ -148,6 +148,31 @@
 	#endif
 #endif
 
+// If true, map lookups compare the control bytes of 16 entries at once using
+// SSE2 instructions. Otherwise a plain loop is used.
+//
+// Defaults to on when the target supports SSE2.
+#ifndef CARDINAL_MAP_SSE2
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define CARDINAL_MAP_SSE2 1
+	#else
+		#define CARDINAL_MAP_SSE2 0
+	#endif
+#endif
+
+// If true, the bulk numeric kernels of typed arrays (add, fma, dot, ...) use
+// SSE2 instructions, and AVX instructions when the processor reports support
+// for them at runtime. Otherwise plain loops are used.
+//
+// Defaults to on when the target supports SSE2.
+#ifndef CARDINAL_SIMD
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define CARDINAL_SIMD 1
+	#else
+		#define CARDINAL_SIMD 0
+	#endif
+#endif
+
 // The Microsoft compiler does not support the "inline" modifier when compiling
 // as plain C.
 #if defined( _MSC_VER ) && !defined(__cplusplus)
@@ -169,9 +194,14 @@
 //// STACK
 ///////////////////////////////////////////////////////////////////////////////////
 
-// The starting stack size of the vm
+// The size of the stack segments a fiber allocates once its initial stack is
+// full. Segments grow geometrically from the initial stack size up to this.
 #define STACKSIZE 256
 
+// The number of stack slots a new fiber starts with, unless the configuration
+// of the VM gives another size. Kept small so that fibers are cheap to create.
+#define FIBER_STACKSIZE 16
+
 // The rate at which a stacksize's capacity grows when the size exceeds the current
 // capacity. The new capacity will be determined by *multiplying* the old
 // capacity by this. Growing geometrically is necessary to ensure that adding
@@ -185,19 +215,28 @@
 //// CALLFRAME
 ///////////////////////////////////////////////////////////////////////////////////
 
-// The start amount of call frames to be active
-// Used to prevent a stackoverflow
-#define CALLFRAMESIZE 256
+// The start amount of call frames to be active, unless the configuration of
+// the VM gives another size
+#define CALLFRAMESIZE 8
 
 // Used to prevent a stackoverflow
 #define CALLFRAME_MAX 256
 
+// The maximum number of calls from native code into scripts that can run
+// inside each other, like a map stage of a pipeline that iterates another
+// pipeline. Every one of them runs the interpreter on the C stack.
+#define NATIVE_CALL_MAX 128
+
 // The rate at which a callframe's capacity grows when the size exceeds the current
 // capacity. The new capacity will be determined by *multiplying* the old
 // capacity by this. Growing geometrically is necessary to ensure that adding
 // to a callframe has O(1) amortized complexity.
 #define CALLFRAME_GROW_FACTOR 2
 
+// The maximum number of collected fibers the VM keeps around, so new fibers
+// can reuse their object, stack and call frames.
+#define FIBER_POOL_MAX 1024
+
 ///////////////////////////////////////////////////////////////////////////////////
 //// LIST AND TABLE
 ///////////////////////////////////////////////////////////////////////////////////
@@ -205,7 +244,9 @@
 // The initial (and minimum) capacity of a non-empty list object.
 #define LIST_MIN_CAPACITY (10)
 
-// The initial (and minimum) capacity of a non-empty table object.
+// The initial (and minimum) capacity of a non-empty table or map object. They
+// map hashes to entries with a mask, so this has to be a power of two. Maps
+// probe their entries in groups of 16, so it can't be lower than that.
 #define TABLE_MIN_CAPACITY (16)
 
 // The rate at which a list's capacity grows when the size exceeds the current
@@ -217,7 +258,8 @@
 // The rate at which a table's capacity grows when the size exceeds the current
 // capacity. The new capacity will be determined by *multiplying* the old
 // capacity by this. Growing geometrically is necessary to ensure that adding
-// to a table has O(1) amortized complexity.
+// to a table has O(1) amortized complexity. Table and map objects need this to
+// be a power of two as well.
 #define TABLE_GROW_FACTOR (2)
 
 // The maximum percentage of map entries that can be filled before the map is
@@ -225,6 +267,82 @@
 // lookup faster.
 #define MAP_LOAD_PERCENT 75
 
+// The initial (and minimum) capacity of a non-empty deque. Deques wrap their
+// indices around with a mask, so this has to be a power of two. They double in
+// size when they are full.
+#define DEQUE_MIN_CAPACITY (8)
+
+// The initial (and minimum) capacity of a non-empty priority queue. Priority
+// queues double in size when they are full.
+#define PRIORITY_QUEUE_MIN_CAPACITY (8)
+
+// Ranges of a list being sorted that are at most this long are sorted by
+// insertion, which is faster than splitting them any further.
+#define LIST_SORT_INSERTION_COUNT (16)
+
+// The maximum number of elements of a typed array. Their elements are indexed
+// with ints, so larger arrays could not be used.
+#define TYPED_ARRAY_MAX_COUNT (INT32_MAX)
+
+///////////////////////////////////////////////////////////////////////////////////
+//// METHOD TABLES
+///////////////////////////////////////////////////////////////////////////////////
+
+// The initial (and minimum) capacity of the method table of a class that
+// defines any methods. Method tables are indexed with a mask, so this has to be
+// a power of two.
+#define METHOD_TABLE_MIN_CAPACITY (8)
+
+// The method table of a class doubles in size when more than this percentage
+// of its entries would be in use.
+#define METHOD_TABLE_LOAD_PERCENT 50
+
+///////////////////////////////////////////////////////////////////////////////////
+//// SYMBOL TABLES
+///////////////////////////////////////////////////////////////////////////////////
+
+// Symbol tables with fewer names than this are searched linearly. Once a table
+// reaches this size, a hash index is built for it.
+#define SYMBOL_TABLE_INDEX_THRESHOLD (8)
+
+// The hash index of a symbol table is grown when more than this percentage of
+// its slots are used. The number of slots is always a power of two.
+#define SYMBOL_TABLE_LOAD_PERCENT 50
+
+///////////////////////////////////////////////////////////////////////////////////
+//// HOST OBJECTS
+///////////////////////////////////////////////////////////////////////////////////
+
+// The initial number of slots in the host object table. The table doubles in
+// size whenever all slots are in use.
+#define HOST_OBJECTS_MIN_CAPACITY (64)
+
+///////////////////////////////////////////////////////////////////////////////////
+//// STRINGS
+///////////////////////////////////////////////////////////////////////////////////
+
+// Strings created with cardinalNewString that are at most this many bytes long
+// are interned in the string table of the VM, so equal short strings share a
+// single object. String constants from the compiler are always interned.
+#define STRING_INTERN_MAX_LENGTH (64)
+
+// Strings of at least this many bytes are hashed a machine word at a time
+// instead of byte by byte. String hashes are only calculated once a string is
+// first used as a key.
+#define STRING_HASH_WORD_LENGTH (32)
+
+// The code point index of a non-ASCII string stores the byte offset of every
+// this many code points. Looking up a code point by its index decodes at most
+// this many code points, and the index takes four bytes per this many code
+// points.
+#define STRING_CODE_POINT_STRIDE (32)
+
+// The initial (and minimum) capacity in bytes of a non-empty string builder.
+#define STRINGBUILDER_MIN_CAPACITY (64)
+
+// The rate at which the buffer of a string builder grows when it is full.
+#define STRINGBUILDER_GROW_FACTOR (2)
+
 ///////////////////////////////////////////////////////////////////////////////////
 //// MAXIMUMS FOR NAMES OF METHODS AND VARS
 ///////////////////////////////////////////////////////////////////////////////////
@@ -247,6 +365,16 @@
 // is so that error messages mentioning variables can be stack allocated.
 #define MAX_VARIABLE_NAME 64
 
+// The maximum depth that string interpolations can nest. For example, this
+// string has three levels:
+//
+//      "outside %(one + "%(two + "%(three)")")"
+#define MAX_INTERPOLATION_NESTING 8
+
+// The maximum number of strings a single concatenation instruction joins.
+// Longer concatenations are split over several instructions.
+#define MAX_CONCAT_PARTS 255
+
 ///////////////////////////////////////////////////////////////////////////////////
 //// UNSETTABLE
 ///////////////////////////////////////////////////////////////////////////////////
@@ -3,11 +3,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "cardinal_config.h"
 #include "cardinal_core.h"
 #include "cardinal_value.h"
 #include "cardinal_debug.h"
+#include "cardinal_number.h"
+#include "cardinal_simd.h"
 
 #if CARDINAL_USE_MEMORY
 	#include "cardinal_datacenter.h"
@@ -23,6 +26,7 @@ static int validateIndexValue(CardinalVM* vm, Value* args, int count, double val
 static int validateIndex(CardinalVM* vm, Value* args, int count, int argIndex, const char* argName);
 static bool validateString(CardinalVM* vm, Value* args, int index, const char* argName);
 static bool validateException(CardinalVM* vm, Value* args, int index, const char* argName);
+static bool validateMemory(CardinalVM* vm, Value* args, size_t bytes);
 
 static ObjClass* defineSingleClass(CardinalVM* vm, const char* name);
 
@@ -125,9 +129,19 @@ static const char* libSource =
 "		return result\n"
 "	}\n"
 "\n"
-"	//map(transformation) { MapSequence.new(this, transformation) }\n"
+"	// Returns a lazy sequence over this one. The adapters of the lazy sequence\n"
+"	// only call their function when it is iterated.\n"
+"	lazy { SequencePipeline.new(this) }\n"
 "\n"
-"	//where(predicate) { WhereSequence.new(this, predicate) }\n"
+"	take(count) { lazy.take(count) }\n"
+"\n"
+"	skip(count) { lazy.skip(count) }\n"
+"\n"
+"	takeWhile(f) { lazy.takeWhile(f) }\n"
+"\n"
+"	zip(other) { lazy.zip(other) }\n"
+"\n"
+"	flatMap(f) { lazy.flatMap(f) }\n"
 "  \n"
 "	reduce(acc, f) {\n"
 "		for (element in this) {\n"
@@ -153,15 +167,15 @@ static const char* libSource =
 "\n"
 "	join(sep) {\n"
 "		var first = true\n"
-"		var result = \"\"\n"
+"		var result = StringBuilder.new()\n"
 "\n"
 "		for (element in this) {\n"
-"			if (!first) result = result + sep\n"
+"			if (!first) result.add(sep)\n"
 "			first = false\n"
-"			result = result + element.toString\n"
+"			result.add(element)\n"
 "		}\n"
 "\n"
-"		return result\n"
+"		return result.toString\n"
 "	}\n"
 "  \n"
 "	toList {\n"
@@ -173,42 +187,6 @@ static const char* libSource =
 "	}\n"
 "}\n"
 "\n"
-"\n"
-"class MapSequence is Sequence {\n"
-"	\n"
-"	field _sequence\n"
-"	field _fn\n"
-"	\n"
-"	construct new(sequence, fn) {\n"
-"		_sequence = sequence\n"
-"		_fn = fn\n"
-"	}\n"
-"\n"
-"	iterate(iterator) { _sequence.iterate(iterator) }\n"
-"	iteratorValue(iterator) { _fn.call(_sequence.iteratorValue(iterator)) }\n"
-"}\n"
-"\n"
-"class WhereSequence is Sequence {\n"
-"	\n"
-"	field _sequence\n"
-"	field _fn\n"
-"	\n"
-"	\n"
-"	construct new(sequence, fn) {\n"
-"		_sequence = sequence\n"
-"		_fn = fn\n"
-"	}\n"
-"\n"
-"	iterate(iterator) {\n"
-"		while (iterator = _sequence.iterate(iterator)) {\n"
-"		  if (_fn.call(_sequence.iteratorValue(iterator))) break\n"
-"		}\n"
-"		return iterator\n"
-"	}\n"
-"\n"
-"	iteratorValue(iterator) { _sequence.iteratorValue(iterator) }\n"
-"}\n"
-"\n"
 "class String is Sequence {  \n"
 "	bytes { StringByteSequence.new(this) }\n"
 "}\n"
@@ -226,6 +204,17 @@ static const char* libSource =
 "	iteratorValue(iterator) { _string.byteAt(iterator) }\n"
 "}\n"
 "\n"
+"class StringBuilder {\n"
+"	add(value) { addString_(value.toString) }\n"
+"\n"
+"	addAll(sequence) {\n"
+"		for (element in sequence) {\n"
+"			addString_(element.toString)\n"
+"		}\n"
+"		return this\n"
+"	}\n"
+"}\n"
+"\n"
 "class List is Sequence {\n"
 "	addAll(other) {\n"
 "		for (element in other) {\n"
@@ -254,21 +243,46 @@ static const char* libSource =
 "	}\n"
 "}\n"
 "\n"
+"// A chain of lazy adapters over a sequence. The chain is run natively, one\n"
+"// call per stage and element, and map and where add stages instead of\n"
+"// building lists.\n"
+"class SequencePipeline is Sequence {}\n"
+"\n"
+"class TypedArray is Sequence {\n"
+"	toString { \"[\" + join(\", \") + \"]\" }\n"
+"}\n"
+"\n"
+"class Float64Array is TypedArray {}\n"
+"class Int32Array is TypedArray {}\n"
+"class ByteArray is TypedArray {}\n"
+"\n"
+"class Deque is Sequence {\n"
+"	toString { \"[\" + join(\", \") + \"]\" }\n"
+"}\n"
+"\n"
+"class Set is Sequence {\n"
+"	toString { \"{\" + join(\", \") + \"}\" }\n"
+"}\n"
+"\n"
+"class PriorityQueue is Sequence {\n"
+"	toString { \"[\" + join(\", \") + \"]\" }\n"
+"}\n"
+"\n"
 "class Map {\n"
 "	keys { MapKeySequence.new(this) }\n"
 "	values { MapValueSequence.new(this) }\n"
 "\n"
 "	toString {\n"
 "		var first = true\n"
-"		var result = \"{\"\n"
+"		var result = StringBuilder.new().add(\"{\")\n"
 "\n"
 "		for (key in keys) {\n"
-"			if (!first) result = result + \", \"\n"
+"			if (!first) result.add(\", \")\n"
 "			first = false\n"
-"			result = result + key.toString + \": \" + this[key].toString\n"
+"			result.add(key).add(\": \").add(this[key])\n"
 "		}\n"
 "\n"
-"		return result + \"}\"\n"
+"		return result.add(\"}\").toString\n"
 "	}\n"
 "}\n"
 "\n"
@@ -307,15 +321,15 @@ static const char* libSource =
 "\n"
 "	toString {\n"
 "		var first = true\n"
-"		var result = \"{\"\n"
+"		var result = StringBuilder.new().add(\"{\")\n"
 "\n"
 "		for (key in keys) {\n"
-"			if (!first) result = result + \", \"\n"
+"			if (!first) result.add(\", \")\n"
 "			first = false\n"
-"			result = result + key.toString + \": \" + this[key].toString\n"
+"			result.add(key).add(\": \").add(this[key])\n"
 "		}\n"
 "\n"
-"		return result + \"}\"\n"
+"		return result.add(\"}\").toString\n"
 "	}\n"
 "}\n"
 "\n"
@@ -382,6 +396,8 @@ static bool validateIntValue(CardinalVM* vm, Value* args, double value, const ch
 // Validates that the given argument in [args] is an integer. Returns true if
 // it is. If not, reports an error and returns false.
 static bool validateInt(CardinalVM* vm, Value* args, int index, const char* argName) {
+	if (IS_INT(args[index])) return true;
+	
 	// Make sure it's a number first.
 	if (!validateNum(vm, args, index, argName)) return false;
 
@@ -406,24 +422,45 @@ static int validateIndexValue(CardinalVM* vm, Value* args, int count, double val
 	return -1;
 }
 
+// Returns true if [value] can be used as a map key or set element.
+static bool isKeyType(Value value) {
+	return IS_BOOL(value) || IS_CLASS(value) || IS_NULL(value) ||
+	       IS_NUM(value) || IS_RANGE(value) || IS_STRING(value);
+}
+
 // Validates that [key] is a valid object for use as a map key. Returns true if
 // it is. If not, reports an error and returns false.
 static bool validateKey(CardinalVM* vm, Value* args, int index) {
-	Value arg = args[index];
-	if (IS_BOOL(arg) || IS_CLASS(arg) || IS_NULL(arg) ||
-	        IS_NUM(arg) || IS_RANGE(arg) || IS_STRING(arg)) {
-		return true;
-	}
+	if (isKeyType(args[index])) return true;
 
 	args[0] = cardinalNewString(vm, "Key must be a value type.", 25);
 	return false;
 }
 
+// Validates that the argument at [index] can be an element of a set. Returns
+// true if it can. If not, reports an error and returns false.
+static bool validateElement(CardinalVM* vm, Value* args, int index) {
+	if (isKeyType(args[index])) return true;
+
+	args[0] = cardinalNewString(vm, "Element must be a value type.", 29);
+	return false;
+}
+
 
 // Validates that the argument at [argIndex] is an integer within `[0, count)`.
 // Also allows negative indices which map backwards from the end. Returns the
 // valid positive index value. If invalid, reports an error and returns -1.
 static int validateIndex(CardinalVM* vm, Value* args, int count, int argIndex, const char* argName) {
+	// Small integers need no conversion or integer check.
+	if (IS_INT(args[argIndex])) {
+		int64_t index = AS_INT(args[argIndex]);
+		if (index < 0) index += count;
+		if (index >= 0 && index < count) return (int) index;
+		
+		args[0] = OBJ_VAL(cardinalStringConcat(vm, argName, -1, " out of bounds.", -1));
+		return -1;
+	}
+	
 	if (!validateNum(vm, args, argIndex, argName)) return -1;
 
 	return validateIndexValue(vm, args, count, AS_NUM(args[argIndex]), argName);
@@ -449,6 +486,19 @@ static bool validateException(CardinalVM* vm, Value* args, int index, const char
 	return false;
 }
 
+// Validates that [bytes] more can be allocated within the heap limit of the VM.
+// Returns true if they can. If not, reports an error and returns false. Call it
+// before allocating anything, since it may collect garbage.
+static bool validateMemory(CardinalVM* vm, Value* args, size_t bytes) {
+	if (cardinalReserveMemory(vm, bytes)) return true;
+
+	// Creating the error may exceed the limit again, but that should not fail
+	// the fiber that receives it.
+	args[0] = cardinalNewString(vm, "Out of memory", 13);
+	vm->garbageCollector.outOfMemory = false;
+	return false;
+}
+
 
 // Prepare a function call to execute the function that was given as parameter
 static PrimitiveResult callFunction(CardinalVM* vm, Value* args, int numArgs) {
@@ -685,11 +735,14 @@ static PrimitiveResult callMethodCore(CardinalVM* vm, ObjFiber* fiber, Value* ar
 	Value val = meth->caller;
 	ObjClass* classObj = cardinalGetClassInline(vm, val);
 	
-	Method* method = &classObj->methods.data[meth->symbol];
+	Method* method = cardinalFindMethod(classObj, meth->symbol);
 	
 	//set the stack correctly
 	
-	if (method->type == METHOD_FOREIGN) {
+	if (method == NULL) {
+		RETURN_ERROR("Methodcall is invalid. ");
+	}
+	else if (method->type == METHOD_FOREIGN) {
 		args[0] = val;
 		callForeign(vm, fiber, method->fn.foreign, *numargs);
 		return PRIM_VALUE;
@@ -884,8 +937,10 @@ DEF_NATIVE(class_tradeMethod)
 	
 	if (symbol < 0) RETURN_NULL;
 	
-	Method method = other->methods.data[symbol];
-	cardinalBindMethod(vm, classObj, symbol, method);
+	Method* method = cardinalFindMethod(other, symbol);
+	if (method == NULL) RETURN_NULL;
+	
+	cardinalBindMethod(vm, classObj, symbol, *method);
 	
 	RETURN_OBJ(classObj);
 END_NATIVE
@@ -899,8 +954,10 @@ DEF_NATIVE(class_tradeStaticMethod)
 	
 	if (symbol < 0) RETURN_NULL;
 	
-	Method method = other->methods.data[symbol];
-	cardinalBindMethod(vm, cardinalGetClass(vm, args[0]), symbol, method);
+	Method* method = cardinalFindMethod(other, symbol);
+	if (method == NULL) RETURN_NULL;
+	
+	cardinalBindMethod(vm, cardinalGetClass(vm, args[0]), symbol, *method);
 	
 	RETURN_OBJ(classObj);
 END_NATIVE
@@ -968,8 +1025,11 @@ DEF_NATIVE(object_getAllMethods)
 	
 	ObjClass* type = cardinalGetClassInline(vm, args[0]);
 	
-	for(int i=0; i<type->methods.count; i++) {
-		if (type->methods.data[i].type == METHOD_NONE)
+	// Inherited methods are listed as well.
+	for(int i=0; i<vm->methodNames.count; i++) {
+		int adj = 0;
+		Method* method = cardinalGetMethod(vm, type, i, adj);
+		if (method == NULL || method->type == METHOD_NONE)
 			continue;
 		ObjMethod* meth = cardinalNewMethod(vm);
 		Value name = cardinalNewString(vm, vm->methodNames.data[i].buffer, vm->methodNames.data[i].length);
@@ -997,7 +1057,7 @@ DEF_NATIVE(string_contains)
 	ObjString* string = AS_STRING(args[0]);
 	ObjString* search = AS_STRING(args[1]);
 
-	RETURN_BOOL(cardinalStringFind(vm, string, search) != UINT32_MAX);
+	RETURN_BOOL(cardinalStringFind(vm, string, search, 0) != UINT32_MAX);
 END_NATIVE
 
 DEF_NATIVE(string_count)
@@ -1026,11 +1086,135 @@ DEF_NATIVE(string_indexOf)
 	ObjString* string = AS_STRING(args[0]);
 	ObjString* search = AS_STRING(args[1]);
 
-	uint32_t index = cardinalStringFind(vm, string, search);
+	uint32_t index = cardinalStringFind(vm, string, search, 0);
+
+	RETURN_NUM(index == UINT32_MAX ? -1 : (int)index);
+END_NATIVE
+
+DEF_NATIVE(string_indexOfStart)
+	if (!validateString(vm, args, 1, "Argument")) return PRIM_ERROR;
+
+	ObjString* string = AS_STRING(args[0]);
+	ObjString* search = AS_STRING(args[1]);
+
+	// The start may be the end of the string, where only an empty string is
+	// found.
+	int start = validateIndex(vm, args, string->length + 1, 2, "Start");
+	if (start == -1) return PRIM_ERROR;
+
+	uint32_t index = cardinalStringFind(vm, string, search, start);
 
 	RETURN_NUM(index == UINT32_MAX ? -1 : (int)index);
 END_NATIVE
 
+DEF_NATIVE(string_split)
+	if (!validateString(vm, args, 1, "Separator")) return PRIM_ERROR;
+
+	ObjString* string = AS_STRING(args[0]);
+	ObjString* separator = AS_STRING(args[1]);
+	if (separator->length == 0) RETURN_ERROR("Separator cannot be empty.");
+
+	ObjList* result = cardinalNewList(vm, 0);
+	CARDINAL_PIN(vm, result);
+
+	// Every separator ends a part, and the rest of the string is the last one.
+	uint32_t start = 0;
+	for (;;) {
+		uint32_t index = cardinalStringFind(vm, string, separator, start);
+		uint32_t end = index == UINT32_MAX ? string->length : index;
+		cardinalListAdd(vm, result, cardinalNewString(vm, string->value + start, end - start));
+
+		if (index == UINT32_MAX) break;
+		start = index + separator->length;
+	}
+
+	CARDINAL_UNPIN(vm);
+	RETURN_OBJ(result);
+END_NATIVE
+
+DEF_NATIVE(string_replace)
+	if (!validateString(vm, args, 1, "From")) return PRIM_ERROR;
+	if (!validateString(vm, args, 2, "To")) return PRIM_ERROR;
+
+	ObjString* string = AS_STRING(args[0]);
+	ObjString* from = AS_STRING(args[1]);
+	ObjString* to = AS_STRING(args[2]);
+	if (from->length == 0) RETURN_ERROR("From cannot be empty.");
+
+	// Find every match first, so the result can be allocated at its final size.
+	IntBuffer matches;
+	cardinalIntBufferInit(vm, &matches);
+
+	uint32_t start = 0;
+	for (;;) {
+		uint32_t index = cardinalStringFind(vm, string, from, start);
+		if (index == UINT32_MAX) break;
+
+		cardinalIntBufferWrite(vm, &matches, (int) index);
+		start = index + from->length;
+	}
+
+	if (matches.count == 0) RETURN_VAL(args[0]);
+
+	size_t length = string->length + (size_t) matches.count * to->length -
+	                (size_t) matches.count * from->length;
+	if (!validateMemory(vm, args, length)) {
+		cardinalIntBufferClear(vm, &matches);
+		return PRIM_ERROR;
+	}
+	ObjString* result = AS_STRING(cardinalNewUninitializedString(vm, length));
+
+	// Copy the text before every match, followed by the replacement.
+	char* out = result->value;
+	start = 0;
+	for (int i = 0; i < matches.count; i++) {
+		uint32_t index = (uint32_t) matches.data[i];
+		memcpy(out, string->value + start, index - start);
+		out += index - start;
+		memcpy(out, to->value, to->length);
+		out += to->length;
+		start = index + from->length;
+	}
+	memcpy(out, string->value + start, string->length - start);
+
+	cardinalIntBufferClear(vm, &matches);
+	RETURN_OBJ(result);
+END_NATIVE
+
+// Returns true if [c] is a whitespace character.
+static bool isWhitespace(char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Returns [string] without the whitespace at its start if [start] is true, and
+// at its end if [end] is true. Returns [string] itself if there is none.
+static Value trimString(CardinalVM* vm, ObjString* string, bool start, bool end) {
+	int first = 0;
+	int last = string->length;
+
+	if (start) {
+		while (first < last && isWhitespace(string->value[first])) first++;
+	}
+	if (end) {
+		while (last > first && isWhitespace(string->value[last - 1])) last--;
+	}
+
+	if (first == 0 && last == string->length) return OBJ_VAL(string);
+	return cardinalNewString(vm, string->value + first, last - first);
+}
+
+DEF_NATIVE(string_trim)
+	RETURN_VAL(trimString(vm, AS_STRING(args[0]), true, true));
+END_NATIVE
+
+DEF_NATIVE(string_trimStart)
+	RETURN_VAL(trimString(vm, AS_STRING(args[0]), true, false));
+END_NATIVE
+
+DEF_NATIVE(string_trimEnd)
+	RETURN_VAL(trimString(vm, AS_STRING(args[0]), false, true));
+END_NATIVE
+
 DEF_NATIVE(string_iterate)
 	ObjString* string = AS_STRING(args[0]);
 
@@ -1045,6 +1229,12 @@ DEF_NATIVE(string_iterate)
 	int index = (int)AS_NUM(args[1]);
 	if (index < 0) RETURN_FALSE;
 
+	// In an ASCII string every byte is a code point.
+	if (cardinalStringIsAscii(string)) {
+		if (index + 1 >= string->length) RETURN_FALSE;
+		RETURN_NUM(index + 1);
+	}
+
 	// Advance to the beginning of the next UTF-8 sequence.
 	do {
 		index++;
@@ -1083,6 +1273,7 @@ DEF_NATIVE(string_plus)
 	if (!validateString(vm, args, 1, "Right operand")) return PRIM_ERROR;
 	ObjString* left = AS_STRING(args[0]);
 	ObjString* right = AS_STRING(args[1]);
+	if (!validateMemory(vm, args, (size_t) left->length + right->length)) return PRIM_ERROR;
 	RETURN_OBJ(cardinalStringConcat(vm, left->value, left->length,
 							  right->value, right->length));
 END_NATIVE
@@ -1111,7 +1302,6 @@ DEF_NATIVE(string_subscript)
 		result->value[i] = string->value[start + (i * step)];
 	}
 	result->value[count] = '\0';
-	hashString(result);
 
 	RETURN_OBJ(result);
 END_NATIVE
@@ -1147,6 +1337,8 @@ DEF_NATIVE(string_codePointAt)
 
 	// If we are in the middle of a UTF-8 sequence, indicate that.
 	const uint8_t* bytes = (uint8_t*)string->value;
+	if (cardinalStringIsAscii(string)) RETURN_NUM(bytes[index]);
+
 	if ((bytes[index] & 0xc0) == 0x80) RETURN_NUM(-1);
 
 	// Decode the UTF-8 sequence.
@@ -1155,6 +1347,31 @@ DEF_NATIVE(string_codePointAt)
 END_NATIVE
 
 
+DEF_NATIVE(string_codePointCount)
+	RETURN_NUM(cardinalStringCodePointCount(AS_STRING(args[0])));
+END_NATIVE
+
+// Returns the code point at a code point index, where [string_subscript] uses a
+// byte index.
+DEF_NATIVE(string_charAt)
+	ObjString* string = AS_STRING(args[0]);
+
+	int index = validateIndex(vm, args, cardinalStringCodePointCount(string), 1, "Index");
+	if (index == -1) return PRIM_ERROR;
+
+	RETURN_VAL(cardinalStringCodePointAt(vm, string, cardinalStringCodePointOffset(vm, string, index)));
+END_NATIVE
+
+DEF_NATIVE(string_byteOffset)
+	ObjString* string = AS_STRING(args[0]);
+
+	// The index may be the number of code points, which is the end of the string.
+	int index = validateIndex(vm, args, cardinalStringCodePointCount(string) + 1, 1, "Index");
+	if (index == -1) return PRIM_ERROR;
+
+	RETURN_NUM(cardinalStringCodePointOffset(vm, string, index));
+END_NATIVE
+
 DEF_NATIVE(string_iterateByte)
 	ObjString* string = AS_STRING(args[0]);
 
@@ -1178,441 +1395,1071 @@ END_NATIVE
 
 
 ///////////////////////////////////////////////////////////////////////////////////
-//// FIBER
+//// STRINGBUILDER
 ///////////////////////////////////////////////////////////////////////////////////
 
-
-DEF_NATIVE(fiber_instantiate)
-	// Return the Fiber class itself. When we then call "new" on it, it will
-	// create the fiber.
-	RETURN_VAL(args[0]);
+DEF_NATIVE(stringBuilder_instantiate)
+	RETURN_OBJ(cardinalNewStringBuilder(vm));
 END_NATIVE
 
-DEF_NATIVE(fiber_new)
-	if (!validateFn(vm, args, 1, "Argument")) return PRIM_ERROR;
-
-	ObjFiber* newFiber = cardinalNewFiber(vm, AS_OBJ(args[1]));
+DEF_NATIVE(stringBuilder_addString)
+	if (!validateString(vm, args, 1, "Argument")) return PRIM_ERROR;
 
-	// The compiler expects the first slot of a function to hold the receiver.
-	// Since a fiber's stack is invoked directly, it doesn't have one, so put it
-	newFiber->stack[0] = NULL_VAL;
-	newFiber->stacktop++;
+	ObjString* string = AS_STRING(args[1]);
+	ObjStringBuilder* builder = AS_STRINGBUILDER(args[0]);
+	size_t growth = cardinalStringBuilderCapacity(builder, string->length) - builder->capacity;
+	if (!validateMemory(vm, args, growth)) return PRIM_ERROR;
 
-	RETURN_OBJ(newFiber);
+	cardinalStringBuilderAdd(vm, builder, string->value, string->length);
+	RETURN_VAL(args[0]);
 END_NATIVE
 
-// Defines a tostring function on fn type
-DEF_NATIVE(fiber_toString)
-	RETURN_VAL(cardinalNewString(vm, "<fiber>", 7));
+DEF_NATIVE(stringBuilder_count)
+	RETURN_NUM(AS_STRINGBUILDER(args[0])->length);
 END_NATIVE
 
-DEF_NATIVE(fiber_abort)
-	if (!validateString(vm, args, 1, "Error message")) return PRIM_ERROR;
+DEF_NATIVE(stringBuilder_clear)
+	ObjStringBuilder* builder = AS_STRINGBUILDER(args[0]);
+	DEALLOCATE(vm, builder->buffer);
+	builder->buffer = NULL;
+	builder->length = 0;
+	builder->capacity = 0;
+	RETURN_VAL(args[0]);
+END_NATIVE
 
-	// Move the error message to the return position.
-	args[0] = args[1];
-	return PRIM_ERROR;
+DEF_NATIVE(stringBuilder_toString)
+	if (!validateMemory(vm, args, AS_STRINGBUILDER(args[0])->length)) return PRIM_ERROR;
+	RETURN_VAL(cardinalStringBuilderToString(vm, AS_STRINGBUILDER(args[0])));
 END_NATIVE
 
-DEF_NATIVE(fiber_throw)
-	if (!validateException(vm, args, 1, "Error message")) return PRIM_ERROR;
+///////////////////////////////////////////////////////////////////////////////////
+//// TYPEDARRAY
+///////////////////////////////////////////////////////////////////////////////////
 
-	// Move the error message to the return position.
-	args[0] = args[1];
-	return PRIM_ERROR;
-END_NATIVE
+// Creates a new typed array of [type] with the number of elements in args[1].
+static PrimitiveResult newTypedArray(CardinalVM* vm, Value* args, CardinalArrayType type) {
+	if (!validateInt(vm, args, 1, "Count")) return PRIM_ERROR;
+	if (AS_NUM(args[1]) < 0) RETURN_ERROR("Count cannot be negative.");
+	if (AS_NUM(args[1]) > TYPED_ARRAY_MAX_COUNT) RETURN_ERROR("Count is too large.");
 
-DEF_NATIVE(fiber_call)
-	ObjFiber* runFiber = AS_FIBER(args[0]);
+	size_t bytes = (size_t) AS_NUM(args[1]) * cardinalTypedArrayElementSize(type);
+	if (!validateMemory(vm, args, bytes)) return PRIM_ERROR;
 
-	if (runFiber->numFrames == 0) RETURN_ERROR("Cannot call a finished fiber.");
-	if (runFiber->caller != NULL) RETURN_ERROR("Fiber has already been called.");
+	RETURN_OBJ(cardinalNewTypedArray(vm, type, (uint32_t) AS_NUM(args[1])));
+}
 
-	// Remember who ran it.
-	runFiber->caller = fiber;
-	runFiber->yielded = false;
+DEF_NATIVE(typedArray_newFloat64)
+	return newTypedArray(vm, args, CARDINAL_ARRAY_FLOAT64);
+END_NATIVE
 
-	// If the fiber was yielded, make the yield call return null.
-	if (runFiber->stacktop > runFiber->stack) {
-		*(runFiber->stacktop - 1) = NULL_VAL;
-	}
+DEF_NATIVE(typedArray_newInt32)
+	return newTypedArray(vm, args, CARDINAL_ARRAY_INT32);
+END_NATIVE
 
-	return PRIM_RUN_FIBER;
+DEF_NATIVE(typedArray_newByte)
+	return newTypedArray(vm, args, CARDINAL_ARRAY_BYTE);
 END_NATIVE
 
-static PrimitiveResult callFiber(CardinalVM* vm, ObjFiber* fiber, Value* args, int numargs) {
-	ObjFiber* runFiber = AS_FIBER(args[0]);
+DEF_NATIVE(typedArray_count)
+	RETURN_NUM(AS_TYPEDARRAY(args[0])->count);
+END_NATIVE
 
-	if (runFiber->numFrames == 0) RETURN_ERROR("Cannot call a finished fiber.");
-	if (runFiber->caller != NULL) RETURN_ERROR("Fiber has already been called.");
+DEF_NATIVE(typedArray_subscript)
+	ObjTypedArray* array = AS_TYPEDARRAY(args[0]);
 
-	// Remember who ran it.
-	runFiber->caller = fiber;
+	if (IS_NUM(args[1])) {
+		int index = validateIndex(vm, args, array->count, 1, "Subscript");
+		if (index == -1) return PRIM_ERROR;
 
-	// If the fiber was yielded, make the yield call return the value passed to
-	// run.
-	if (runFiber->yielded) {
-		if (numargs > 1)
-			RETURN_ERROR("Fiber only accepts 1 parameter after it has been yielded.");
-		*(runFiber->stacktop - 1) = args[1];
-		runFiber->yielded = false;
-	}
-	else {
-		int i = 1;
-		while (i <= numargs) {
-			*(runFiber->stacktop + i - 1) = args[i];
-			i++;
-		}
-		runFiber->stacktop += numargs;
+		RETURN_VAL(cardinalTypedArrayGet(array, index));
 	}
 
-	// When the calling fiber resumes, we'll store the result of the run call
-	// in its stack. Since fiber.run(value) has two arguments (the fiber and the
-	// value) and we only need one slot for the result, discard the other slot
-	// now.
-	fiber->stacktop -= numargs;
-
-	return PRIM_RUN_FIBER;
-}
+	if (!IS_RANGE(args[1])) {
+		RETURN_ERROR("Subscript must be a number or a range.");
+	}
 
-DEF_NATIVE(fiber_call1)
-	return callFiber(vm, fiber, args, 1);
-END_NATIVE
+	// A range creates a view that shares the elements of the array.
+	int step;
+	int count = array->count;
+	int start = calculateRange(vm, args, AS_RANGE(args[1]), &count, &step);
+	if (start == -1) return PRIM_ERROR;
+	if (step < 0 && count > 1) RETURN_ERROR("Range of a view cannot be descending.");
 
-DEF_NATIVE(fiber_call2)
-	return callFiber(vm, fiber, args, 2);
+	RETURN_OBJ(cardinalNewTypedArrayView(vm, array, start, count));
 END_NATIVE
 
-DEF_NATIVE(fiber_call3)
-	return callFiber(vm, fiber, args, 3);
-END_NATIVE
+DEF_NATIVE(typedArray_subscriptSetter)
+	ObjTypedArray* array = AS_TYPEDARRAY(args[0]);
+	int index = validateIndex(vm, args, array->count, 1, "Subscript");
+	if (index == -1) return PRIM_ERROR;
+	if (!validateNum(vm, args, 2, "Value")) return PRIM_ERROR;
 
-DEF_NATIVE(fiber_call4)
-	return callFiber(vm, fiber, args, 4);
+	cardinalTypedArraySet(array, index, AS_NUM(args[2]));
+	RETURN_VAL(args[2]);
 END_NATIVE
 
-DEF_NATIVE(fiber_call5)
-	return callFiber(vm, fiber, args, 5);
-END_NATIVE
+DEF_NATIVE(typedArray_fill)
+	if (!validateNum(vm, args, 1, "Value")) return PRIM_ERROR;
 
-DEF_NATIVE(fiber_call6)
-	return callFiber(vm, fiber, args, 6);
+	cardinalTypedArrayFill(AS_TYPEDARRAY(args[0]), AS_NUM(args[1]));
+	RETURN_VAL(args[0]);
 END_NATIVE
 
-DEF_NATIVE(fiber_call7)
-	return callFiber(vm, fiber, args, 7);
-END_NATIVE
+DEF_NATIVE(typedArray_copy)
+	ObjTypedArray* array = AS_TYPEDARRAY(args[0]);
 
-DEF_NATIVE(fiber_call8)
-	return callFiber(vm, fiber, args, 8);
-END_NATIVE
+	// Copies as many elements as both sequences have.
+	if (IS_TYPEDARRAY(args[1])) {
+		ObjTypedArray* source = AS_TYPEDARRAY(args[1]);
+		uint32_t count = source->count < array->count ? source->count : array->count;
+		cardinalTypedArrayCopy(array, source, count);
+		RETURN_VAL(args[0]);
+	}
 
-DEF_NATIVE(fiber_call9)
-	return callFiber(vm, fiber, args, 9);
-END_NATIVE
+	if (!IS_LIST(args[1])) {
+		RETURN_ERROR("Source must be a typed array or a list.");
+	}
 
-DEF_NATIVE(fiber_call10)
-	return callFiber(vm, fiber, args, 10);
+	ObjList* list = AS_LIST(args[1]);
+	uint32_t count = (uint32_t) list->count < array->count ? (uint32_t) list->count : array->count;
+	for (uint32_t i = 0; i < count; i++) {
+		if (!IS_NUM(list->elements[i])) RETURN_ERROR("Source must only contain numbers.");
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		cardinalTypedArraySet(array, i, AS_NUM(list->elements[i]));
+	}
+	RETURN_VAL(args[0]);
 END_NATIVE
 
-DEF_NATIVE(fiber_call11)
-	return callFiber(vm, fiber, args, 11);
-END_NATIVE
+DEF_NATIVE(typedArray_iterate)
+	ObjTypedArray* array = AS_TYPEDARRAY(args[0]);
 
-DEF_NATIVE(fiber_call12)
-	return callFiber(vm, fiber, args, 12);
-END_NATIVE
+	// If we're starting the iteration, return the first index.
+	if (IS_NULL(args[1])) {
+		if (array->count == 0) RETURN_FALSE;
+		RETURN_NUM(0);
+	}
 
-DEF_NATIVE(fiber_call13)
-	return callFiber(vm, fiber, args, 13);
-END_NATIVE
+	if (!validateInt(vm, args, 1, "Iterator")) return PRIM_ERROR;
 
-DEF_NATIVE(fiber_call14)
-	return callFiber(vm, fiber, args, 14);
-END_NATIVE
+	double index = AS_NUM(args[1]);
 
-DEF_NATIVE(fiber_call15)
-	return callFiber(vm, fiber, args, 15);
-END_NATIVE
+	// Stop if we're out of bounds.
+	if (index < 0 || index >= (double) array->count - 1) RETURN_FALSE;
 
-DEF_NATIVE(fiber_call16)
-	return callFiber(vm, fiber, args, 16);
+	// Otherwise, move to the next index.
+	RETURN_NUM(index + 1);
 END_NATIVE
 
-DEF_NATIVE(fiber_error)
-	ObjFiber* runFiber = AS_FIBER(args[0]);
-	if (runFiber->error == NULL) RETURN_NULL;
-	RETURN_OBJ(runFiber->error);
-END_NATIVE
+DEF_NATIVE(typedArray_iteratorValue)
+	ObjTypedArray* array = AS_TYPEDARRAY(args[0]);
+	int index = validateIndex(vm, args, array->count, 1, "Iterator");
+	if (index == -1) return PRIM_ERROR;
 
-DEF_NATIVE(fiber_isDone)
-	ObjFiber* runFiber = AS_FIBER(args[0]);
-	RETURN_BOOL(runFiber->numFrames == 0 || runFiber->error != NULL);
+	RETURN_VAL(cardinalTypedArrayGet(array, index));
 END_NATIVE
 
-static PrimitiveResult runFiber(CardinalVM* vm, ObjFiber* fiber, Value* args, int numargs) {
-	ObjFiber* runFiber = AS_FIBER(args[0]);
+///////////////////////////////////////////////////////////////////////////////////
+//// TYPEDARRAY KERNELS
+///////////////////////////////////////////////////////////////////////////////////
 
-	if (runFiber->numFrames == 0) RETURN_ERROR("Cannot call a finished fiber.");
+// The element-wise operations of the bulk kernels.
+typedef enum {
+	KERNEL_ADD,
+	KERNEL_SUB,
+	KERNEL_MUL,
+	KERNEL_FMA,
+	KERNEL_LERP
+} KernelOp;
+
+// A source of a bulk kernel: a typed array, a list of numbers or a number that
+// is used for every element.
+typedef struct {
+	/// The typed array, or NULL
+	ObjTypedArray* array;
+
+	/// The list, or NULL
+	ObjList* list;
+
+	/// The elements as doubles if they can be read directly, or NULL
+	const double* data;
+
+	/// A copy of the elements owned by the operand, or NULL
+	double* copy;
+
+	/// The number that is used if the operand is not a sequence
+	double value;
+} KernelOperand;
+
+// Validates that the argument at [index] can be a source of a kernel over
+// [count] elements and stores it in [operand]. Reports an error and returns
+// false if it cannot.
+static bool validateOperand(CardinalVM* vm, Value* args, int index, uint32_t count,
+                            KernelOperand* operand, const char* argName) {
+	operand->array = NULL;
+	operand->list = NULL;
+	operand->data = NULL;
+	operand->copy = NULL;
+	operand->value = 0;
+
+	if (IS_NUM(args[index])) {
+		operand->value = AS_NUM(args[index]);
+		return true;
+	}
 
-	// If the fiber was yielded, make the yield call return the value passed to
-	// run.
-	if (runFiber->yielded) {
-		if (numargs > 1)
-			RETURN_ERROR("Fiber only accepts 1 parameter after it has been yielded.");
-		*(runFiber->stacktop - 1) = args[1];
-		runFiber->yielded = false;
+	if (IS_TYPEDARRAY(args[index])) {
+		operand->array = AS_TYPEDARRAY(args[index]);
+		if (operand->array->count != count) {
+			args[0] = OBJ_VAL(cardinalStringConcat(vm, argName, -1,
+			                  " must have as many elements as the receiver.", -1));
+			return false;
+		}
+		if (operand->array->type == CARDINAL_ARRAY_FLOAT64) {
+			operand->data = (const double*) operand->array->data;
+		}
+		return true;
 	}
-	else {
-		int i = 1;
-		while (i <= numargs) {
-			*(runFiber->stacktop + i - 1) = args[i];
-			i++;
+
+	if (IS_LIST(args[index])) {
+		operand->list = AS_LIST(args[index]);
+		if ((uint32_t) operand->list->count != count) {
+			args[0] = OBJ_VAL(cardinalStringConcat(vm, argName, -1,
+			                  " must have as many elements as the receiver.", -1));
+			return false;
 		}
-		runFiber->stacktop += numargs;
+		for (int i = 0; i < operand->list->count; i++) {
+			if (IS_NUM(operand->list->elements[i])) continue;
+
+			args[0] = OBJ_VAL(cardinalStringConcat(vm, argName, -1,
+			                  " must only contain numbers.", -1));
+			return false;
+		}
+		return true;
 	}
 
-	// When the calling fiber resumes, we'll store the result of the run call
-	// in its stack. Since fiber.run(value) has two arguments (the fiber and the
-	// value) and we only need one slot for the result, discard the other slot
-	// now.
-	fiber->stacktop -= numargs;
-	
-	// Unlike run, this does not remember the calling fiber. Instead, it
-	// remember's *that* fiber's caller. You can think of it like tail call
-	// elimination. The switched-from fiber is discarded and when the switched
-	// to fiber completes or yields, control passes to the switched-from fiber's
-	// caller.
-	runFiber->caller = fiber->caller;
+	args[0] = OBJ_VAL(cardinalStringConcat(vm, argName, -1,
+	                  " must be a number, a typed array or a list.", -1));
+	return false;
+}
 
-	return PRIM_RUN_FIBER;
+// Returns element [index] of [operand].
+static inline double operandAt(const KernelOperand* operand, uint32_t index) {
+	if (operand->data != NULL) return operand->data[index];
+	if (operand->array != NULL) return AS_NUM(cardinalTypedArrayGet(operand->array, index));
+	if (operand->list != NULL) return AS_NUM(operand->list->elements[index]);
+	return operand->value;
 }
 
-DEF_NATIVE(fiber_run)
-	ObjFiber* runFiber = AS_FIBER(args[0]);
+// A kernel may write [dst] while it still reads [operand]. That is only safe if
+// they are the same elements or do not share any. Otherwise the elements of
+// [operand] are copied first.
+static void separateOperand(CardinalVM* vm, ObjTypedArray* dst, KernelOperand* operand) {
+	ObjTypedArray* array = operand->array;
+	if (array == NULL || array->count == 0) return;
+
+	// The elements are only the same if they start at the same byte of the
+	// buffer and have the same type. [data] already includes the byte offset of
+	// a view.
+	if (array->data == dst->data && array->type == dst->type) return;
+
+	size_t elementSize = cardinalTypedArrayElementSize(array->type);
+	uint8_t* end = array->data + array->count * elementSize;
+	uint8_t* dstEnd = dst->data + dst->count * cardinalTypedArrayElementSize(dst->type);
+	if (end <= dst->data || dstEnd <= array->data) return;
+
+	operand->copy = ALLOCATE_ARRAY(vm, double, array->count);
+	for (uint32_t i = 0; i < array->count; i++) {
+		operand->copy[i] = AS_NUM(cardinalTypedArrayGet(array, i));
+	}
+	operand->data = operand->copy;
+}
 
-	if (runFiber->numFrames == 0) RETURN_ERROR("Cannot run a finished fiber.");
+// Returns [dst]'s elements as doubles if the kernel can write them directly,
+// or NULL.
+static inline double* kernelDestination(ObjTypedArray* dst) {
+	if (dst->type != CARDINAL_ARRAY_FLOAT64) return NULL;
+	return (double*) dst->data;
+}
 
-	// If the fiber was yielded, make the yield call return null.
-	if (runFiber->caller == NULL && runFiber->stacktop > runFiber->stack) {
-		*(runFiber->stacktop - 1) = NULL_VAL;
+// Applies [op] to the sources [a], [b] and [c] and writes the results to [dst].
+// Float64 arrays and numbers run through the vectorized kernels, every other
+// combination through a plain loop that converts each element.
+static void runKernel(CardinalVM* vm, KernelOp op, ObjTypedArray* dst,
+                      KernelOperand* a, KernelOperand* b, KernelOperand* c) {
+	separateOperand(vm, dst, a);
+	separateOperand(vm, dst, b);
+	if (c != NULL) separateOperand(vm, dst, c);
+
+	double* out = kernelDestination(dst);
+	bool bIsSequence = b->array != NULL || b->list != NULL;
+	bool vectorized = out != NULL && a->data != NULL && (b->data != NULL || !bIsSequence);
+
+	if (vectorized) {
+		switch (op) {
+			case KERNEL_ADD: cardinalSimdAdd(out, a->data, b->data, b->value, dst->count); break;
+			case KERNEL_SUB: cardinalSimdSub(out, a->data, b->data, b->value, dst->count); break;
+			case KERNEL_MUL: cardinalSimdMul(out, a->data, b->data, b->value, dst->count); break;
+			case KERNEL_LERP:
+				cardinalSimdLerp(out, a->data, b->data, b->value, c->value, dst->count);
+				break;
+			case KERNEL_FMA:
+				// A number to add becomes a second pass over the products.
+				if (c->data != NULL) {
+					cardinalSimdFma(out, a->data, b->data, b->value, c->data, dst->count);
+				}
+				else if (c->array == NULL && c->list == NULL) {
+					cardinalSimdMul(out, a->data, b->data, b->value, dst->count);
+					cardinalSimdAdd(out, out, NULL, c->value, dst->count);
+				}
+				else {
+					vectorized = false;
+				}
+				break;
+			default: UNREACHABLE("kernel");
+		}
 	}
 
-	// Unlike run, this does not remember the calling fiber. Instead, it
-	// remember's *that* fiber's caller. You can think of it like tail call
-	// elimination. The switched-from fiber is discarded and when the switched
-	// to fiber completes or yields, control passes to the switched-from fiber's
-	// caller.
-	runFiber->caller = fiber->caller;
-	runFiber->yielded = false;
+	if (!vectorized) {
+		for (uint32_t i = 0; i < dst->count; i++) {
+			double x = operandAt(a, i);
+			double y = operandAt(b, i);
+			double result;
+			switch (op) {
+				case KERNEL_ADD: result = x + y; break;
+				case KERNEL_SUB: result = x - y; break;
+				case KERNEL_MUL: result = x * y; break;
+				case KERNEL_FMA: result = x * y + operandAt(c, i); break;
+				case KERNEL_LERP: result = x + (y - x) * c->value; break;
+				default: UNREACHABLE("kernel"); result = 0; break;
+			}
+			cardinalTypedArraySet(dst, i, result);
+		}
+	}
 
-	return PRIM_RUN_FIBER;
-END_NATIVE
+	if (a->copy != NULL) DEALLOCATE(vm, a->copy);
+	if (b->copy != NULL) DEALLOCATE(vm, b->copy);
+	if (c != NULL && c->copy != NULL) DEALLOCATE(vm, c->copy);
+}
 
-DEF_NATIVE(fiber_run1)
-	return runFiber(vm, fiber, args, 1);
-END_NATIVE
+// Runs the element-wise operation [op] with [arity] sources on the receiver.
+// If the method takes one argument less than [arity], the receiver is also the
+// first source. Otherwise the first argument is, and the receiver only
+// receives the results. The third source of lerp has to be a number.
+static PrimitiveResult kernelNative(CardinalVM* vm, Value* args, KernelOp op, int numArgs, int arity) {
+	ObjTypedArray* dst = AS_TYPEDARRAY(args[0]);
+	int first = numArgs - arity + 1;
+
+	KernelOperand a, b, c;
+	if (!validateOperand(vm, args, first, dst->count, &a, "Source")) return PRIM_ERROR;
+	if (!validateOperand(vm, args, first + 1, dst->count, &b, "Operand")) return PRIM_ERROR;
+
+	KernelOperand* third = NULL;
+	if (arity == 3) {
+		if (op == KERNEL_LERP) {
+			if (!validateNum(vm, args, first + 2, "Amount")) return PRIM_ERROR;
+			c.array = NULL;
+			c.list = NULL;
+			c.data = NULL;
+			c.copy = NULL;
+			c.value = AS_NUM(args[first + 2]);
+		}
+		else if (!validateOperand(vm, args, first + 2, dst->count, &c, "Addend")) {
+			return PRIM_ERROR;
+		}
+		third = &c;
+	}
 
-DEF_NATIVE(fiber_run2)
-	return runFiber(vm, fiber, args, 2);
-END_NATIVE
+	runKernel(vm, op, dst, &a, &b, third);
+	RETURN_VAL(args[0]);
+}
 
-DEF_NATIVE(fiber_run3)
-	return runFiber(vm, fiber, args, 3);
+DEF_NATIVE(typedArray_add)
+	return kernelNative(vm, args, KERNEL_ADD, 1, 2);
 END_NATIVE
 
-DEF_NATIVE(fiber_run4)
-	return runFiber(vm, fiber, args, 4);
+DEF_NATIVE(typedArray_addInto)
+	return kernelNative(vm, args, KERNEL_ADD, 2, 2);
 END_NATIVE
 
-DEF_NATIVE(fiber_run5)
-	return runFiber(vm, fiber, args, 5);
+DEF_NATIVE(typedArray_sub)
+	return kernelNative(vm, args, KERNEL_SUB, 1, 2);
 END_NATIVE
 
-DEF_NATIVE(fiber_run6)
-	return runFiber(vm, fiber, args, 6);
+DEF_NATIVE(typedArray_subInto)
+	return kernelNative(vm, args, KERNEL_SUB, 2, 2);
 END_NATIVE
 
-DEF_NATIVE(fiber_run7)
-	return runFiber(vm, fiber, args, 7);
+DEF_NATIVE(typedArray_mul)
+	return kernelNative(vm, args, KERNEL_MUL, 1, 2);
 END_NATIVE
 
-DEF_NATIVE(fiber_run8)
-	return runFiber(vm, fiber, args, 8);
+DEF_NATIVE(typedArray_mulInto)
+	return kernelNative(vm, args, KERNEL_MUL, 2, 2);
 END_NATIVE
 
-DEF_NATIVE(fiber_run9)
-	return runFiber(vm, fiber, args, 9);
+DEF_NATIVE(typedArray_scale)
+	if (!validateNum(vm, args, 1, "Factor")) return PRIM_ERROR;
+	return kernelNative(vm, args, KERNEL_MUL, 1, 2);
 END_NATIVE
 
-DEF_NATIVE(fiber_run10)
-	return runFiber(vm, fiber, args, 10);
+DEF_NATIVE(typedArray_scaleInto)
+	if (!validateNum(vm, args, 2, "Factor")) return PRIM_ERROR;
+	return kernelNative(vm, args, KERNEL_MUL, 2, 2);
 END_NATIVE
 
-DEF_NATIVE(fiber_run11)
-	return runFiber(vm, fiber, args, 11);
+DEF_NATIVE(typedArray_fma)
+	return kernelNative(vm, args, KERNEL_FMA, 2, 3);
 END_NATIVE
 
-DEF_NATIVE(fiber_run12)
-	return runFiber(vm, fiber, args, 12);
+DEF_NATIVE(typedArray_fmaInto)
+	return kernelNative(vm, args, KERNEL_FMA, 3, 3);
 END_NATIVE
 
-DEF_NATIVE(fiber_run13)
-	return runFiber(vm, fiber, args, 13);
+DEF_NATIVE(typedArray_lerp)
+	return kernelNative(vm, args, KERNEL_LERP, 2, 3);
 END_NATIVE
 
-DEF_NATIVE(fiber_run14)
-	return runFiber(vm, fiber, args, 14);
+DEF_NATIVE(typedArray_lerpInto)
+	return kernelNative(vm, args, KERNEL_LERP, 3, 3);
 END_NATIVE
 
-DEF_NATIVE(fiber_run15)
-	return runFiber(vm, fiber, args, 15);
-END_NATIVE
+// Clamps the elements of [a] to the range in [low] and [high] and writes them
+// to [dst].
+static PrimitiveResult clampNative(CardinalVM* vm, Value* args, int a, int low, int high) {
+	ObjTypedArray* dst = AS_TYPEDARRAY(args[0]);
+	KernelOperand source;
+	if (!validateOperand(vm, args, a, dst->count, &source, "Source")) return PRIM_ERROR;
+	if (!validateNum(vm, args, low, "Minimum")) return PRIM_ERROR;
+	if (!validateNum(vm, args, high, "Maximum")) return PRIM_ERROR;
 
-DEF_NATIVE(fiber_run16)
-	return runFiber(vm, fiber, args, 16);
-END_NATIVE
+	double lowValue = AS_NUM(args[low]);
+	double highValue = AS_NUM(args[high]);
+	separateOperand(vm, dst, &source);
 
-DEF_NATIVE(fiber_try)
-	ObjFiber* runFiber = AS_FIBER(args[0]);
+	double* out = kernelDestination(dst);
+	if (out != NULL && source.data != NULL) {
+		cardinalSimdClamp(out, source.data, lowValue, highValue, dst->count);
+	}
+	else {
+		for (uint32_t i = 0; i < dst->count; i++) {
+			double value = operandAt(&source, i);
+			value = value > lowValue ? value : lowValue;
+			cardinalTypedArraySet(dst, i, value < highValue ? value : highValue);
+		}
+	}
 
-	if (runFiber->numFrames == 0) RETURN_ERROR("Cannot try a finished fiber.");
-	if (runFiber->caller != NULL) RETURN_ERROR("Fiber has already been called.");
+	if (source.copy != NULL) DEALLOCATE(vm, source.copy);
+	RETURN_VAL(args[0]);
+}
 
-	// Remember who ran it.
-	runFiber->caller = fiber;
-	runFiber->callerIsTrying = true;
+DEF_NATIVE(typedArray_clamp)
+	return clampNative(vm, args, 0, 1, 2);
+END_NATIVE
 
-	// If the fiber was yielded, make the yield call return null.
-	if (runFiber->stacktop > runFiber->stack) {
-		*(runFiber->stacktop - 1) = NULL_VAL;
+DEF_NATIVE(typedArray_clampInto)
+	return clampNative(vm, args, 1, 2, 3);
+END_NATIVE
+
+DEF_NATIVE(typedArray_sum)
+	ObjTypedArray* array = AS_TYPEDARRAY(args[0]);
+	if (array->type == CARDINAL_ARRAY_FLOAT64) {
+		RETURN_NUM(cardinalSimdSum((const double*) array->data, array->count));
 	}
-	
-	runFiber->yielded = false;
 
-	return PRIM_RUN_FIBER;
+	double sum = 0;
+	for (uint32_t i = 0; i < array->count; i++) {
+		sum += AS_NUM(cardinalTypedArrayGet(array, i));
+	}
+	RETURN_NUM(sum);
 END_NATIVE
 
-static PrimitiveResult tryFiber(CardinalVM* vm, ObjFiber* fiber, Value* args, int numargs) {
-	ObjFiber* runFiber = AS_FIBER(args[0]);
-
-	if (runFiber->numFrames == 0) RETURN_ERROR("Cannot call a finished fiber.");
-	if (runFiber->caller != NULL) RETURN_ERROR("Fiber has already been called.");
+DEF_NATIVE(typedArray_dot)
+	ObjTypedArray* array = AS_TYPEDARRAY(args[0]);
+	KernelOperand other;
+	if (!validateOperand(vm, args, 1, array->count, &other, "Operand")) return PRIM_ERROR;
+	if (other.array == NULL && other.list == NULL) {
+		RETURN_ERROR("Operand must be a typed array or a list.");
+	}
 
-	// If the fiber was yielded, make the yield call return the value passed to
-	// run.
-	if (runFiber->yielded) {
-		if (numargs > 1)
-			RETURN_ERROR("Fiber only accepts 1 parameter after it has been yielded.");
-		*(runFiber->stacktop - 1) = args[1];
-		runFiber->yielded = false;
+	if (array->type == CARDINAL_ARRAY_FLOAT64 && other.data != NULL) {
+		RETURN_NUM(cardinalSimdDot((const double*) array->data, other.data, array->count));
 	}
-	else {
-		int i = 1;
-		while (i <= numargs) {
-			*(runFiber->stacktop + i - 1) = args[i];
-			i++;
-		}
-		runFiber->stacktop += numargs;
+
+	double sum = 0;
+	for (uint32_t i = 0; i < array->count; i++) {
+		sum += AS_NUM(cardinalTypedArrayGet(array, i)) * operandAt(&other, i);
 	}
+	RETURN_NUM(sum);
+END_NATIVE
 
-	// When the calling fiber resumes, we'll store the result of the run call
-	// in its stack. Since fiber.run(value) has two arguments (the fiber and the
-	// value) and we only need one slot for the result, discard the other slot
-	// now.
-	fiber->stacktop -= numargs;
-	
-	// Remember who ran it.
-	runFiber->caller = fiber;
-	runFiber->callerIsTrying = true;
+// Returns the smallest element of the receiver if [smallest] is true, otherwise
+// the largest. Returns null if the array is empty.
+static PrimitiveResult typedArrayExtreme(Value* args, bool smallest) {
+	ObjTypedArray* array = AS_TYPEDARRAY(args[0]);
+	if (array->count == 0) RETURN_NULL;
 
-	return PRIM_RUN_FIBER;
+	if (array->type == CARDINAL_ARRAY_FLOAT64) {
+		const double* data = (const double*) array->data;
+		RETURN_NUM(smallest ? cardinalSimdMin(data, array->count)
+		                    : cardinalSimdMax(data, array->count));
+	}
+
+	double result = AS_NUM(cardinalTypedArrayGet(array, 0));
+	for (uint32_t i = 1; i < array->count; i++) {
+		double value = AS_NUM(cardinalTypedArrayGet(array, i));
+		if (smallest ? value < result : value > result) result = value;
+	}
+	RETURN_NUM(result);
 }
 
-DEF_NATIVE(fiber_try1)
-	return tryFiber(vm, fiber, args, 1);
+DEF_NATIVE(typedArray_min)
+	return typedArrayExtreme(args, true);
 END_NATIVE
 
-DEF_NATIVE(fiber_try2)
-	return tryFiber(vm, fiber, args, 2);
+DEF_NATIVE(typedArray_max)
+	return typedArrayExtreme(args, false);
 END_NATIVE
 
-DEF_NATIVE(fiber_try3)
-	return tryFiber(vm, fiber, args, 3);
-END_NATIVE
+///////////////////////////////////////////////////////////////////////////////////
+//// DEQUE
+///////////////////////////////////////////////////////////////////////////////////
 
-DEF_NATIVE(fiber_try4)
-	return tryFiber(vm, fiber, args, 4);
+DEF_NATIVE(deque_instantiate)
+	RETURN_OBJ(cardinalNewDeque(vm));
 END_NATIVE
 
-DEF_NATIVE(fiber_try5)
-	return tryFiber(vm, fiber, args, 5);
+DEF_NATIVE(deque_pushBack)
+	cardinalDequePushBack(vm, AS_DEQUE(args[0]), args[1]);
+	RETURN_VAL(args[1]);
 END_NATIVE
 
-DEF_NATIVE(fiber_try6)
-	return tryFiber(vm, fiber, args, 6);
+DEF_NATIVE(deque_pushFront)
+	cardinalDequePushFront(vm, AS_DEQUE(args[0]), args[1]);
+	RETURN_VAL(args[1]);
 END_NATIVE
 
-DEF_NATIVE(fiber_try7)
-	return tryFiber(vm, fiber, args, 7);
-END_NATIVE
+DEF_NATIVE(deque_popBack)
+	ObjDeque* deque = AS_DEQUE(args[0]);
+	if (deque->count == 0) RETURN_ERROR("Deque is empty.");
 
-DEF_NATIVE(fiber_try8)
-	return tryFiber(vm, fiber, args, 8);
+	RETURN_VAL(cardinalDequePopBack(deque));
 END_NATIVE
 
-DEF_NATIVE(fiber_try9)
-	return tryFiber(vm, fiber, args, 9);
-END_NATIVE
+DEF_NATIVE(deque_popFront)
+	ObjDeque* deque = AS_DEQUE(args[0]);
+	if (deque->count == 0) RETURN_ERROR("Deque is empty.");
 
-DEF_NATIVE(fiber_try10)
-	return tryFiber(vm, fiber, args, 10);
+	RETURN_VAL(cardinalDequePopFront(deque));
 END_NATIVE
 
-DEF_NATIVE(fiber_try11)
-	return tryFiber(vm, fiber, args, 11);
-END_NATIVE
+DEF_NATIVE(deque_first)
+	ObjDeque* deque = AS_DEQUE(args[0]);
+	if (deque->count == 0) RETURN_ERROR("Deque is empty.");
 
-DEF_NATIVE(fiber_try12)
-	return tryFiber(vm, fiber, args, 12);
+	RETURN_VAL(*cardinalDequeAt(deque, 0));
 END_NATIVE
 
-DEF_NATIVE(fiber_try13)
-	return tryFiber(vm, fiber, args, 13);
+DEF_NATIVE(deque_last)
+	ObjDeque* deque = AS_DEQUE(args[0]);
+	if (deque->count == 0) RETURN_ERROR("Deque is empty.");
+
+	RETURN_VAL(*cardinalDequeAt(deque, deque->count - 1));
 END_NATIVE
 
-DEF_NATIVE(fiber_try14)
-	return tryFiber(vm, fiber, args, 14);
+DEF_NATIVE(deque_count)
+	RETURN_NUM(AS_DEQUE(args[0])->count);
 END_NATIVE
 
-DEF_NATIVE(fiber_try15)
-	return tryFiber(vm, fiber, args, 15);
+DEF_NATIVE(deque_isEmpty)
+	RETURN_BOOL(AS_DEQUE(args[0])->count == 0);
 END_NATIVE
 
-DEF_NATIVE(fiber_try16)
-	return tryFiber(vm, fiber, args, 16);
+DEF_NATIVE(deque_clear)
+	cardinalDequeClear(vm, AS_DEQUE(args[0]));
+	RETURN_NULL;
 END_NATIVE
 
-DEF_NATIVE(fiber_yield)
-	ObjFiber* caller = fiber->caller;
-	fiber->caller = NULL;
-	fiber->callerIsTrying = false;
-	fiber->yielded = true;
+DEF_NATIVE(deque_subscript)
+	ObjDeque* deque = AS_DEQUE(args[0]);
+	int index = validateIndex(vm, args, deque->count, 1, "Subscript");
+	if (index == -1) return PRIM_ERROR;
 
-	// If we don't have any other pending fibers, jump all the way out of the
-	// interpreter.
-	if (caller == NULL) {
-		args[0] = NULL_VAL;
-	}
-	else {
-		// Make the caller's run method return null.
-		*(caller->stacktop - 1) = NULL_VAL;
+	RETURN_VAL(*cardinalDequeAt(deque, index));
+END_NATIVE
 
-		// Return the fiber to resume.
-		args[0] = OBJ_VAL(caller);
-	}
+DEF_NATIVE(deque_subscriptSetter)
+	ObjDeque* deque = AS_DEQUE(args[0]);
+	int index = validateIndex(vm, args, deque->count, 1, "Subscript");
+	if (index == -1) return PRIM_ERROR;
 
-	return PRIM_RUN_FIBER;
+	*cardinalDequeAt(deque, index) = args[2];
+	RETURN_VAL(args[2]);
+END_NATIVE
+
+DEF_NATIVE(deque_iterate)
+	ObjDeque* deque = AS_DEQUE(args[0]);
+
+	// If we're starting the iteration, return the first index.
+	if (IS_NULL(args[1])) {
+		if (deque->count == 0) RETURN_FALSE;
+		RETURN_NUM(0);
+	}
+
+	if (!validateInt(vm, args, 1, "Iterator")) return PRIM_ERROR;
+
+	int index = (int) AS_NUM(args[1]);
+
+	// Stop if we're out of bounds.
+	if (index < 0 || index >= deque->count - 1) RETURN_FALSE;
+
+	// Otherwise, move to the next index.
+	RETURN_NUM((double) index + 1);
+END_NATIVE
+
+DEF_NATIVE(deque_iteratorValue)
+	ObjDeque* deque = AS_DEQUE(args[0]);
+	int index = validateIndex(vm, args, deque->count, 1, "Iterator");
+	if (index == -1) return PRIM_ERROR;
+
+	RETURN_VAL(*cardinalDequeAt(deque, index));
+END_NATIVE
+
+///////////////////////////////////////////////////////////////////////////////////
+//// FIBER
+///////////////////////////////////////////////////////////////////////////////////
+
+
+DEF_NATIVE(fiber_instantiate)
+	// Return the Fiber class itself. When we then call "new" on it, it will
+	// create the fiber.
+	RETURN_VAL(args[0]);
+END_NATIVE
+
+DEF_NATIVE(fiber_new)
+	if (!validateFn(vm, args, 1, "Argument")) return PRIM_ERROR;
+
+	ObjFiber* newFiber = cardinalNewFiber(vm, AS_OBJ(args[1]));
+
+	// The compiler expects the first slot of a function to hold the receiver.
+	// Since a fiber's stack is invoked directly, it doesn't have one, so put it
+	newFiber->stack[0] = NULL_VAL;
+	newFiber->stacktop++;
+
+	RETURN_OBJ(newFiber);
+END_NATIVE
+
+// Defines a tostring function on fn type
+DEF_NATIVE(fiber_toString)
+	RETURN_VAL(cardinalNewString(vm, "<fiber>", 7));
+END_NATIVE
+
+DEF_NATIVE(fiber_abort)
+	if (!validateString(vm, args, 1, "Error message")) return PRIM_ERROR;
+
+	// Move the error message to the return position.
+	args[0] = args[1];
+	return PRIM_ERROR;
+END_NATIVE
+
+DEF_NATIVE(fiber_throw)
+	if (!validateException(vm, args, 1, "Error message")) return PRIM_ERROR;
+
+	// Move the error message to the return position.
+	args[0] = args[1];
+	return PRIM_ERROR;
+END_NATIVE
+
+DEF_NATIVE(fiber_call)
+	ObjFiber* runFiber = AS_FIBER(args[0]);
+
+	if (runFiber->numFrames == 0) RETURN_ERROR("Cannot call a finished fiber.");
+	if (runFiber->caller != NULL) RETURN_ERROR("Fiber has already been called.");
+
+	// Remember who ran it.
+	runFiber->caller = fiber;
+	runFiber->yielded = false;
+
+	// If the fiber was yielded, make the yield call return null.
+	if (runFiber->stacktop > runFiber->stack) {
+		*(runFiber->stacktop - 1) = NULL_VAL;
+	}
+
+	return PRIM_RUN_FIBER;
+END_NATIVE
+
+static PrimitiveResult callFiber(CardinalVM* vm, ObjFiber* fiber, Value* args, int numargs) {
+	ObjFiber* runFiber = AS_FIBER(args[0]);
+
+	if (runFiber->numFrames == 0) RETURN_ERROR("Cannot call a finished fiber.");
+	if (runFiber->caller != NULL) RETURN_ERROR("Fiber has already been called.");
+
+	// Remember who ran it.
+	runFiber->caller = fiber;
+
+	// If the fiber was yielded, make the yield call return the value passed to
+	// run.
+	if (runFiber->yielded) {
+		if (numargs > 1)
+			RETURN_ERROR("Fiber only accepts 1 parameter after it has been yielded.");
+		*(runFiber->stacktop - 1) = args[1];
+		runFiber->yielded = false;
+	}
+	else {
+		int i = 1;
+		while (i <= numargs) {
+			*(runFiber->stacktop + i - 1) = args[i];
+			i++;
+		}
+		runFiber->stacktop += numargs;
+	}
+
+	// When the calling fiber resumes, we'll store the result of the run call
+	// in its stack. Since fiber.run(value) has two arguments (the fiber and the
+	// value) and we only need one slot for the result, discard the other slot
+	// now.
+	fiber->stacktop -= numargs;
+
+	return PRIM_RUN_FIBER;
+}
+
+DEF_NATIVE(fiber_call1)
+	return callFiber(vm, fiber, args, 1);
+END_NATIVE
+
+DEF_NATIVE(fiber_call2)
+	return callFiber(vm, fiber, args, 2);
+END_NATIVE
+
+DEF_NATIVE(fiber_call3)
+	return callFiber(vm, fiber, args, 3);
+END_NATIVE
+
+DEF_NATIVE(fiber_call4)
+	return callFiber(vm, fiber, args, 4);
+END_NATIVE
+
+DEF_NATIVE(fiber_call5)
+	return callFiber(vm, fiber, args, 5);
+END_NATIVE
+
+DEF_NATIVE(fiber_call6)
+	return callFiber(vm, fiber, args, 6);
+END_NATIVE
+
+DEF_NATIVE(fiber_call7)
+	return callFiber(vm, fiber, args, 7);
+END_NATIVE
+
+DEF_NATIVE(fiber_call8)
+	return callFiber(vm, fiber, args, 8);
+END_NATIVE
+
+DEF_NATIVE(fiber_call9)
+	return callFiber(vm, fiber, args, 9);
+END_NATIVE
+
+DEF_NATIVE(fiber_call10)
+	return callFiber(vm, fiber, args, 10);
+END_NATIVE
+
+DEF_NATIVE(fiber_call11)
+	return callFiber(vm, fiber, args, 11);
+END_NATIVE
+
+DEF_NATIVE(fiber_call12)
+	return callFiber(vm, fiber, args, 12);
+END_NATIVE
+
+DEF_NATIVE(fiber_call13)
+	return callFiber(vm, fiber, args, 13);
+END_NATIVE
+
+DEF_NATIVE(fiber_call14)
+	return callFiber(vm, fiber, args, 14);
+END_NATIVE
+
+DEF_NATIVE(fiber_call15)
+	return callFiber(vm, fiber, args, 15);
+END_NATIVE
+
+DEF_NATIVE(fiber_call16)
+	return callFiber(vm, fiber, args, 16);
+END_NATIVE
+
+DEF_NATIVE(fiber_error)
+	ObjFiber* runFiber = AS_FIBER(args[0]);
+	if (runFiber->error == NULL) RETURN_NULL;
+	RETURN_OBJ(runFiber->error);
+END_NATIVE
+
+DEF_NATIVE(fiber_isDone)
+	ObjFiber* runFiber = AS_FIBER(args[0]);
+	RETURN_BOOL(runFiber->numFrames == 0 || runFiber->error != NULL);
+END_NATIVE
+
+static PrimitiveResult runFiber(CardinalVM* vm, ObjFiber* fiber, Value* args, int numargs) {
+	ObjFiber* runFiber = AS_FIBER(args[0]);
+
+	if (runFiber->numFrames == 0) RETURN_ERROR("Cannot call a finished fiber.");
+
+	// If the fiber was yielded, make the yield call return the value passed to
+	// run.
+	if (runFiber->yielded) {
+		if (numargs > 1)
+			RETURN_ERROR("Fiber only accepts 1 parameter after it has been yielded.");
+		*(runFiber->stacktop - 1) = args[1];
+		runFiber->yielded = false;
+	}
+	else {
+		int i = 1;
+		while (i <= numargs) {
+			*(runFiber->stacktop + i - 1) = args[i];
+			i++;
+		}
+		runFiber->stacktop += numargs;
+	}
+
+	// When the calling fiber resumes, we'll store the result of the run call
+	// in its stack. Since fiber.run(value) has two arguments (the fiber and the
+	// value) and we only need one slot for the result, discard the other slot
+	// now.
+	fiber->stacktop -= numargs;
+	
+	// Unlike run, this does not remember the calling fiber. Instead, it
+	// remember's *that* fiber's caller. You can think of it like tail call
+	// elimination. The switched-from fiber is discarded and when the switched
+	// to fiber completes or yields, control passes to the switched-from fiber's
+	// caller.
+	runFiber->caller = fiber->caller;
+
+	return PRIM_RUN_FIBER;
+}
+
+DEF_NATIVE(fiber_run)
+	ObjFiber* runFiber = AS_FIBER(args[0]);
+
+	if (runFiber->numFrames == 0) RETURN_ERROR("Cannot run a finished fiber.");
+
+	// If the fiber was yielded, make the yield call return null.
+	if (runFiber->caller == NULL && runFiber->stacktop > runFiber->stack) {
+		*(runFiber->stacktop - 1) = NULL_VAL;
+	}
+
+	// Unlike run, this does not remember the calling fiber. Instead, it
+	// remember's *that* fiber's caller. You can think of it like tail call
+	// elimination. The switched-from fiber is discarded and when the switched
+	// to fiber completes or yields, control passes to the switched-from fiber's
+	// caller.
+	runFiber->caller = fiber->caller;
+	runFiber->yielded = false;
+
+	return PRIM_RUN_FIBER;
+END_NATIVE
+
+DEF_NATIVE(fiber_run1)
+	return runFiber(vm, fiber, args, 1);
+END_NATIVE
+
+DEF_NATIVE(fiber_run2)
+	return runFiber(vm, fiber, args, 2);
+END_NATIVE
+
+DEF_NATIVE(fiber_run3)
+	return runFiber(vm, fiber, args, 3);
+END_NATIVE
+
+DEF_NATIVE(fiber_run4)
+	return runFiber(vm, fiber, args, 4);
+END_NATIVE
+
+DEF_NATIVE(fiber_run5)
+	return runFiber(vm, fiber, args, 5);
+END_NATIVE
+
+DEF_NATIVE(fiber_run6)
+	return runFiber(vm, fiber, args, 6);
+END_NATIVE
+
+DEF_NATIVE(fiber_run7)
+	return runFiber(vm, fiber, args, 7);
+END_NATIVE
+
+DEF_NATIVE(fiber_run8)
+	return runFiber(vm, fiber, args, 8);
+END_NATIVE
+
+DEF_NATIVE(fiber_run9)
+	return runFiber(vm, fiber, args, 9);
+END_NATIVE
+
+DEF_NATIVE(fiber_run10)
+	return runFiber(vm, fiber, args, 10);
+END_NATIVE
+
+DEF_NATIVE(fiber_run11)
+	return runFiber(vm, fiber, args, 11);
+END_NATIVE
+
+DEF_NATIVE(fiber_run12)
+	return runFiber(vm, fiber, args, 12);
+END_NATIVE
+
+DEF_NATIVE(fiber_run13)
+	return runFiber(vm, fiber, args, 13);
+END_NATIVE
+
+DEF_NATIVE(fiber_run14)
+	return runFiber(vm, fiber, args, 14);
+END_NATIVE
+
+DEF_NATIVE(fiber_run15)
+	return runFiber(vm, fiber, args, 15);
+END_NATIVE
+
+DEF_NATIVE(fiber_run16)
+	return runFiber(vm, fiber, args, 16);
+END_NATIVE
+
+DEF_NATIVE(fiber_try)
+	ObjFiber* runFiber = AS_FIBER(args[0]);
+
+	if (runFiber->numFrames == 0) RETURN_ERROR("Cannot try a finished fiber.");
+	if (runFiber->caller != NULL) RETURN_ERROR("Fiber has already been called.");
+
+	// Remember who ran it.
+	runFiber->caller = fiber;
+	runFiber->callerIsTrying = true;
+
+	// If the fiber was yielded, make the yield call return null.
+	if (runFiber->stacktop > runFiber->stack) {
+		*(runFiber->stacktop - 1) = NULL_VAL;
+	}
+	
+	runFiber->yielded = false;
+
+	return PRIM_RUN_FIBER;
+END_NATIVE
+
+static PrimitiveResult tryFiber(CardinalVM* vm, ObjFiber* fiber, Value* args, int numargs) {
+	ObjFiber* runFiber = AS_FIBER(args[0]);
+
+	if (runFiber->numFrames == 0) RETURN_ERROR("Cannot call a finished fiber.");
+	if (runFiber->caller != NULL) RETURN_ERROR("Fiber has already been called.");
+
+	// If the fiber was yielded, make the yield call return the value passed to
+	// run.
+	if (runFiber->yielded) {
+		if (numargs > 1)
+			RETURN_ERROR("Fiber only accepts 1 parameter after it has been yielded.");
+		*(runFiber->stacktop - 1) = args[1];
+		runFiber->yielded = false;
+	}
+	else {
+		int i = 1;
+		while (i <= numargs) {
+			*(runFiber->stacktop + i - 1) = args[i];
+			i++;
+		}
+		runFiber->stacktop += numargs;
+	}
+
+	// When the calling fiber resumes, we'll store the result of the run call
+	// in its stack. Since fiber.run(value) has two arguments (the fiber and the
+	// value) and we only need one slot for the result, discard the other slot
+	// now.
+	fiber->stacktop -= numargs;
+	
+	// Remember who ran it.
+	runFiber->caller = fiber;
+	runFiber->callerIsTrying = true;
+
+	return PRIM_RUN_FIBER;
+}
+
+DEF_NATIVE(fiber_try1)
+	return tryFiber(vm, fiber, args, 1);
+END_NATIVE
+
+DEF_NATIVE(fiber_try2)
+	return tryFiber(vm, fiber, args, 2);
+END_NATIVE
+
+DEF_NATIVE(fiber_try3)
+	return tryFiber(vm, fiber, args, 3);
+END_NATIVE
+
+DEF_NATIVE(fiber_try4)
+	return tryFiber(vm, fiber, args, 4);
+END_NATIVE
+
+DEF_NATIVE(fiber_try5)
+	return tryFiber(vm, fiber, args, 5);
+END_NATIVE
+
+DEF_NATIVE(fiber_try6)
+	return tryFiber(vm, fiber, args, 6);
+END_NATIVE
+
+DEF_NATIVE(fiber_try7)
+	return tryFiber(vm, fiber, args, 7);
+END_NATIVE
+
+DEF_NATIVE(fiber_try8)
+	return tryFiber(vm, fiber, args, 8);
+END_NATIVE
+
+DEF_NATIVE(fiber_try9)
+	return tryFiber(vm, fiber, args, 9);
+END_NATIVE
+
+DEF_NATIVE(fiber_try10)
+	return tryFiber(vm, fiber, args, 10);
+END_NATIVE
+
+DEF_NATIVE(fiber_try11)
+	return tryFiber(vm, fiber, args, 11);
+END_NATIVE
+
+DEF_NATIVE(fiber_try12)
+	return tryFiber(vm, fiber, args, 12);
+END_NATIVE
+
+DEF_NATIVE(fiber_try13)
+	return tryFiber(vm, fiber, args, 13);
+END_NATIVE
+
+DEF_NATIVE(fiber_try14)
+	return tryFiber(vm, fiber, args, 14);
+END_NATIVE
+
+DEF_NATIVE(fiber_try15)
+	return tryFiber(vm, fiber, args, 15);
+END_NATIVE
+
+DEF_NATIVE(fiber_try16)
+	return tryFiber(vm, fiber, args, 16);
+END_NATIVE
+
+DEF_NATIVE(fiber_yield)
+	ObjFiber* caller = fiber->caller;
+	fiber->caller = NULL;
+	fiber->callerIsTrying = false;
+	fiber->yielded = true;
+
+	// If we don't have any other pending fibers, jump all the way out of the
+	// interpreter.
+	if (caller == NULL) {
+		args[0] = NULL_VAL;
+	}
+	else {
+		// Make the caller's run method return null.
+		*(caller->stacktop - 1) = NULL_VAL;
+
+		// Return the fiber to resume.
+		args[0] = OBJ_VAL(caller);
+	}
+
+	return PRIM_RUN_FIBER;
 END_NATIVE
 
 DEF_NATIVE(fiber_yield1)
@@ -1621,323 +2468,1415 @@ DEF_NATIVE(fiber_yield1)
 	fiber->callerIsTrying = false;
 	fiber->yielded = true;
 
-	// If we don't have any other pending fibers, jump all the way out of the
-	// interpreter.
-	if (caller == NULL) {
-		args[0] = NULL_VAL;
+	// If we don't have any other pending fibers, jump all the way out of the
+	// interpreter.
+	if (caller == NULL) {
+		args[0] = NULL_VAL;
+	}
+	else {
+		// Make the caller's run method return the argument passed to yield.
+		*(caller->stacktop - 1) = args[1];
+
+		// When the yielding fiber resumes, we'll store the result of the yield call
+		// in its stack. Since Fiber.yield(value) has two arguments (the Fiber class
+		// and the value) and we only need one slot for the result, discard the other
+		// slot now.
+		fiber->stacktop--;
+
+		// Return the fiber to resume.
+		args[0] = OBJ_VAL(caller);
+	}
+
+	return PRIM_RUN_FIBER;
+END_NATIVE
+
+DEF_NATIVE(fiber_current)
+	RETURN_OBJ(fiber);
+END_NATIVE
+
+///////////////////////////////////////////////////////////////////////////////////
+//// LIST
+///////////////////////////////////////////////////////////////////////////////////
+
+DEF_NATIVE(list_instantiate)
+	RETURN_OBJ(cardinalNewList(vm, 0));
+END_NATIVE
+
+DEF_NATIVE(list_add)
+	ObjList* list = AS_LIST(args[0]);
+	if (!validateMemory(vm, args, cardinalListGrowth(list))) return PRIM_ERROR;
+	cardinalListAdd(vm, list, args[1]);
+	RETURN_VAL(args[1]);
+END_NATIVE
+
+DEF_NATIVE(list_clear)
+	ObjList* list = AS_LIST(args[0]);
+	if (list->source == NULL) DEALLOCATE(vm, list->elements);
+	list->elements = NULL;
+	list->capacity = 0;
+	list->count = 0;
+	list->source = NULL;
+	RETURN_NULL;
+END_NATIVE
+
+DEF_NATIVE(list_count)
+	ObjList* list = AS_LIST(args[0]);
+	RETURN_NUM((double) list->count);
+END_NATIVE
+
+DEF_NATIVE(list_head)
+	ObjList* list = AS_LIST(args[0]);
+	if (list->count == 0) return PRIM_ERROR;
+
+	RETURN_VAL(list->elements[0]);
+END_NATIVE
+
+// The tail and init of a list are views that share its elements, so walking a
+// list through them does not copy it over and over.
+DEF_NATIVE(list_tail)
+	ObjList* list = AS_LIST(args[0]);
+	if (list->count <= 1) RETURN_OBJ(cardinalNewList(vm, 0));
+
+	RETURN_OBJ(cardinalNewListView(vm, list, 1, list->count - 1));
+END_NATIVE
+
+DEF_NATIVE(list_init)
+	ObjList* list = AS_LIST(args[0]);
+	if (list->count <= 1) RETURN_OBJ(cardinalNewList(vm, 0));
+
+	RETURN_OBJ(cardinalNewListView(vm, list, 0, list->count - 1));
+END_NATIVE
+
+DEF_NATIVE(list_last)
+	ObjList* list = AS_LIST(args[0]);
+	if (list->count == 0) return PRIM_ERROR;
+
+	RETURN_VAL(list->elements[list->count - 1]);
+END_NATIVE
+
+DEF_NATIVE(list_conc)
+	ObjList* list = AS_LIST(args[0]);
+	if (list->count == 0) return PRIM_ERROR;
+	if (!validateMemory(vm, args, cardinalListGrowth(list))) return PRIM_ERROR;
+
+	cardinalListInsert(vm, list, args[1], 0);
+	RETURN_VAL(args[1]);
+END_NATIVE
+
+DEF_NATIVE(list_call)
+	ObjList* list = AS_LIST(args[0]);
+	if (list->count == 0) return PRIM_ERROR;
+		
+	// Set the first argument correct
+	args[0] = list->elements[0];
+
+	// Extract the params
+	int nbParam = (list->count - 1);
+	
+	// Extract the function from the list
+	ObjFn* fn;
+	if (IS_CLOSURE(args[0])) {
+		fn = AS_CLOSURE(args[0])->fn;
+	}
+	else if (IS_FN(args[0])) {
+		fn = AS_FN(args[0]);
+	}
+	else {
+		RETURN_ERROR("List first element should be a function.");
+	}
+	
+	// Check the amount of parameters
+	if (nbParam < fn->numParams) RETURN_ERROR("Function expects more arguments.");
+	if (nbParam > fn->numParams) nbParam = fn->numParams;
+	
+	// Push the param on the stack
+	for(int i=1; i < nbParam + 1; i++) {
+		pushParamCore(vm, list->elements[i]);
+	}
+	
+	// Add one for the implicit receiver argument.
+	*numargs = nbParam + 1; 
+
+	return PRIM_CALL;
+	
+END_NATIVE
+
+DEF_NATIVE(list_insert)
+	ObjList* list = AS_LIST(args[0]);
+
+	// count + 1 here so you can "insert" at the very end.
+	int index = validateIndex(vm, args, list->count + 1, 2, "Index");
+	if (index == -1) return PRIM_ERROR;
+	if (!validateMemory(vm, args, cardinalListGrowth(list))) return PRIM_ERROR;
+
+	cardinalListInsert(vm, list, args[1], index);
+	RETURN_VAL(args[1]);
+END_NATIVE
+
+DEF_NATIVE(list_iterate)
+	ObjList* list = AS_LIST(args[0]);
+
+	// If we're starting the iteration, return the first index.
+	if (IS_NULL(args[1])) {
+		if (list->count == 0) RETURN_FALSE;
+		RETURN_NUM(0);
+	}
+
+	if (!validateInt(vm, args, 1, "Iterator")) return PRIM_ERROR;
+
+	int index = (int)AS_NUM(args[1]);
+
+	// Stop if we're out of bounds.
+	if (index < 0 || index >= list->count - 1) RETURN_FALSE;
+
+	// Otherwise, move to the next index.
+	RETURN_NUM((double) index + 1);
+END_NATIVE
+
+DEF_NATIVE(list_iteratorValue)
+	ObjList* list = AS_LIST(args[0]);
+	int index = validateIndex(vm, args, list->count, 1, "Iterator");
+	if (index == -1) return PRIM_ERROR;
+
+	RETURN_VAL(list->elements[index]);
+END_NATIVE
+
+DEF_NATIVE(list_removeAt)
+	ObjList* list = AS_LIST(args[0]);
+	int index = validateIndex(vm, args, list->count, 1, "Index");
+	if (index == -1) return PRIM_ERROR;
+
+	RETURN_VAL(cardinalListRemoveAt(vm, list, index));
+END_NATIVE
+
+DEF_NATIVE(list_subscript)
+	ObjList* list = AS_LIST(args[0]);
+
+	if (IS_NUM(args[1])) {
+		int index = validateIndex(vm, args, list->count, 1, "Subscript");
+		if (index == -1) return PRIM_ERROR;
+
+		RETURN_VAL(list->elements[index]);
+	}
+
+	if (!IS_RANGE(args[1])) {
+		RETURN_ERROR("Subscript must be a number or a range.");
+	}
+
+	int step;
+	int count = list->count;
+	int start = calculateRange(vm, args, AS_RANGE(args[1]), &count, &step);
+	if (start == -1) return PRIM_ERROR;
+
+	// An ascending range shares the elements, a descending one copies them.
+	if (count > 1 && step > 0) {
+		RETURN_OBJ(cardinalNewListView(vm, list, start, count));
+	}
+
+	ObjList* result = cardinalNewList(vm, count);
+	for (int i = 0; i < count; i++) {
+		result->elements[i] = list->elements[start + (i * step)];
+	}
+
+	RETURN_OBJ(result);
+END_NATIVE
+
+DEF_NATIVE(list_subscriptSetter)
+	ObjList* list = AS_LIST(args[0]);
+	int index = validateIndex(vm, args, list->count, 1, "Subscript");
+	if (index == -1) return PRIM_ERROR;
+
+	cardinalListUnshare(vm, list);
+	list->elements[index] = args[2];
+	RETURN_VAL(args[2]);
+END_NATIVE
+
+// Validates that every element of [list] is a number. Returns true if they
+// are. If not, reports an error and returns false.
+static bool validateNumbers(CardinalVM* vm, Value* args, ObjList* list) {
+	for (int i = 0; i < list->count; i++) {
+		if (IS_NUM(list->elements[i])) continue;
+
+		args[0] = cardinalNewString(vm, "List must only contain numbers.", 31);
+		return false;
+	}
+	return true;
+}
+
+DEF_NATIVE(list_sum)
+	ObjList* list = AS_LIST(args[0]);
+	if (!validateNumbers(vm, args, list)) return PRIM_ERROR;
+
+	double sum = 0;
+	for (int i = 0; i < list->count; i++) {
+		sum += AS_NUM(list->elements[i]);
+	}
+	RETURN_NUM(sum);
+END_NATIVE
+
+DEF_NATIVE(list_dot)
+	ObjList* list = AS_LIST(args[0]);
+	if (!validateNumbers(vm, args, list)) return PRIM_ERROR;
+
+	KernelOperand other;
+	if (!validateOperand(vm, args, 1, (uint32_t) list->count, &other, "Operand")) return PRIM_ERROR;
+	if (other.array == NULL && other.list == NULL) {
+		RETURN_ERROR("Operand must be a typed array or a list.");
+	}
+
+	double sum = 0;
+	for (int i = 0; i < list->count; i++) {
+		sum += AS_NUM(list->elements[i]) * operandAt(&other, (uint32_t) i);
+	}
+	RETURN_NUM(sum);
+END_NATIVE
+
+// Returns the smallest element of the receiver if [smallest] is true, otherwise
+// the largest. Returns null if the list is empty.
+static PrimitiveResult listExtreme(CardinalVM* vm, Value* args, bool smallest) {
+	ObjList* list = AS_LIST(args[0]);
+	if (!validateNumbers(vm, args, list)) return PRIM_ERROR;
+	if (list->count == 0) RETURN_NULL;
+
+	double result = AS_NUM(list->elements[0]);
+	for (int i = 1; i < list->count; i++) {
+		double value = AS_NUM(list->elements[i]);
+		if (smallest ? value < result : value > result) result = value;
+	}
+	RETURN_NUM(result);
+}
+
+DEF_NATIVE(list_min)
+	return listExtreme(vm, args, true);
+END_NATIVE
+
+DEF_NATIVE(list_max)
+	return listExtreme(vm, args, false);
+END_NATIVE
+
+// The ways in which a sort compares the elements of a list.
+typedef enum SortOrder {
+	/// Every element is a number, they are compared directly
+	SORT_NUMBERS,
+	/// Every element is a string, they are compared byte by byte
+	SORT_STRINGS,
+	/// The elements are compared by calling their < operator
+	SORT_OPERATOR,
+	/// The elements are compared by calling a comparator
+	SORT_COMPARATOR
+} SortOrder;
+
+// The state of a sort in progress.
+typedef struct SortContext {
+	/// The VM the sort runs in
+	CardinalVM* vm;
+	
+	/// How the elements are compared
+	SortOrder order;
+	
+	/// The fiber that calls the comparator or the < operator, it is reused for
+	/// every comparison
+	ObjFiber* callFiber;
+	
+	/// The comparator, if there is one
+	Value comparator;
+	
+	/// Set once a comparison failed, the remaining ones are skipped
+	bool failed;
+	
+	/// The error of the comparison that failed
+	Value error;
+} SortContext;
+
+// Compares the bytes of two strings. Returns a negative number if [a] comes
+// first, a positive number if [b] does and zero if they are equal.
+static int compareStrings(ObjString* a, ObjString* b) {
+	int length = a->length < b->length ? a->length : b->length;
+	int result = memcmp(a->value, b->value, length);
+	if (result != 0) return result;
+	
+	return a->length - b->length;
+}
+
+// Returns true if [a] has to come before [b].
+static bool sortLess(SortContext* sort, Value a, Value b) {
+	if (sort->order == SORT_NUMBERS) return AS_NUM(a) < AS_NUM(b);
+	if (sort->order == SORT_STRINGS) return compareStrings(AS_STRING(a), AS_STRING(b)) < 0;
+	if (sort->failed) return false;
+	
+	Value callArgs[3];
+	if (sort->order == SORT_COMPARATOR) {
+		callArgs[0] = sort->comparator;
+		callArgs[1] = a;
+		callArgs[2] = b;
+	}
+	else {
+		callArgs[0] = a;
+		callArgs[1] = b;
+	}
+	
+	Value result;
+	if (!cardinalRunCallFiber(sort->vm, sort->callFiber, callArgs, &result)) {
+		sort->failed = true;
+		sort->error = result;
+		return false;
+	}
+	return !IS_FALSE(result) && !IS_NULL(result);
+}
+
+static inline void swapValues(Value* elements, int a, int b) {
+	Value value = elements[a];
+	elements[a] = elements[b];
+	elements[b] = value;
+}
+
+// The sorts below only ever swap elements, so every element stays in the list
+// while a comparison runs a script. The loops check their bounds, so a
+// comparator that is not consistent gives a useless order but never reads
+// outside of the list.
+
+// Sorts the range [from, to) of [elements] by insertion. Equal elements keep
+// their order.
+static void insertionSort(SortContext* sort, Value* elements, int from, int to) {
+	for (int i = from + 1; i < to; i++) {
+		for (int j = i; j > from && sortLess(sort, elements[j], elements[j - 1]); j--) {
+			swapValues(elements, j, j - 1);
+		}
+	}
+}
+
+// Moves the element at [root] of the heap of [count] elements down until both
+// of its children come before it.
+static void siftDown(SortContext* sort, Value* elements, int root, int count) {
+	for (;;) {
+		int child = 2 * root + 1;
+		if (child >= count) return;
+		if (child + 1 < count && sortLess(sort, elements[child], elements[child + 1])) child++;
+		if (!sortLess(sort, elements[root], elements[child])) return;
+		
+		swapValues(elements, root, child);
+		root = child;
+	}
+}
+
+static void heapSort(SortContext* sort, Value* elements, int count) {
+	for (int i = count / 2 - 1; i >= 0; i--) {
+		siftDown(sort, elements, i, count);
+	}
+	for (int end = count - 1; end > 0; end--) {
+		swapValues(elements, 0, end);
+		siftDown(sort, elements, 0, end);
+	}
+}
+
+// Sorts the range [from, to) of [elements] with a quicksort that switches to a
+// heap sort once it has split the range [depth] times. This keeps the worst
+// case at O(n log n) comparisons.
+static void introSort(SortContext* sort, Value* elements, int from, int to, int depth) {
+	while (to - from > LIST_SORT_INSERTION_COUNT) {
+		if (depth-- == 0) {
+			heapSort(sort, elements + from, to - from);
+			return;
+		}
+		
+		// Use the median of the first, middle and last element as the pivot.
+		int middle = from + (to - from) / 2;
+		if (sortLess(sort, elements[middle], elements[from])) swapValues(elements, middle, from);
+		if (sortLess(sort, elements[to - 1], elements[middle])) {
+			swapValues(elements, to - 1, middle);
+			if (sortLess(sort, elements[middle], elements[from])) swapValues(elements, middle, from);
+		}
+		Value pivot = elements[middle];
+		
+		// Split the range into [from, split] and [split + 1, to).
+		int left = from - 1;
+		int right = to;
+		for (;;) {
+			do left++; while (left < to - 1 && sortLess(sort, elements[left], pivot));
+			do right--; while (right > from && sortLess(sort, pivot, elements[right]));
+			if (left >= right) break;
+			
+			swapValues(elements, left, right);
+		}
+		int split = right;
+		
+		// Recurse into the smaller part and loop on the larger one, so the
+		// recursion is never deeper than log n.
+		if (split + 1 - from < to - split - 1) {
+			introSort(sort, elements, from, split + 1, depth);
+			from = split + 1;
+		}
+		else {
+			introSort(sort, elements, split + 1, to, depth);
+			to = split + 1;
+		}
+	}
+	
+	insertionSort(sort, elements, from, to);
+}
+
+// Sorts the range [from, to) of [elements] with a merge sort. Equal elements
+// keep their order. [buffer] needs room for half of the range.
+static void mergeSort(SortContext* sort, Value* elements, Value* buffer, int from, int to) {
+	if (to - from <= LIST_SORT_INSERTION_COUNT) {
+		insertionSort(sort, elements, from, to);
+		return;
+	}
+	
+	int middle = from + (to - from) / 2;
+	mergeSort(sort, elements, buffer, from, middle);
+	mergeSort(sort, elements, buffer, middle, to);
+	
+	// Nothing to merge if the halves are already in order.
+	if (!sortLess(sort, elements[middle], elements[middle - 1])) return;
+	
+	// Every element is either still in [elements] or in [buffer] while the
+	// halves are merged.
+	int leftCount = middle - from;
+	memcpy(buffer, elements + from, sizeof(Value) * leftCount);
+	
+	int left = 0;
+	int right = middle;
+	int out = from;
+	while (left < leftCount && right < to) {
+		if (sortLess(sort, elements[right], buffer[left])) {
+			elements[out++] = elements[right++];
+		}
+		else {
+			elements[out++] = buffer[left++];
+		}
+	}
+	while (left < leftCount) {
+		elements[out++] = buffer[left++];
+	}
+}
+
+// Returns the fastest way to compare the elements of [list].
+static SortOrder listSortOrder(ObjList* list) {
+	bool numbers = true;
+	bool strings = true;
+	for (int i = 0; i < list->count && (numbers || strings); i++) {
+		if (!IS_NUM(list->elements[i])) numbers = false;
+		if (!IS_STRING(list->elements[i])) strings = false;
+	}
+	
+	if (numbers) return SORT_NUMBERS;
+	if (strings) return SORT_STRINGS;
+	return SORT_OPERATOR;
+}
+
+// Sorts the receiver in place. Uses the comparator in [args][1] if
+// [hasComparator] is set, otherwise numbers and strings are compared directly
+// and other elements by their < operator. A [stable] sort keeps equal elements
+// in their order.
+static PrimitiveResult sortList(CardinalVM* vm, Value* args, bool hasComparator, bool stable) {
+	if (hasComparator && !validateFn(vm, args, 1, "Comparator")) return PRIM_ERROR;
+	
+	ObjList* list = AS_LIST(args[0]);
+	if (list->count < 2) RETURN_VAL(args[0]);
+	
+	SortContext sort;
+	sort.vm = vm;
+	sort.order = hasComparator ? SORT_COMPARATOR : listSortOrder(list);
+	sort.callFiber = NULL;
+	sort.comparator = hasComparator ? args[1] : NULL_VAL;
+	sort.failed = false;
+	sort.error = NULL_VAL;
+	
+	// A comparison that runs a script may change the list, so those orders
+	// sort a copy that only this sort can see.
+	int numPinned = 0;
+	ObjList* work = list;
+	if (sort.order == SORT_OPERATOR || sort.order == SORT_COMPARATOR) {
+		sort.callFiber = cardinalNewCallFiber(vm, hasComparator ? "call(_,_)" : "<(_)");
+		CARDINAL_PIN(vm, sort.callFiber);
+		
+		work = cardinalNewList(vm, list->count);
+		memcpy(work->elements, list->elements, sizeof(Value) * list->count);
+		CARDINAL_PIN(vm, work);
+		numPinned += 2;
 	}
 	else {
-		// Make the caller's run method return the argument passed to yield.
-		*(caller->stacktop - 1) = args[1];
+		cardinalListUnshare(vm, list);
+	}
+	
+	if (stable) {
+		// The buffer is a list as well, so the collector sees the elements that
+		// are only in the buffer while a comparison runs.
+		ObjList* buffer = cardinalNewList(vm, work->count / 2);
+		for (int i = 0; i < buffer->count; i++) buffer->elements[i] = NULL_VAL;
+		CARDINAL_PIN(vm, buffer);
+		numPinned++;
+		
+		mergeSort(&sort, work->elements, buffer->elements, 0, work->count);
+	}
+	else {
+		int depth = 0;
+		for (int count = work->count; count > 1; count >>= 1) depth += 2;
+		introSort(&sort, work->elements, 0, work->count, depth);
+	}
+	
+	bool modified = false;
+	if (work != list && !sort.failed) {
+		if (list->count == work->count) {
+			cardinalListUnshare(vm, list);
+			memcpy(list->elements, work->elements, sizeof(Value) * work->count);
+		}
+		else {
+			modified = true;
+		}
+	}
+	
+	while (numPinned-- > 0) CARDINAL_UNPIN(vm);
+	
+	if (sort.failed) {
+		args[0] = sort.error;
+		return PRIM_ERROR;
+	}
+	if (modified) RETURN_ERROR("List was changed while it was sorted.");
+	
+	RETURN_VAL(args[0]);
+}
 
-		// When the yielding fiber resumes, we'll store the result of the yield call
-		// in its stack. Since Fiber.yield(value) has two arguments (the Fiber class
-		// and the value) and we only need one slot for the result, discard the other
-		// slot now.
-		fiber->stacktop--;
+DEF_NATIVE(list_sort)
+	return sortList(vm, args, false, false);
+END_NATIVE
 
-		// Return the fiber to resume.
-		args[0] = OBJ_VAL(caller);
-	}
+DEF_NATIVE(list_sortBy)
+	return sortList(vm, args, true, false);
+END_NATIVE
 
-	return PRIM_RUN_FIBER;
+DEF_NATIVE(list_stableSort)
+	return sortList(vm, args, false, true);
 END_NATIVE
 
-DEF_NATIVE(fiber_current)
-	RETURN_OBJ(fiber);
+DEF_NATIVE(list_stableSortBy)
+	return sortList(vm, args, true, true);
 END_NATIVE
 
 ///////////////////////////////////////////////////////////////////////////////////
-//// LIST
+//// MAP
 ///////////////////////////////////////////////////////////////////////////////////
 
-DEF_NATIVE(list_instantiate)
-	RETURN_OBJ(cardinalNewList(vm, 0));
+DEF_NATIVE(map_instantiate)
+	RETURN_OBJ(cardinalNewMap(vm));
 END_NATIVE
 
-DEF_NATIVE(list_add)
-	ObjList* list = AS_LIST(args[0]);
-	cardinalListAdd(vm, list, args[1]);
-	RETURN_VAL(args[1]);
+DEF_NATIVE(map_subscript)
+	if (!validateKey(vm, args, 1)) return PRIM_ERROR;
+
+	ObjMap* map = AS_MAP(args[0]);
+	uint32_t index = cardinalMapFind(map, args[1]);
+	if (index == UINT32_MAX) RETURN_NULL;
+
+	RETURN_VAL(map->entries[index].value);
 END_NATIVE
 
-DEF_NATIVE(list_clear)
-	ObjList* list = AS_LIST(args[0]);
-	DEALLOCATE(vm, list->elements);
-	list->elements = NULL;
-	list->capacity = 0;
-	list->count = 0;
+DEF_NATIVE(map_subscriptSetter)
+	if (!validateKey(vm, args, 1)) return PRIM_ERROR;
+
+	cardinalMapSet(vm, AS_MAP(args[0]), args[1], args[2]);
+	RETURN_VAL(args[2]);
+END_NATIVE
+
+DEF_NATIVE(map_clear)
+	cardinalMapClear(vm, AS_MAP(args[0]));
 	RETURN_NULL;
 END_NATIVE
 
-DEF_NATIVE(list_count)
-	ObjList* list = AS_LIST(args[0]);
-	RETURN_NUM((double) list->count);
+DEF_NATIVE(map_containsKey)
+	if (!validateKey(vm, args, 1)) return PRIM_ERROR;
+
+	RETURN_BOOL(cardinalMapFind(AS_MAP(args[0]), args[1]) != UINT32_MAX);
 END_NATIVE
 
-DEF_NATIVE(list_head)
-	ObjList* list = AS_LIST(args[0]);
-	if (list->count == 0) return PRIM_ERROR;
+DEF_NATIVE(map_count)
+	RETURN_NUM(AS_MAP(args[0])->count);
+END_NATIVE
 
-	RETURN_VAL(list->elements[0]);
+DEF_NATIVE(map_iterate)
+	ObjMap* map = AS_MAP(args[0]);
+
+	if (map->count == 0) RETURN_FALSE;
+
+	// If we're starting the iteration, start at the first used entry.
+	uint32_t index = 0;
+
+	// Otherwise, start one past the last entry we stopped at.
+	if (!IS_NULL(args[1])) {
+		if (!validateInt(vm, args, 1, "Iterator")) return PRIM_ERROR;
+
+		if (AS_NUM(args[1]) < 0) RETURN_FALSE;
+		index = (uint32_t)AS_NUM(args[1]);
+
+		if (index >= map->capacity) RETURN_FALSE;
+
+		// Advance the iterator.
+		index++;
+	}
+
+	// Find a used entry, if any.
+	for (; index < map->capacity; index++) {
+		if (!IS_UNDEFINED(map->entries[index].key)) RETURN_NUM(index);
+	}
+
+	// If we get here, walked all of the entries.
+	RETURN_FALSE;
 END_NATIVE
 
-DEF_NATIVE(list_tail)
-	ObjList* list = AS_LIST(args[0]);
+DEF_NATIVE(map_remove)
+	if (!validateKey(vm, args, 1)) return PRIM_ERROR;
+
+	RETURN_VAL(cardinalMapRemoveKey(vm, AS_MAP(args[0]), args[1]));
+END_NATIVE
+
+DEF_NATIVE(map_keyIteratorValue)
+	ObjMap* map = AS_MAP(args[0]);
+	int index = validateIndex(vm, args, map->capacity, 1, "Iterator");
+	if (index == -1) return PRIM_ERROR;
 
-	ObjList* newlist = cardinalNewList(vm, 0);
-	for(int i=1; i < list->count; i++) {
-		cardinalListAdd(vm, newlist, list->elements[i]);
+	MapEntry* entry = &map->entries[index];
+	if (IS_UNDEFINED(entry->key)) {
+		RETURN_ERROR("Invalid map iterator value.");
 	}
-	RETURN_OBJ(newlist);
+
+	RETURN_VAL(entry->key);
 END_NATIVE
 
-DEF_NATIVE(list_init)
-	ObjList* list = AS_LIST(args[0]);
+DEF_NATIVE(map_valueIteratorValue)
+	ObjMap* map = AS_MAP(args[0]);
+	int index = validateIndex(vm, args, map->capacity, 1, "Iterator");
+	if (index == -1) return PRIM_ERROR;
 
-	ObjList* newlist = cardinalNewList(vm, 0);
-	for(int i=0; i < list->count - 1; i++) {
-		cardinalListAdd(vm, newlist, list->elements[i]);
+	MapEntry* entry = &map->entries[index];
+	if (IS_UNDEFINED(entry->key)) {
+		RETURN_ERROR("Invalid map iterator value.");
 	}
-	RETURN_OBJ(newlist);
+
+	RETURN_VAL(entry->value);
 END_NATIVE
 
-DEF_NATIVE(list_last)
-	ObjList* list = AS_LIST(args[0]);
-	if (list->count == 0) return PRIM_ERROR;
+///////////////////////////////////////////////////////////////////////////////////
+//// SET
+///////////////////////////////////////////////////////////////////////////////////
 
-	RETURN_VAL(list->elements[list->count - 1]);
+// Validates that the argument at [index] is a set, or a list whose elements can
+// all be in a set. Returns true if it is. If not, reports an error and returns
+// false.
+static bool validateSetOperand(CardinalVM* vm, Value* args, int index) {
+	if (IS_SET(args[index])) return true;
+	
+	if (!IS_LIST(args[index])) {
+		args[0] = cardinalNewString(vm, "Operand must be a set or a list.", 32);
+		return false;
+	}
+	
+	ObjList* list = AS_LIST(args[index]);
+	for (int i = 0; i < list->count; i++) {
+		if (isKeyType(list->elements[i])) continue;
+		
+		args[0] = cardinalNewString(vm, "Element must be a value type.", 29);
+		return false;
+	}
+	return true;
+}
+
+// Adds the elements of the set or list [operand] to [set].
+static void addSetElements(CardinalVM* vm, ObjMap* set, Value operand) {
+	if (IS_LIST(operand)) {
+		ObjList* list = AS_LIST(operand);
+		for (int i = 0; i < list->count; i++) {
+			cardinalMapSet(vm, set, list->elements[i], TRUE_VAL);
+		}
+		return;
+	}
+	
+	ObjMap* other = AS_SET(operand);
+	for (uint32_t i = 0; i < other->capacity; i++) {
+		if (IS_UNDEFINED(other->entries[i].key)) continue;
+		cardinalMapSet(vm, set, other->entries[i].key, TRUE_VAL);
+	}
+}
+
+DEF_NATIVE(set_instantiate)
+	RETURN_OBJ(cardinalNewSet(vm));
 END_NATIVE
 
-DEF_NATIVE(list_conc)
-	ObjList* list = AS_LIST(args[0]);
-	if (list->count == 0) return PRIM_ERROR;
+DEF_NATIVE(set_newFrom)
+	if (!validateSetOperand(vm, args, 1)) return PRIM_ERROR;
+	
+	ObjMap* set = cardinalNewSet(vm);
+	CARDINAL_PIN(vm, set);
+	addSetElements(vm, set, args[1]);
+	CARDINAL_UNPIN(vm);
+	
+	RETURN_OBJ(set);
+END_NATIVE
 
-	cardinalListInsert(vm, list, args[1], 0);
-	RETURN_VAL(args[1]);
+DEF_NATIVE(set_add)
+	if (!validateElement(vm, args, 1)) return PRIM_ERROR;
+
+	RETURN_BOOL(cardinalSetAdd(vm, AS_SET(args[0]), args[1]));
 END_NATIVE
 
-DEF_NATIVE(list_call)
-	ObjList* list = AS_LIST(args[0]);
-	if (list->count == 0) return PRIM_ERROR;
-		
-	// Set the first argument correct
-	args[0] = list->elements[0];
+DEF_NATIVE(set_remove)
+	if (!validateElement(vm, args, 1)) return PRIM_ERROR;
 
-	// Extract the params
-	int nbParam = (list->count - 1);
+	RETURN_BOOL(!IS_NULL(cardinalMapRemoveKey(vm, AS_SET(args[0]), args[1])));
+END_NATIVE
+
+DEF_NATIVE(set_contains)
+	if (!isKeyType(args[1])) RETURN_FALSE;
+
+	RETURN_BOOL(cardinalMapFind(AS_SET(args[0]), args[1]) != UINT32_MAX);
+END_NATIVE
+
+DEF_NATIVE(set_isEmpty)
+	RETURN_BOOL(AS_SET(args[0])->count == 0);
+END_NATIVE
+
+DEF_NATIVE(set_union)
+	if (!validateSetOperand(vm, args, 1)) return PRIM_ERROR;
 	
-	// Extract the function from the list
-	ObjFn* fn;
-	if (IS_CLOSURE(args[0])) {
-		fn = AS_CLOSURE(args[0])->fn;
+	ObjMap* result = cardinalNewSet(vm);
+	CARDINAL_PIN(vm, result);
+	addSetElements(vm, result, args[0]);
+	addSetElements(vm, result, args[1]);
+	CARDINAL_UNPIN(vm);
+	
+	RETURN_OBJ(result);
+END_NATIVE
+
+DEF_NATIVE(set_intersection)
+	if (!validateSetOperand(vm, args, 1)) return PRIM_ERROR;
+	
+	ObjMap* result = cardinalNewSet(vm);
+	CARDINAL_PIN(vm, result);
+	
+	ObjMap* set = AS_SET(args[0]);
+	if (IS_SET(args[1])) {
+		// Look the elements of the smaller set up in the larger one.
+		ObjMap* smaller = set;
+		ObjMap* larger = AS_SET(args[1]);
+		if (larger->count < smaller->count) {
+			smaller = larger;
+			larger = set;
+		}
+		
+		for (uint32_t i = 0; i < smaller->capacity; i++) {
+			Value element = smaller->entries[i].key;
+			if (IS_UNDEFINED(element)) continue;
+			
+			if (cardinalMapFind(larger, element) != UINT32_MAX) {
+				cardinalMapSet(vm, result, element, TRUE_VAL);
+			}
+		}
 	}
-	else if (IS_FN(args[0])) {
-		fn = AS_FN(args[0]);
+	else {
+		ObjList* list = AS_LIST(args[1]);
+		for (int i = 0; i < list->count; i++) {
+			if (cardinalMapFind(set, list->elements[i]) != UINT32_MAX) {
+				cardinalMapSet(vm, result, list->elements[i], TRUE_VAL);
+			}
+		}
+	}
+	
+	CARDINAL_UNPIN(vm);
+	RETURN_OBJ(result);
+END_NATIVE
+
+DEF_NATIVE(set_difference)
+	if (!validateSetOperand(vm, args, 1)) return PRIM_ERROR;
+	
+	ObjMap* result = cardinalNewSet(vm);
+	CARDINAL_PIN(vm, result);
+	
+	ObjMap* set = AS_SET(args[0]);
+	if (IS_SET(args[1])) {
+		ObjMap* other = AS_SET(args[1]);
+		for (uint32_t i = 0; i < set->capacity; i++) {
+			Value element = set->entries[i].key;
+			if (IS_UNDEFINED(element)) continue;
+			
+			if (cardinalMapFind(other, element) == UINT32_MAX) {
+				cardinalMapSet(vm, result, element, TRUE_VAL);
+			}
+		}
 	}
 	else {
-		RETURN_ERROR("List first element should be a function.");
+		addSetElements(vm, result, args[0]);
+		
+		ObjList* list = AS_LIST(args[1]);
+		for (int i = 0; i < list->count; i++) {
+			cardinalMapRemoveKey(vm, result, list->elements[i]);
+		}
+	}
+	
+	CARDINAL_UNPIN(vm);
+	RETURN_OBJ(result);
+END_NATIVE
+
+///////////////////////////////////////////////////////////////////////////////////
+//// PRIORITY QUEUE
+///////////////////////////////////////////////////////////////////////////////////
+
+DEF_NATIVE(priorityQueue_instantiate)
+	RETURN_OBJ(cardinalNewPriorityQueue(vm, NULL_VAL));
+END_NATIVE
+
+DEF_NATIVE(priorityQueue_newWithComparator)
+	if (!validateFn(vm, args, 1, "Comparator")) return PRIM_ERROR;
+
+	RETURN_OBJ(cardinalNewPriorityQueue(vm, args[1]));
+END_NATIVE
+
+// Returns true if [a] has to leave [queue] before [b]. Without a comparator,
+// numbers and strings are compared directly and other elements by their <
+// operator.
+static bool queueLess(ObjPriorityQueue* queue, SortContext* sort, Value a, Value b) {
+	if (IS_NULL(queue->comparator)) {
+		if (IS_NUM(a) && IS_NUM(b)) return AS_NUM(a) < AS_NUM(b);
+		if (IS_STRING(a) && IS_STRING(b)) return compareStrings(AS_STRING(a), AS_STRING(b)) < 0;
+	}
+	
+	// The call fiber is only created once a comparison needs it, and is then
+	// kept by the queue.
+	if (sort->callFiber == NULL) {
+		const char* signature = sort->order == SORT_COMPARATOR ? "call(_,_)" : "<(_)";
+		queue->callFiber = cardinalNewCallFiber(sort->vm, signature);
+		sort->callFiber = queue->callFiber;
+	}
+	return sortLess(sort, a, b);
+}
+
+// Moves the element at [index] up the heap of [queue] until its parent comes
+// before it. Returns the index where the element ends up.
+static int siftUp(ObjPriorityQueue* queue, SortContext* sort, int index) {
+	while (index > 0) {
+		int parent = (index - 1) / 2;
+		if (!queueLess(queue, sort, queue->elements[index], queue->elements[parent])) break;
+		
+		swapValues(queue->elements, index, parent);
+		index = parent;
+	}
+	return index;
+}
+
+// Moves the element at [index] down the heap of [queue] until it comes before
+// both of its children. Returns the index where the element ends up.
+static int siftQueueDown(ObjPriorityQueue* queue, SortContext* sort, int index) {
+	for (;;) {
+		int child = 2 * index + 1;
+		if (child >= queue->count) break;
+		if (child + 1 < queue->count &&
+		        queueLess(queue, sort, queue->elements[child + 1], queue->elements[child])) {
+			child++;
+		}
+		if (!queueLess(queue, sort, queue->elements[child], queue->elements[index])) break;
+		
+		swapValues(queue->elements, index, child);
+		index = child;
+	}
+	return index;
+}
+
+// The sifts only swap an element with its parent or child, so the path of the
+// element is known and a sift that stopped at a failed comparison can be
+// reversed without comparing.
+
+// Moves the element at [index] back down to [last], along the path that [siftUp]
+// moved it up.
+static void unsiftUp(ObjPriorityQueue* queue, int index, int last) {
+	while (index != last) {
+		int child = last;
+		while ((child - 1) / 2 != index) child = (child - 1) / 2;
+		
+		swapValues(queue->elements, index, child);
+		index = child;
+	}
+}
+
+// Moves the element at [index] back up to the root, along the path that
+// [siftQueueDown] moved it down.
+static void unsiftDown(ObjPriorityQueue* queue, int index) {
+	while (index > 0) {
+		int parent = (index - 1) / 2;
+		swapValues(queue->elements, index, parent);
+		index = parent;
+	}
+}
+
+// Gets [queue] ready to compare its elements. A comparison may run a script
+// that changes the queue, which is not allowed. Returns false and reports an
+// error if the queue is already comparing its elements.
+static bool startComparing(CardinalVM* vm, Value* args, ObjPriorityQueue* queue, SortContext* sort) {
+	if (queue->isComparing) {
+		args[0] = cardinalNewString(vm, "Priority queue cannot change while it compares elements.", 56);
+		return false;
+	}
+	
+	sort->vm = vm;
+	sort->order = IS_NULL(queue->comparator) ? SORT_OPERATOR : SORT_COMPARATOR;
+	sort->callFiber = queue->callFiber;
+	sort->comparator = queue->comparator;
+	sort->failed = false;
+	sort->error = NULL_VAL;
+	queue->isComparing = true;
+	return true;
+}
+
+// Returns [result], or the error of the comparison that failed.
+static PrimitiveResult finishComparing(Value* args, ObjPriorityQueue* queue, SortContext* sort, Value result) {
+	queue->isComparing = false;
+	
+	if (sort->failed) {
+		args[0] = sort->error;
+		return PRIM_ERROR;
+	}
+	RETURN_VAL(result);
+}
+
+DEF_NATIVE(priorityQueue_push)
+	ObjPriorityQueue* queue = AS_PRIORITYQUEUE(args[0]);
+	SortContext sort;
+	if (!startComparing(vm, args, queue, &sort)) return PRIM_ERROR;
+	
+	cardinalPriorityQueueAppend(vm, queue, args[1]);
+	int last = queue->count - 1;
+	int index = siftUp(queue, &sort, last);
+	
+	// A comparison failed, so the element is taken out again.
+	if (sort.failed) {
+		unsiftUp(queue, index, last);
+		queue->count--;
 	}
+	return finishComparing(args, queue, &sort, args[1]);
+END_NATIVE
+
+DEF_NATIVE(priorityQueue_pop)
+	ObjPriorityQueue* queue = AS_PRIORITYQUEUE(args[0]);
+	if (queue->count == 0) RETURN_ERROR("Priority queue is empty.");
 	
-	// Check the amount of parameters
-	if (nbParam < fn->numParams) RETURN_ERROR("Function expects more arguments.");
-	if (nbParam > fn->numParams) nbParam = fn->numParams;
+	SortContext sort;
+	if (!startComparing(vm, args, queue, &sort)) return PRIM_ERROR;
 	
-	// Push the param on the stack
-	for(int i=1; i < nbParam + 1; i++) {
-		pushParamCore(vm, list->elements[i]);
+	Value first = queue->elements[0];
+	queue->count--;
+	queue->elements[0] = queue->elements[queue->count];
+	
+	// The first element is no longer in the queue, but has to survive the
+	// comparisons.
+	if (IS_OBJ(first)) CARDINAL_PIN(vm, AS_OBJ(first));
+	int index = siftQueueDown(queue, &sort, 0);
+	if (IS_OBJ(first)) CARDINAL_UNPIN(vm);
+	
+	// A comparison failed, so the first element is put back.
+	if (sort.failed) {
+		unsiftDown(queue, index);
+		queue->elements[queue->count] = queue->elements[0];
+		queue->elements[0] = first;
+		queue->count++;
 	}
 	
-	// Add one for the implicit receiver argument.
-	*numargs = nbParam + 1; 
+	return finishComparing(args, queue, &sort, first);
+END_NATIVE
 
-	return PRIM_CALL;
-	
+DEF_NATIVE(priorityQueue_first)
+	ObjPriorityQueue* queue = AS_PRIORITYQUEUE(args[0]);
+	if (queue->count == 0) RETURN_ERROR("Priority queue is empty.");
+
+	RETURN_VAL(queue->elements[0]);
 END_NATIVE
 
-DEF_NATIVE(list_insert)
-	ObjList* list = AS_LIST(args[0]);
+DEF_NATIVE(priorityQueue_count)
+	RETURN_NUM(AS_PRIORITYQUEUE(args[0])->count);
+END_NATIVE
 
-	// count + 1 here so you can "insert" at the very end.
-	int index = validateIndex(vm, args, list->count + 1, 2, "Index");
-	if (index == -1) return PRIM_ERROR;
+DEF_NATIVE(priorityQueue_isEmpty)
+	RETURN_BOOL(AS_PRIORITYQUEUE(args[0])->count == 0);
+END_NATIVE
 
-	cardinalListInsert(vm, list, args[1], index);
-	RETURN_VAL(args[1]);
+DEF_NATIVE(priorityQueue_clear)
+	ObjPriorityQueue* queue = AS_PRIORITYQUEUE(args[0]);
+	if (queue->isComparing) RETURN_ERROR("Priority queue cannot change while it compares elements.");
+
+	cardinalPriorityQueueClear(vm, queue);
+	RETURN_NULL;
 END_NATIVE
 
-DEF_NATIVE(list_iterate)
-	ObjList* list = AS_LIST(args[0]);
+// A priority queue is iterated in the order of its heap, not in the order in
+// which [pop] would return the elements.
+DEF_NATIVE(priorityQueue_iterate)
+	ObjPriorityQueue* queue = AS_PRIORITYQUEUE(args[0]);
 
 	// If we're starting the iteration, return the first index.
 	if (IS_NULL(args[1])) {
-		if (list->count == 0) RETURN_FALSE;
+		if (queue->count == 0) RETURN_FALSE;
 		RETURN_NUM(0);
 	}
 
 	if (!validateInt(vm, args, 1, "Iterator")) return PRIM_ERROR;
 
-	int index = (int)AS_NUM(args[1]);
+	int index = (int) AS_NUM(args[1]);
 
 	// Stop if we're out of bounds.
-	if (index < 0 || index >= list->count - 1) RETURN_FALSE;
+	if (index < 0 || index >= queue->count - 1) RETURN_FALSE;
 
 	// Otherwise, move to the next index.
 	RETURN_NUM((double) index + 1);
 END_NATIVE
 
-DEF_NATIVE(list_iteratorValue)
-	ObjList* list = AS_LIST(args[0]);
-	int index = validateIndex(vm, args, list->count, 1, "Iterator");
+DEF_NATIVE(priorityQueue_iteratorValue)
+	ObjPriorityQueue* queue = AS_PRIORITYQUEUE(args[0]);
+	int index = validateIndex(vm, args, queue->count, 1, "Iterator");
 	if (index == -1) return PRIM_ERROR;
 
-	RETURN_VAL(list->elements[index]);
+	RETURN_VAL(queue->elements[index]);
 END_NATIVE
 
-DEF_NATIVE(list_removeAt)
-	ObjList* list = AS_LIST(args[0]);
-	int index = validateIndex(vm, args, list->count, 1, "Index");
-	if (index == -1) return PRIM_ERROR;
-
-	RETURN_VAL(cardinalListRemoveAt(vm, list, index));
-END_NATIVE
+///////////////////////////////////////////////////////////////////////////////////
+//// PIPELINE
+///////////////////////////////////////////////////////////////////////////////////
 
-DEF_NATIVE(list_subscript)
-	ObjList* list = AS_LIST(args[0]);
+// What happened to a value that was run through a pipeline.
+typedef enum PipelineResult {
+	/// The value came out at the end of the pipeline
+	PIPELINE_PASSED,
+	/// A stage dropped the value
+	PIPELINE_DROPPED,
+	/// No more values can come out of the pipeline
+	PIPELINE_DONE,
+	/// A call failed
+	PIPELINE_FAILED
+} PipelineResult;
+
+// The state of a pipeline whose iterator is advanced.
+typedef struct PipelineRun {
+	/// The VM the pipeline runs in
+	CardinalVM* vm;
+	
+	/// The pipeline
+	ObjPipeline* pipeline;
+	
+	/// The iterator that is advanced
+	ObjPipelineIterator* iterator;
+	
+	/// The symbols of iterate(_) and iteratorValue(_)
+	int iterateSymbol;
+	int iteratorValueSymbol;
+	
+	/// The error of the call that failed
+	Value error;
+} PipelineRun;
 
-	if (IS_NUM(args[1])) {
-		int index = validateIndex(vm, args, list->count, 1, "Subscript");
-		if (index == -1) return PRIM_ERROR;
+static inline bool isFalsy(Value value) {
+	return IS_FALSE(value) || IS_NULL(value);
+}
 
-		RETURN_VAL(list->elements[index]);
+// Returns true if [value] is a built-in sequence. Their iterate(_) and
+// iteratorValue(_) natives return their result, so they can be called without
+// a fiber.
+static bool hasNativeIterator(Value value) {
+	if (!IS_OBJ(value)) return false;
+	
+	switch (AS_OBJ(value)->type) {
+		case OBJ_LIST:
+		case OBJ_RANGE:
+		case OBJ_STRING:
+		case OBJ_MAP:
+		case OBJ_SET:
+		case OBJ_DEQUE:
+		case OBJ_TYPEDARRAY:
+		case OBJ_PRIORITYQUEUE:
+		case OBJ_PIPELINE:
+			return true;
+		default:
+			return false;
 	}
+}
 
-	if (!IS_RANGE(args[1])) {
-		RETURN_ERROR("Subscript must be a number or a range.");
+// Calls the method [signature] with [symbol] on [receiver] with the argument
+// [arg], and stores what it returns in [result]. The call runs on the fiber in
+// [fiber], which is created when it is first needed, unless [receiver] has a
+// native iterator and the method is called directly.
+static bool pipelineCall(PipelineRun* run, ObjFiber** fiber, const char* signature, int symbol,
+                         Value receiver, Value arg, Value* result) {
+	CardinalVM* vm = run->vm;
+	
+	// A call can collect garbage, and a native method can store new objects in
+	// its arguments, so they are kept in the iterator.
+	Value* callArgs = run->iterator->callArgs;
+	callArgs[0] = receiver;
+	callArgs[1] = arg;
+	
+	bool succeeded;
+	int adjustment = 0;
+	Method* method = NULL;
+	if (symbol >= 0 && hasNativeIterator(receiver)) {
+		method = cardinalGetMethod(vm, cardinalGetClassInline(vm, receiver), symbol, adjustment);
 	}
-
-	int step;
-	int count = list->count;
-	int start = calculateRange(vm, args, AS_RANGE(args[1]), &count, &step);
-	if (start == -1) return PRIM_ERROR;
-
-	ObjList* result = cardinalNewList(vm, count);
-	for (int i = 0; i < count; i++) {
-		result->elements[i] = list->elements[start + (i * step)];
+	
+	if (method != NULL && method->type == METHOD_PRIMITIVE) {
+		int numArgs = 2;
+		succeeded = method->fn.primitive(vm, vm->fiber, callArgs, &numArgs) == PRIM_VALUE;
+		*result = callArgs[0];
+	}
+	else {
+		if (*fiber == NULL) *fiber = cardinalNewCallFiber(vm, signature);
+		succeeded = cardinalRunCallFiber(vm, *fiber, callArgs, result);
 	}
+	
+	callArgs[0] = NULL_VAL;
+	callArgs[1] = NULL_VAL;
+	if (!succeeded) run->error = *result;
+	return succeeded;
+}
 
-	RETURN_OBJ(result);
-END_NATIVE
+// Calls the function of a stage with [value].
+static bool callStage(PipelineRun* run, PipelineStage* stage, Value value, Value* result) {
+	return pipelineCall(run, &run->iterator->callFiber, "call(_)", -1, stage->arg, value, result);
+}
 
-DEF_NATIVE(list_subscriptSetter)
-	ObjList* list = AS_LIST(args[0]);
-	int index = validateIndex(vm, args, list->count, 1, "Subscript");
-	if (index == -1) return PRIM_ERROR;
+// Advances [iterator] over [sequence], and stores the next value in [value].
+// Returns false in [hasValue] at the end of the sequence.
+static bool nextInSequence(PipelineRun* run, Value sequence, Value* iterator,
+                           bool* hasValue, Value* value) {
+	Value result;
+	if (!pipelineCall(run, &run->iterator->iterateFiber, "iterate(_)", run->iterateSymbol,
+	                  sequence, *iterator, &result)) {
+		return false;
+	}
+	
+	*iterator = result;
+	*hasValue = !isFalsy(result);
+	if (!*hasValue) return true;
+	
+	return pipelineCall(run, &run->iterator->iteratorValueFiber, "iteratorValue(_)",
+	                    run->iteratorValueSymbol, sequence, result, value);
+}
 
-	list->elements[index] = args[2];
-	RETURN_VAL(args[2]);
-END_NATIVE
+static PipelineResult drainStage(PipelineRun* run, int stage);
 
-///////////////////////////////////////////////////////////////////////////////////
-//// MAP
-///////////////////////////////////////////////////////////////////////////////////
+// Runs [value] through the stages from [stage] on. If it comes out at the end,
+// it is stored as the current value of the iterator.
+static PipelineResult feedPipeline(PipelineRun* run, int stage, Value value) {
+	ObjPipeline* pipeline = run->pipeline;
+	ObjPipelineIterator* iterator = run->iterator;
+	
+	// The value is kept in the iterator so that it survives the calls.
+	iterator->value = value;
+	for (; stage < pipeline->numStages; stage++) {
+		PipelineStage* current = &pipeline->stages[stage];
+		PipelineStageState* state = &iterator->stages[stage];
+		Value result;
+		bool hasValue;
+		
+		switch (current->kind) {
+			case PIPELINE_MAP:
+				if (!callStage(run, current, iterator->value, &result)) return PIPELINE_FAILED;
+				iterator->value = result;
+				break;
+				
+			case PIPELINE_WHERE:
+				if (!callStage(run, current, iterator->value, &result)) return PIPELINE_FAILED;
+				if (isFalsy(result)) return PIPELINE_DROPPED;
+				break;
+				
+			case PIPELINE_TAKE:
+				if (state->count >= AS_NUM(current->arg)) return PIPELINE_DONE;
+				state->count++;
+				break;
+				
+			case PIPELINE_SKIP:
+				if (state->count < AS_NUM(current->arg)) {
+					state->count++;
+					return PIPELINE_DROPPED;
+				}
+				break;
+				
+			case PIPELINE_TAKE_WHILE:
+				if (!callStage(run, current, iterator->value, &result)) return PIPELINE_FAILED;
+				if (isFalsy(result)) return PIPELINE_DONE;
+				break;
+				
+			case PIPELINE_ZIP:
+			{
+				if (!nextInSequence(run, current->arg, &state->iterator, &hasValue, &state->value)) {
+					return PIPELINE_FAILED;
+				}
+				if (!hasValue) return PIPELINE_DONE;
+				
+				ObjList* pair = cardinalNewList(run->vm, 2);
+				pair->elements[0] = iterator->value;
+				pair->elements[1] = state->value;
+				state->value = NULL_VAL;
+				iterator->value = OBJ_VAL(pair);
+				break;
+			}
+				
+			case PIPELINE_FLAT_MAP:
+			default:
+				if (!callStage(run, current, iterator->value, &result)) return PIPELINE_FAILED;
+				state->sequence = result;
+				state->iterator = NULL_VAL;
+				return drainStage(run, stage);
+		}
+	}
+	return PIPELINE_PASSED;
+}
 
-DEF_NATIVE(map_instantiate)
-	RETURN_OBJ(cardinalNewMap(vm));
-END_NATIVE
+// Runs the remaining values of the sequence of the flatMap at [stage] through
+// the stages after it, until one comes out at the end.
+static PipelineResult drainStage(PipelineRun* run, int stage) {
+	PipelineStageState* state = &run->iterator->stages[stage];
+	for (;;) {
+		Value value;
+		bool hasValue;
+		if (!nextInSequence(run, state->sequence, &state->iterator, &hasValue, &value)) {
+			return PIPELINE_FAILED;
+		}
+		if (!hasValue) break;
+		
+		PipelineResult result = feedPipeline(run, stage + 1, value);
+		if (result != PIPELINE_DROPPED) return result;
+	}
+	
+	state->sequence = NULL_VAL;
+	state->iterator = NULL_VAL;
+	return PIPELINE_DROPPED;
+}
 
-DEF_NATIVE(map_subscript)
-	if (!validateKey(vm, args, 1)) return PRIM_ERROR;
+// Moves the iterator of [run] to the next value that comes out of the pipeline.
+static PipelineResult advancePipeline(PipelineRun* run) {
+	ObjPipeline* pipeline = run->pipeline;
+	ObjPipelineIterator* iterator = run->iterator;
+	
+	// Finish the sequences of flatMap stages first, innermost first. Once a take
+	// stage has let all its values through, nothing before it needs to run
+	// again.
+	for (int stage = pipeline->numStages - 1; stage >= 0; stage--) {
+		PipelineStage* current = &pipeline->stages[stage];
+		PipelineStageState* state = &iterator->stages[stage];
+		
+		if (current->kind == PIPELINE_TAKE && state->count >= AS_NUM(current->arg)) {
+			return PIPELINE_DONE;
+		}
+		if (current->kind == PIPELINE_FLAT_MAP && !IS_NULL(state->sequence)) {
+			PipelineResult result = drainStage(run, stage);
+			if (result != PIPELINE_DROPPED) return result;
+		}
+	}
+	
+	for (;;) {
+		Value value;
+		bool hasValue;
+		if (!nextInSequence(run, pipeline->source, &iterator->sourceIterator, &hasValue, &value)) {
+			return PIPELINE_FAILED;
+		}
+		if (!hasValue) return PIPELINE_DONE;
+		
+		PipelineResult result = feedPipeline(run, 0, value);
+		if (result != PIPELINE_DROPPED) return result;
+	}
+}
 
-	ObjMap* map = AS_MAP(args[0]);
-	uint32_t index = cardinalMapFind(map, args[1]);
-	if (index == UINT32_MAX) RETURN_NULL;
+// Returns the iterator in args[1] of the pipeline in args[0], or NULL and
+// reports an error if it is not an iterator of the pipeline.
+static ObjPipelineIterator* validatePipelineIterator(CardinalVM* vm, Value* args) {
+	if (IS_PIPELINE_ITERATOR(args[1]) &&
+	        AS_PIPELINE_ITERATOR(args[1])->pipeline == AS_PIPELINE(args[0])) {
+		return AS_PIPELINE_ITERATOR(args[1]);
+	}
+	
+	args[0] = cardinalNewString(vm, "Iterator must belong to the pipeline.", 37);
+	return NULL;
+}
 
-	RETURN_VAL(map->entries[index].value);
+DEF_NATIVE(pipeline_new)
+	RETURN_OBJ(cardinalNewPipeline(vm, args[1], 0));
 END_NATIVE
 
-DEF_NATIVE(map_subscriptSetter)
-	if (!validateKey(vm, args, 1)) return PRIM_ERROR;
+// Returns a copy of the pipeline in args[0] with a stage of [kind] added, that
+// uses args[1].
+static PrimitiveResult addStage(CardinalVM* vm, Value* args, PipelineStageKind kind) {
+	ObjPipeline* pipeline = AS_PIPELINE(args[0]);
+	ObjPipeline* result = cardinalNewPipeline(vm, pipeline->source, pipeline->numStages + 1);
+	memcpy(result->stages, pipeline->stages, sizeof(PipelineStage) * pipeline->numStages);
+	result->stages[pipeline->numStages].kind = kind;
+	result->stages[pipeline->numStages].arg = args[1];
+	RETURN_OBJ(result);
+}
 
-	cardinalMapSet(vm, AS_MAP(args[0]), args[1], args[2]);
-	RETURN_VAL(args[2]);
+DEF_NATIVE(pipeline_map)
+	return addStage(vm, args, PIPELINE_MAP);
 END_NATIVE
 
-DEF_NATIVE(map_clear)
-	cardinalMapClear(vm, AS_MAP(args[0]));
-	RETURN_NULL;
+DEF_NATIVE(pipeline_where)
+	return addStage(vm, args, PIPELINE_WHERE);
 END_NATIVE
 
-DEF_NATIVE(map_containsKey)
-	if (!validateKey(vm, args, 1)) return PRIM_ERROR;
-
-	RETURN_BOOL(cardinalMapFind(AS_MAP(args[0]), args[1]) != UINT32_MAX);
+DEF_NATIVE(pipeline_take)
+	if (!validateInt(vm, args, 1, "Count")) return PRIM_ERROR;
+	return addStage(vm, args, PIPELINE_TAKE);
 END_NATIVE
 
-DEF_NATIVE(map_count)
-	RETURN_NUM(AS_MAP(args[0])->count);
+DEF_NATIVE(pipeline_skip)
+	if (!validateInt(vm, args, 1, "Count")) return PRIM_ERROR;
+	return addStage(vm, args, PIPELINE_SKIP);
 END_NATIVE
 
-DEF_NATIVE(map_iterate)
-	ObjMap* map = AS_MAP(args[0]);
-
-	if (map->count == 0) RETURN_FALSE;
-
-	// If we're starting the iteration, start at the first used entry.
-	uint32_t index = 0;
-
-	// Otherwise, start one past the last entry we stopped at.
-	if (!IS_NULL(args[1])) {
-		if (!validateInt(vm, args, 1, "Iterator")) return PRIM_ERROR;
-
-		if (AS_NUM(args[1]) < 0) RETURN_FALSE;
-		index = (uint32_t)AS_NUM(args[1]);
-
-		if (index >= map->capacity) RETURN_FALSE;
-
-		// Advance the iterator.
-		index++;
-	}
-
-	// Find a used entry, if any.
-	for (; index < map->capacity; index++) {
-		if (!IS_UNDEFINED(map->entries[index].key)) RETURN_NUM(index);
-	}
-
-	// If we get here, walked all of the entries.
-	RETURN_FALSE;
+DEF_NATIVE(pipeline_takeWhile)
+	return addStage(vm, args, PIPELINE_TAKE_WHILE);
 END_NATIVE
 
-DEF_NATIVE(map_remove)
-	if (!validateKey(vm, args, 1)) return PRIM_ERROR;
+DEF_NATIVE(pipeline_zip)
+	return addStage(vm, args, PIPELINE_ZIP);
+END_NATIVE
 
-	RETURN_VAL(cardinalMapRemoveKey(vm, AS_MAP(args[0]), args[1]));
+DEF_NATIVE(pipeline_flatMap)
+	return addStage(vm, args, PIPELINE_FLAT_MAP);
 END_NATIVE
 
-DEF_NATIVE(map_keyIteratorValue)
-	ObjMap* map = AS_MAP(args[0]);
-	int index = validateIndex(vm, args, map->capacity, 1, "Iterator");
-	if (index == -1) return PRIM_ERROR;
+DEF_NATIVE(pipeline_iterate)
+	ObjPipeline* pipeline = AS_PIPELINE(args[0]);
 
-	MapEntry* entry = &map->entries[index];
-	if (IS_UNDEFINED(entry->key)) {
-		RETURN_ERROR("Invalid map iterator value.");
+	// If we're starting the iteration, create the iterator.
+	if (IS_NULL(args[1])) {
+		args[1] = OBJ_VAL(cardinalNewPipelineIterator(vm, pipeline));
 	}
-
-	RETURN_VAL(entry->key);
+	
+	ObjPipelineIterator* iterator = validatePipelineIterator(vm, args);
+	if (iterator == NULL) return PRIM_ERROR;
+	
+	// A stage may advance the same iterator again, which would reuse the fibers
+	// that are running.
+	if (iterator->isBusy) RETURN_ERROR("Pipeline iterator is already being advanced.");
+	
+	PipelineRun run;
+	run.vm = vm;
+	run.pipeline = pipeline;
+	run.iterator = iterator;
+	run.iterateSymbol = cardinalSymbolTableFind(&vm->methodNames, "iterate(_)", 10);
+	run.iteratorValueSymbol = cardinalSymbolTableFind(&vm->methodNames, "iteratorValue(_)", 16);
+	run.error = NULL_VAL;
+	
+	iterator->isBusy = true;
+	PipelineResult result = advancePipeline(&run);
+	iterator->isBusy = false;
+	
+	if (result == PIPELINE_FAILED) {
+		args[0] = run.error;
+		return PRIM_ERROR;
+	}
+	if (result == PIPELINE_DONE) RETURN_FALSE;
+	RETURN_VAL(args[1]);
 END_NATIVE
 
-DEF_NATIVE(map_valueIteratorValue)
-	ObjMap* map = AS_MAP(args[0]);
-	int index = validateIndex(vm, args, map->capacity, 1, "Iterator");
-	if (index == -1) return PRIM_ERROR;
-
-	MapEntry* entry = &map->entries[index];
-	if (IS_UNDEFINED(entry->key)) {
-		RETURN_ERROR("Invalid map iterator value.");
-	}
+DEF_NATIVE(pipeline_iteratorValue)
+	ObjPipelineIterator* iterator = validatePipelineIterator(vm, args);
+	if (iterator == NULL) return PRIM_ERROR;
 
-	RETURN_VAL(entry->value);
+	RETURN_VAL(iterator->value);
 END_NATIVE
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -1945,11 +3884,12 @@ END_NATIVE
 ///////////////////////////////////////////////////////////////////////////////////
 
 DEF_NATIVE(range_toString)
-	char buffer[51];
+	char buffer[NUMBER_BUFFER_SIZE * 2 + 3];
 	ObjRange* range = AS_RANGE(args[0]);
-	sprintf(buffer, "%.14g%s%.14g", range->from,
-	        range->isInclusive ? ".." : "...", range->to);
-	RETURN_VAL(cardinalNewString(vm, buffer, strlen(buffer)));
+	int length = cardinalFormatNumber(range->from, buffer);
+	length += sprintf(buffer + length, "%s", range->isInclusive ? ".." : "...");
+	length += cardinalFormatNumber(range->to, buffer + length);
+	RETURN_VAL(cardinalNewString(vm, buffer, length));
 END_NATIVE
 
 DEF_NATIVE(range_from)
@@ -2036,10 +3976,12 @@ DEF_NATIVE(num_atan2)
 END_NATIVE
 
 DEF_NATIVE(num_abs)
+	if (IS_INT(args[0])) RETURN_INT(llabs(AS_INT(args[0])));
 	RETURN_NUM(fabs(AS_NUM(args[0])));
 END_NATIVE
 
 DEF_NATIVE(num_ceil)
+	if (IS_INT(args[0])) RETURN_VAL(args[0]);
 	RETURN_NUM(ceil(AS_NUM(args[0])));
 END_NATIVE
 
@@ -2048,6 +3990,7 @@ DEF_NATIVE(num_cos)
 END_NATIVE
 
 DEF_NATIVE(num_floor)
+	if (IS_INT(args[0])) RETURN_VAL(args[0]);
 	RETURN_NUM(floor(AS_NUM(args[0])));
 END_NATIVE
 
@@ -2064,31 +4007,17 @@ DEF_NATIVE(num_sqrt)
 END_NATIVE
 
 DEF_NATIVE(num_toString)
-	double value = AS_NUM(args[0]);
-
-	// Corner case: If the value is NaN, different versions of libc produce
-	// different outputs (some will format it signed and some won't). To get
-	// reliable output, handle that ourselves.
-	if (value != value) RETURN_VAL(cardinalNewString(vm, "nan", 3));
-
-	// This is large enough to hold any double converted to a string using
-	// "%.14g". Example:
-	//
-	//     -1.12345678901234e-1022
-	//
-	// So we have:
-	//
-	// + 1 char for sign
-	// + 1 char for digit
-	// + 1 char for "."
-	// + 14 chars for decimal digits
-	// + 1 char for "e"
-	// + 1 char for "-" or "+"
-	// + 4 chars for exponent
-	// + 1 char for "\0"
-	// = 24
-	char buffer[24];
-	int length = sprintf(buffer, "%.14g", value);
+	// Small integers skip the search for the shortest digits.
+	if (IS_INT(args[0])) {
+		char buffer[NUMBER_BUFFER_SIZE];
+		int length = cardinalFormatInteger(AS_INT(args[0]), buffer);
+		RETURN_VAL(cardinalNewString(vm, buffer, length));
+	}
+	
+	// Other numbers get the shortest digits that read back as the same number,
+	// so no precision is lost when they are printed and parsed again.
+	char buffer[NUMBER_BUFFER_SIZE];
+	int length = cardinalFormatNumber(AS_NUM(args[0]), buffer);
 	RETURN_VAL(cardinalNewString(vm, buffer, length));
 END_NATIVE
 
@@ -2102,7 +4031,7 @@ DEF_NATIVE(num_fromString)
 
 	//errno = 0;
 	char* end;
-	double number = strtod(string->value, &end);
+	double number = cardinalParseNumber(string->value, &end);
 
 	// Skip past any trailing whitespace.
 	while (*end != '\0' && isspace(*end)) end++;
@@ -2127,12 +4056,12 @@ END_NATIVE
 	if (string->length == 0) RETURN_NULL; \
 \
 	char* end; \
-	double number = (double) strtol(string->value, &end, system); \
+	long long number = strtoll(string->value, &end, system); \
 \
 	while (*end != '\0' && isspace(*end)) end++; \
 	if (end < string->value + string->length) RETURN_NULL; \
 \
-	RETURN_NUM(number);
+	RETURN_INT(number);
 
 DEF_NATIVE(num_fromStringHex)
 	STRING_TO_NUMBER(16)
@@ -2143,6 +4072,8 @@ DEF_NATIVE(num_fromStringBin)
 END_NATIVE
 
 DEF_NATIVE(num_truncate)
+	if (IS_INT(args[0])) RETURN_VAL(args[0]);
+	
 	double integer;
 	modf(AS_NUM(args[0]) , &integer);
 	RETURN_NUM(integer);
@@ -2174,114 +4105,165 @@ DEF_NATIVE(num_fraction)
 	RETURN_NUM(modf(AS_NUM(args[0]) , &dummy));
 END_NATIVE
 
+// Returns true if both operands of a Num operator are small integers.
+#define INT_OPERANDS(args) (IS_INT(args[0]) && IS_INT(args[1]))
+
 DEF_NATIVE(num_negate)
+	// Negating zero gives negative zero, which only a double can hold.
+	if (IS_INT(args[0]) && AS_INT(args[0]) != 0) RETURN_INT(-AS_INT(args[0]));
 	RETURN_NUM(-AS_NUM(args[0]));
 END_NATIVE
 
 DEF_NATIVE(num_minus)
+	// The result of two small integers always fits in 64 bits. If it leaves the
+	// small integer range, it becomes a double.
+	if (INT_OPERANDS(args)) RETURN_INT(AS_INT(args[0]) - AS_INT(args[1]));
+	
 	if (!validateNum(vm, args, 1, "Right operand")) return PRIM_ERROR;
 	RETURN_NUM(AS_NUM(args[0]) - AS_NUM(args[1]));
 END_NATIVE
 
 DEF_NATIVE(num_plus)
+	if (INT_OPERANDS(args)) RETURN_INT(AS_INT(args[0]) + AS_INT(args[1]));
+	
 	if (!validateNum(vm, args, 1, "Right operand")) return PRIM_ERROR;
 	RETURN_NUM(AS_NUM(args[0]) + AS_NUM(args[1]));
 END_NATIVE
 
 DEF_NATIVE(num_multiply)
+	if (INT_OPERANDS(args)) {
+		int64_t left = AS_INT(args[0]);
+		int64_t right = AS_INT(args[1]);
+		
+		// Factors that fit in 32 bits can't overflow. A zero product with a
+		// negative factor is negative zero.
+		if (left == (int32_t) left && right == (int32_t) right &&
+		        (left * right != 0 || (left >= 0 && right >= 0))) {
+			RETURN_INT(left * right);
+		}
+	}
+	
 	if (!validateNum(vm, args, 1, "Right operand")) return PRIM_ERROR;
 	RETURN_NUM(AS_NUM(args[0]) * AS_NUM(args[1]));
 END_NATIVE
 
 DEF_NATIVE(num_divide)
+	if (INT_OPERANDS(args)) {
+		int64_t left = AS_INT(args[0]);
+		int64_t right = AS_INT(args[1]);
+		
+		// Only exact quotients stay integers.
+		if (right != 0 && left % right == 0 && (left != 0 || right > 0)) {
+			RETURN_INT(left / right);
+		}
+	}
+	
 	if (!validateNum(vm, args, 1, "Right operand")) return PRIM_ERROR;
 	RETURN_NUM(AS_NUM(args[0]) / AS_NUM(args[1]));
 END_NATIVE
 
 DEF_NATIVE(num_mod)
+	if (INT_OPERANDS(args)) {
+		int64_t left = AS_INT(args[0]);
+		int64_t right = AS_INT(args[1]);
+		
+		// Like fmod, the remainder has the sign of the dividend, so a negative
+		// dividend without remainder gives negative zero.
+		if (right != 0 && (left >= 0 || left % right != 0)) RETURN_INT(left % right);
+	}
+	
 	if (!validateNum(vm, args, 1, "Right operand")) return PRIM_ERROR;
 	RETURN_NUM(fmod(AS_NUM(args[0]), AS_NUM(args[1])));
 END_NATIVE
 
 DEF_NATIVE(num_lt)
+	if (INT_OPERANDS(args)) RETURN_BOOL(AS_INT(args[0]) < AS_INT(args[1]));
+	
 	if (!validateNum(vm, args, 1, "Right operand")) return PRIM_ERROR;
 	RETURN_BOOL(AS_NUM(args[0]) < AS_NUM(args[1]));
 END_NATIVE
 
 DEF_NATIVE(num_gt)
+	if (INT_OPERANDS(args)) RETURN_BOOL(AS_INT(args[0]) > AS_INT(args[1]));
+	
 	if (!validateNum(vm, args, 1, "Right operand")) return PRIM_ERROR;
 	RETURN_BOOL(AS_NUM(args[0]) > AS_NUM(args[1]));
 END_NATIVE
 
 DEF_NATIVE(num_lte)
+	if (INT_OPERANDS(args)) RETURN_BOOL(AS_INT(args[0]) <= AS_INT(args[1]));
+	
 	if (!validateNum(vm, args, 1, "Right operand")) return PRIM_ERROR;
 	RETURN_BOOL(AS_NUM(args[0]) <= AS_NUM(args[1]));
 END_NATIVE
 
 DEF_NATIVE(num_gte)
+	if (INT_OPERANDS(args)) RETURN_BOOL(AS_INT(args[0]) >= AS_INT(args[1]));
+	
 	if (!validateNum(vm, args, 1, "Right operand")) return PRIM_ERROR;
 	RETURN_BOOL(AS_NUM(args[0]) >= AS_NUM(args[1]));
 END_NATIVE
 
 DEF_NATIVE(num_eqeq)
+	if (INT_OPERANDS(args)) RETURN_BOOL(AS_INT(args[0]) == AS_INT(args[1]));
+	
 	if (!IS_NUM(args[1])) RETURN_FALSE;
 	RETURN_BOOL(AS_NUM(args[0]) == AS_NUM(args[1]));
 END_NATIVE
 
 DEF_NATIVE(num_bangeq)
+	if (INT_OPERANDS(args)) RETURN_BOOL(AS_INT(args[0]) != AS_INT(args[1]));
+	
 	if (!IS_NUM(args[1])) RETURN_TRUE;
 	RETURN_BOOL(AS_NUM(args[0]) != AS_NUM(args[1]));
 END_NATIVE
 
+// Converts the number [value] to the unsigned integer the bitwise operators
+// work on. Small integers are converted without going through a double.
+static cardinal_uinteger bitwiseOperand(Value value) {
+	if (IS_INT(value)) return (cardinal_uinteger) AS_INT(value);
+	return (cardinal_uinteger) AS_NUM(value);
+}
+
+// Converts the result of a bitwise operator to a number.
+static Value bitwiseResult(cardinal_uinteger value) {
+	if (value <= (cardinal_uinteger) SMALL_INT_MAX) return INT_VAL((int64_t) value);
+	return NUM_VAL((double) value);
+}
+
 DEF_NATIVE(num_bitwiseNot)
-	// Bitwise operators always work on 32-bit unsigned ints.
-	cardinal_uinteger value = (cardinal_uinteger)AS_NUM(args[0]);
-	RETURN_NUM((double) ~value);
+	// Bitwise operators always work on unsigned ints.
+	RETURN_VAL(bitwiseResult(~bitwiseOperand(args[0])));
 END_NATIVE
 
 DEF_NATIVE(num_bitwiseAnd)
 	if (!validateNum(vm, args, 1, "Right operand")) return PRIM_ERROR;
 
-	// Bitwise operators always work on 32-bit unsigned ints.
-	cardinal_uinteger left = (cardinal_uinteger)AS_NUM(args[0]);
-	cardinal_uinteger right = (cardinal_uinteger)AS_NUM(args[1]);
-	RETURN_NUM((double) (left & right));
+	RETURN_VAL(bitwiseResult(bitwiseOperand(args[0]) & bitwiseOperand(args[1])));
 END_NATIVE
 
 DEF_NATIVE(num_bitwiseOr)
 	if (!validateNum(vm, args, 1, "Right operand")) return PRIM_ERROR;
 
-	// Bitwise operators always work on 32-bit unsigned ints.
-	cardinal_uinteger left = (cardinal_uinteger)AS_NUM(args[0]);
-	cardinal_uinteger right = (cardinal_uinteger)AS_NUM(args[1]);
-	RETURN_NUM((double) (left | right));
+	RETURN_VAL(bitwiseResult(bitwiseOperand(args[0]) | bitwiseOperand(args[1])));
 END_NATIVE
 
 DEF_NATIVE(num_bitwiseXor)
 	if (!validateNum(vm, args, 1, "Right operand")) return PRIM_ERROR;
 
-	// Bitwise operators always work on 32-bit unsigned ints.
-	cardinal_uinteger left = (cardinal_uinteger)AS_NUM(args[0]);
-	cardinal_uinteger right = (cardinal_uinteger)AS_NUM(args[1]);
-	RETURN_NUM(left ^ right);
+	RETURN_VAL(bitwiseResult(bitwiseOperand(args[0]) ^ bitwiseOperand(args[1])));
 END_NATIVE
 
 DEF_NATIVE(num_bitwiseLeftShift)
 	if (!validateNum(vm, args, 1, "Right operand")) return PRIM_ERROR;
 
-	// Bitwise operators always work on 32-bit unsigned ints.
-	cardinal_uinteger left = (cardinal_uinteger)AS_NUM(args[0]);
-	cardinal_uinteger right = (cardinal_uinteger)AS_NUM(args[1]);
-	RETURN_NUM(left << right);
+	RETURN_VAL(bitwiseResult(bitwiseOperand(args[0]) << bitwiseOperand(args[1])));
 END_NATIVE
 
 DEF_NATIVE(num_bitwiseRightShift)
 	if (!validateNum(vm, args, 1, "Right operand")) return PRIM_ERROR;
 
-	// Bitwise operators always work on 32-bit unsigned ints.
-	cardinal_uinteger left = (cardinal_uinteger)AS_NUM(args[0]);
-	cardinal_uinteger right = (cardinal_uinteger)AS_NUM(args[1]);
-	RETURN_NUM(left >> right);
+	RETURN_VAL(bitwiseResult(bitwiseOperand(args[0]) >> bitwiseOperand(args[1])));
 END_NATIVE
 
 DEF_NATIVE(num_dotDot)
@@ -2448,7 +4430,7 @@ END_NATIVE
 DEF_NATIVE(table_containsKey)
 	if (!validateKey(vm, args, 1)) return PRIM_ERROR;
 
-	RETURN_BOOL(IS_NULL(cardinalTableFind(vm, AS_TABLE(args[0]), args[1]) ) ) ;
+	RETURN_BOOL(cardinalTableContains(AS_TABLE(args[0]), args[1]));
 END_NATIVE
 
 DEF_NATIVE(table_add)
@@ -2462,11 +4444,7 @@ DEF_NATIVE(table_toString)
 END_NATIVE
 
 DEF_NATIVE(table_clear)
-	ObjTable* list = AS_TABLE(args[0]);
-	cardinalReallocate(vm, list->hashmap, 0, 0);
-	list->hashmap = NULL;
-	list->capacity = 0;
-	list->count = 0;
+	cardinalTableClear(vm, AS_TABLE(args[0]));
 	RETURN_NULL;
 END_NATIVE
 
@@ -2519,9 +4497,9 @@ DEF_NATIVE(table_iterate)
 	}
 
 	// Find a used entry, if any.
-	HashValue* val = cardinalGetTableIndex(map, index);
-	if (val == NULL) RETURN_FALSE;
-	RETURN_NUM(index);
+	int next = cardinalTableNext(map, index);
+	if (next == -1) RETURN_FALSE;
+	RETURN_NUM(next);
 END_NATIVE
 
 DEF_NATIVE(table_keyIteratorValue)
@@ -2529,8 +4507,8 @@ DEF_NATIVE(table_keyIteratorValue)
 	int index = validateIndex(vm, args, map->capacity, 1, "Iterator");
 	if (index == -1) return PRIM_ERROR;
 
-	HashValue* entry = cardinalGetTableIndex(map, index);
-	if (entry == NULL || IS_UNDEFINED(entry->key)) {
+	MapEntry* entry = &map->entries[index];
+	if (IS_UNDEFINED(entry->key)) {
 		RETURN_ERROR("Invalid map iterator value.");
 	}
 
@@ -2539,16 +4517,16 @@ END_NATIVE
 
 DEF_NATIVE(table_get)
 	ObjTable* map = AS_TABLE(args[0]);
-	int index = validateIndex(vm, args, map->capacity, 1, "Iterator");
+	int index = validateIndex(vm, args, map->count, 1, "Iterator");
 	if (index == -1) return PRIM_ERROR;
 	
 	// Index is the x-th element we want to acces
-	HashValue* entry = cardinalGetTableIndex(map, index);
-	if (entry == NULL || IS_UNDEFINED(entry->key)) {
+	MapEntry* entry = cardinalGetTableIndex(map, index);
+	if (entry == NULL) {
 		RETURN_ERROR("Invalid map iterator value.");
 	}
 
-	RETURN_VAL(entry->val);
+	RETURN_VAL(entry->value);
 END_NATIVE
 
 DEF_NATIVE(table_valueIteratorValue)
@@ -2556,13 +4534,12 @@ DEF_NATIVE(table_valueIteratorValue)
 	int index = validateIndex(vm, args, map->capacity, 1, "Iterator");
 	if (index == -1) return PRIM_ERROR;
 
-	// Index is the x-th element we want to acces
-	HashValue* entry = cardinalGetTableIndex(map, index);
-	if (entry == NULL || IS_UNDEFINED(entry->key)) {
+	MapEntry* entry = &map->entries[index];
+	if (IS_UNDEFINED(entry->key)) {
 		RETURN_ERROR("Invalid map iterator value.");
 	}
 
-	RETURN_VAL(entry->val);
+	RETURN_VAL(entry->value);
 END_NATIVE
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -2637,8 +4614,11 @@ static void runCodeParam(CardinalVM* vm) {
 static void getHostObject(CardinalVM* vm) {
 	double ind = cardinalGetArgumentDouble(vm, 1);
 	
-	CardinalValue* val = cardinalCreateValue(vm);
-	val->value = ind;
+	CardinalValue* val = cardinalHostObjectAt(vm, (int) ind);
+	if (val == NULL) {
+		cardinalReturnNull(vm);
+		return;
+	}
 	
 	cardinalReturnValue(vm, val);
 }
@@ -2647,9 +4627,8 @@ static void setHostObject(CardinalVM* vm) {
 	CardinalValue* obj = cardinalGetArgument(vm, 2);
 	double ind = cardinalGetArgumentDouble(vm, 1);
 	
-	CardinalValue val;
-	val.value = ind;
-	cardinalSetHostObject(vm, cardinalGetHostObject(vm, obj), &val);
+	CardinalValue* val = cardinalHostObjectAt(vm, (int) ind);
+	if (val != NULL) cardinalSetHostObject(vm, cardinalGetHostObject(vm, obj), val);
 	cardinalRemoveHostObject(vm, obj);
 }
 
@@ -2657,6 +4636,16 @@ static void collect(CardinalVM* vm) {
 	cardinalCollectGarbage(vm);
 }
 
+static void systemClock(CardinalVM* vm) {
+	cardinalReturnDouble(vm, (double)clock() / CLOCKS_PER_SEC);
+}
+
+static void systemMemory(CardinalVM* vm) {
+	size_t usage, peak, limit;
+	cardinalGetMemoryStatistics(vm, &usage, &peak, &limit);
+	cardinalReturnDouble(vm, (double) usage);
+}
+
 static void setGC(CardinalVM* vm) {
 	cardinalEnableGC(vm, cardinalGetArgumentBool(vm, 1));
 }
@@ -2672,6 +4661,14 @@ static void listStatistics(CardinalVM* vm) {
 	vm->printFunction(" new objects:           %d\n", gcNewObjects);
 	vm->printFunction(" start new cycle:       %d\n", gcNext);
 	vm->printFunction(" number of host objects:%d\n", nbHosts);
+	
+	size_t usage, peak, limit;
+	cardinalGetMemoryStatistics(vm, &usage, &peak, &limit);
+	
+	vm->printFunction("Memory:\n");
+	vm->printFunction(" in use:                %lu\n", (unsigned long) usage);
+	vm->printFunction(" peak:                  %lu\n", (unsigned long) peak);
+	vm->printFunction(" limit:                 %lu\n", (unsigned long) limit);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -2952,6 +4949,12 @@ void cardinalInitializeCore(CardinalVM* vm) {
 	NATIVE(vm->metatable.stringClass, "count", string_count);
 	NATIVE(vm->metatable.stringClass, "endsWith(_)", string_endsWith);
 	NATIVE(vm->metatable.stringClass, "indexOf(_)", string_indexOf);
+	NATIVE(vm->metatable.stringClass, "indexOf(_,_)", string_indexOfStart);
+	NATIVE(vm->metatable.stringClass, "split(_)", string_split);
+	NATIVE(vm->metatable.stringClass, "replace(_,_)", string_replace);
+	NATIVE(vm->metatable.stringClass, "trim()", string_trim);
+	NATIVE(vm->metatable.stringClass, "trimStart()", string_trimStart);
+	NATIVE(vm->metatable.stringClass, "trimEnd()", string_trimEnd);
 	NATIVE(vm->metatable.stringClass, "iterate(_)", string_iterate);
 	NATIVE(vm->metatable.stringClass, "iteratorValue(_)", string_iteratorValue);
 	NATIVE(vm->metatable.stringClass, "startsWith(_)", string_startsWith);
@@ -2960,12 +4963,127 @@ void cardinalInitializeCore(CardinalVM* vm) {
 	NATIVE(vm->metatable.stringClass->obj.classObj, "fromCodePoint(_)", string_fromCodePoint);
 	NATIVE(vm->metatable.stringClass, "byteAt(_)", string_byteAt);
 	NATIVE(vm->metatable.stringClass, "codePointAt(_)", string_codePointAt);
+	NATIVE(vm->metatable.stringClass, "codePointCount", string_codePointCount);
+	NATIVE(vm->metatable.stringClass, "charAt(_)", string_charAt);
+	NATIVE(vm->metatable.stringClass, "byteOffset(_)", string_byteOffset);
 	NATIVE(vm->metatable.stringClass, "iterateByte_(_)", string_iterateByte);
 	
+	// STRINGBUILDER
+	vm->metatable.stringBuilderClass = AS_CLASS(cardinalFindVariable(vm, "StringBuilder"));
+	NATIVE(vm->metatable.stringBuilderClass->obj.classObj, "<instantiate>", stringBuilder_instantiate);
+	NATIVE(vm->metatable.stringBuilderClass->obj.classObj, "new()", stringBuilder_instantiate);
+	NATIVE(vm->metatable.stringBuilderClass, "addString_(_)", stringBuilder_addString);
+	NATIVE(vm->metatable.stringBuilderClass, "count", stringBuilder_count);
+	NATIVE(vm->metatable.stringBuilderClass, "clear()", stringBuilder_clear);
+	NATIVE(vm->metatable.stringBuilderClass, "toString", stringBuilder_toString);
+	
+	// TYPEDARRAY
+	vm->metatable.typedArrayClass = AS_CLASS(cardinalFindVariable(vm, "TypedArray"));
+	NATIVE(vm->metatable.typedArrayClass, "count", typedArray_count);
+	NATIVE(vm->metatable.typedArrayClass, "[_]", typedArray_subscript);
+	NATIVE(vm->metatable.typedArrayClass, "[_]=(_)", typedArray_subscriptSetter);
+	NATIVE(vm->metatable.typedArrayClass, "fill(_)", typedArray_fill);
+	NATIVE(vm->metatable.typedArrayClass, "copy(_)", typedArray_copy);
+	NATIVE(vm->metatable.typedArrayClass, "iterate(_)", typedArray_iterate);
+	NATIVE(vm->metatable.typedArrayClass, "iteratorValue(_)", typedArray_iteratorValue);
+	NATIVE(vm->metatable.typedArrayClass, "add(_)", typedArray_add);
+	NATIVE(vm->metatable.typedArrayClass, "add(_,_)", typedArray_addInto);
+	NATIVE(vm->metatable.typedArrayClass, "sub(_)", typedArray_sub);
+	NATIVE(vm->metatable.typedArrayClass, "sub(_,_)", typedArray_subInto);
+	NATIVE(vm->metatable.typedArrayClass, "mul(_)", typedArray_mul);
+	NATIVE(vm->metatable.typedArrayClass, "mul(_,_)", typedArray_mulInto);
+	NATIVE(vm->metatable.typedArrayClass, "scale(_)", typedArray_scale);
+	NATIVE(vm->metatable.typedArrayClass, "scale(_,_)", typedArray_scaleInto);
+	NATIVE(vm->metatable.typedArrayClass, "fma(_,_)", typedArray_fma);
+	NATIVE(vm->metatable.typedArrayClass, "fma(_,_,_)", typedArray_fmaInto);
+	NATIVE(vm->metatable.typedArrayClass, "lerp(_,_)", typedArray_lerp);
+	NATIVE(vm->metatable.typedArrayClass, "lerp(_,_,_)", typedArray_lerpInto);
+	NATIVE(vm->metatable.typedArrayClass, "clamp(_,_)", typedArray_clamp);
+	NATIVE(vm->metatable.typedArrayClass, "clamp(_,_,_)", typedArray_clampInto);
+	NATIVE(vm->metatable.typedArrayClass, "sum", typedArray_sum);
+	NATIVE(vm->metatable.typedArrayClass, "dot(_)", typedArray_dot);
+	NATIVE(vm->metatable.typedArrayClass, "min", typedArray_min);
+	NATIVE(vm->metatable.typedArrayClass, "max", typedArray_max);
+
+	// DEQUE
+	vm->metatable.dequeClass = AS_CLASS(cardinalFindVariable(vm, "Deque"));
+	NATIVE(vm->metatable.dequeClass->obj.classObj, "<instantiate>", deque_instantiate);
+	NATIVE(vm->metatable.dequeClass->obj.classObj, "new()", deque_instantiate);
+	NATIVE(vm->metatable.dequeClass->obj.classObj, "new", deque_instantiate);
+	NATIVE(vm->metatable.dequeClass, "add(_)", deque_pushBack);
+	NATIVE(vm->metatable.dequeClass, "pushBack(_)", deque_pushBack);
+	NATIVE(vm->metatable.dequeClass, "pushFront(_)", deque_pushFront);
+	NATIVE(vm->metatable.dequeClass, "popBack()", deque_popBack);
+	NATIVE(vm->metatable.dequeClass, "popFront()", deque_popFront);
+	NATIVE(vm->metatable.dequeClass, "first", deque_first);
+	NATIVE(vm->metatable.dequeClass, "last", deque_last);
+	NATIVE(vm->metatable.dequeClass, "count", deque_count);
+	NATIVE(vm->metatable.dequeClass, "isEmpty", deque_isEmpty);
+	NATIVE(vm->metatable.dequeClass, "clear()", deque_clear);
+	NATIVE(vm->metatable.dequeClass, "[_]", deque_subscript);
+	NATIVE(vm->metatable.dequeClass, "[_]=(_)", deque_subscriptSetter);
+	NATIVE(vm->metatable.dequeClass, "iterate(_)", deque_iterate);
+	NATIVE(vm->metatable.dequeClass, "iteratorValue(_)", deque_iteratorValue);
+
+	// SET
+	vm->metatable.setClass = AS_CLASS(cardinalFindVariable(vm, "Set"));
+	NATIVE(vm->metatable.setClass->obj.classObj, "<instantiate>", set_instantiate);
+	NATIVE(vm->metatable.setClass->obj.classObj, "new()", set_instantiate);
+	NATIVE(vm->metatable.setClass->obj.classObj, "new", set_instantiate);
+	NATIVE(vm->metatable.setClass->obj.classObj, "new(_)", set_newFrom);
+	NATIVE(vm->metatable.setClass, "add(_)", set_add);
+	NATIVE(vm->metatable.setClass, "remove(_)", set_remove);
+	NATIVE(vm->metatable.setClass, "contains(_)", set_contains);
+	NATIVE(vm->metatable.setClass, "count", map_count);
+	NATIVE(vm->metatable.setClass, "isEmpty", set_isEmpty);
+	NATIVE(vm->metatable.setClass, "clear()", map_clear);
+	NATIVE(vm->metatable.setClass, "union(_)", set_union);
+	NATIVE(vm->metatable.setClass, "intersection(_)", set_intersection);
+	NATIVE(vm->metatable.setClass, "difference(_)", set_difference);
+	NATIVE(vm->metatable.setClass, "iterate(_)", map_iterate);
+	NATIVE(vm->metatable.setClass, "iteratorValue(_)", map_keyIteratorValue);
+
+	// PRIORITY QUEUE
+	vm->metatable.priorityQueueClass = AS_CLASS(cardinalFindVariable(vm, "PriorityQueue"));
+	NATIVE(vm->metatable.priorityQueueClass->obj.classObj, "<instantiate>", priorityQueue_instantiate);
+	NATIVE(vm->metatable.priorityQueueClass->obj.classObj, "new()", priorityQueue_instantiate);
+	NATIVE(vm->metatable.priorityQueueClass->obj.classObj, "new", priorityQueue_instantiate);
+	NATIVE(vm->metatable.priorityQueueClass->obj.classObj, "new(_)", priorityQueue_newWithComparator);
+	NATIVE(vm->metatable.priorityQueueClass, "add(_)", priorityQueue_push);
+	NATIVE(vm->metatable.priorityQueueClass, "push(_)", priorityQueue_push);
+	NATIVE(vm->metatable.priorityQueueClass, "pop()", priorityQueue_pop);
+	NATIVE(vm->metatable.priorityQueueClass, "first", priorityQueue_first);
+	NATIVE(vm->metatable.priorityQueueClass, "count", priorityQueue_count);
+	NATIVE(vm->metatable.priorityQueueClass, "isEmpty", priorityQueue_isEmpty);
+	NATIVE(vm->metatable.priorityQueueClass, "clear()", priorityQueue_clear);
+	NATIVE(vm->metatable.priorityQueueClass, "iterate(_)", priorityQueue_iterate);
+	NATIVE(vm->metatable.priorityQueueClass, "iteratorValue(_)", priorityQueue_iteratorValue);
+
+	// PIPELINE
+	vm->metatable.pipelineClass = AS_CLASS(cardinalFindVariable(vm, "SequencePipeline"));
+	NATIVE(vm->metatable.pipelineClass->obj.classObj, "new(_)", pipeline_new);
+	NATIVE(vm->metatable.pipelineClass, "map(_)", pipeline_map);
+	NATIVE(vm->metatable.pipelineClass, "where(_)", pipeline_where);
+	NATIVE(vm->metatable.pipelineClass, "take(_)", pipeline_take);
+	NATIVE(vm->metatable.pipelineClass, "skip(_)", pipeline_skip);
+	NATIVE(vm->metatable.pipelineClass, "takeWhile(_)", pipeline_takeWhile);
+	NATIVE(vm->metatable.pipelineClass, "zip(_)", pipeline_zip);
+	NATIVE(vm->metatable.pipelineClass, "flatMap(_)", pipeline_flatMap);
+	NATIVE(vm->metatable.pipelineClass, "iterate(_)", pipeline_iterate);
+	NATIVE(vm->metatable.pipelineClass, "iteratorValue(_)", pipeline_iteratorValue);
+	
+	vm->metatable.float64ArrayClass = AS_CLASS(cardinalFindVariable(vm, "Float64Array"));
+	NATIVE(vm->metatable.float64ArrayClass->obj.classObj, "new(_)", typedArray_newFloat64);
+	vm->metatable.int32ArrayClass = AS_CLASS(cardinalFindVariable(vm, "Int32Array"));
+	NATIVE(vm->metatable.int32ArrayClass->obj.classObj, "new(_)", typedArray_newInt32);
+	vm->metatable.byteArrayClass = AS_CLASS(cardinalFindVariable(vm, "ByteArray"));
+	NATIVE(vm->metatable.byteArrayClass->obj.classObj, "new(_)", typedArray_newByte);
+	
 	// LIST
 	vm->metatable.listClass = AS_CLASS(cardinalFindVariable(vm, "List")); 
 	NATIVE(vm->metatable.listClass->obj.classObj, "<instantiate>", list_instantiate);
 	NATIVE(vm->metatable.listClass->obj.classObj, "new()", list_instantiate);
+	NATIVE(vm->metatable.listClass->obj.classObj, "new", list_instantiate);
 	NATIVE(vm->metatable.listClass, "add(_)", list_add);
 	NATIVE(vm->metatable.listClass, "head", list_head);
 	NATIVE(vm->metatable.listClass, "tail", list_tail);
@@ -2980,7 +5098,15 @@ void cardinalInitializeCore(CardinalVM* vm) {
 	NATIVE(vm->metatable.listClass, "iteratorValue(_)", list_iteratorValue);
 	NATIVE(vm->metatable.listClass, "removeAt(_)", list_removeAt);
 	NATIVE(vm->metatable.listClass, "[_]", list_subscript);
-	NATIVE(vm->metatable.listClass, "[_]=", list_subscriptSetter);
+	NATIVE(vm->metatable.listClass, "[_]=(_)", list_subscriptSetter);
+	NATIVE(vm->metatable.listClass, "sum", list_sum);
+	NATIVE(vm->metatable.listClass, "dot(_)", list_dot);
+	NATIVE(vm->metatable.listClass, "min", list_min);
+	NATIVE(vm->metatable.listClass, "max", list_max);
+	NATIVE(vm->metatable.listClass, "sort()", list_sort);
+	NATIVE(vm->metatable.listClass, "sort(_)", list_sortBy);
+	NATIVE(vm->metatable.listClass, "stableSort()", list_stableSort);
+	NATIVE(vm->metatable.listClass, "stableSort(_)", list_stableSortBy);
 
 	// MAP
 	vm->metatable.mapClass = AS_CLASS(cardinalFindVariable(vm, "Map"));
@@ -3036,6 +5162,8 @@ void cardinalInitializeCore(CardinalVM* vm) {
 	cardinalDefineStaticMethod(vm, NULL, "System", "printGC()", listStatistics);
 	cardinalDefineStaticMethod(vm, NULL, "System", "setGC(_)", setGC);
 	cardinalDefineStaticMethod(vm, NULL, "System", "collect()", collect);
+	cardinalDefineStaticMethod(vm, NULL, "System", "clock", systemClock);
+	cardinalDefineStaticMethod(vm, NULL, "System", "memory", systemMemory);
 
 	// While bootstrapping the core types and running the core library, a number
 	// string objects have been created, many of which were instantiated before
@@ -351,7 +351,31 @@ static int debugPrintInstruction(CardinalVM* vm, ObjFn* fn, int i, int* lastLine
 			break;
 		}
 
+		case CODE_FOR_RANGE_SETUP: {
+			int slot = READ_LOCAL();
+			int offset = READ_OFFSET();
+			printf("%-16s %5d to %d\n", "FOR_RANGE_SETUP", slot, i + offset);
+			break;
+		}
+
+		case CODE_FOR_RANGE: {
+			int slot = READ_LOCAL();
+			int isInclusive = READ_BOOL();
+			int exitOffset = READ_OFFSET();
+			int bodyOffset = READ_OFFSET();
+			printf("%-16s %5d %s exit %d body %d\n", "FOR_RANGE", slot,
+			       isInclusive ? ".." : "...", i + exitOffset, i + bodyOffset);
+			break;
+		}
+
 		case CODE_IS:            printf("CODE_IS\n"); break;
+
+		case CODE_CONCAT_N: {
+			int numParts = READ_BYTE();
+			printf("%-16s %5d\n", "CONCAT_N", numParts);
+			break;
+		}
+
 		case CODE_CLOSE_UPVALUE: printf("CLOSE_UPVALUE\n"); break;
 		case CODE_RETURN:        printf("CODE_RETURN\n"); break;
 
@@ -556,9 +580,12 @@ void checkDebugger(CardinalVM* vm) {
 			break;
 		}
 		case CODE_JUMP:
+		case CODE_FOR_RANGE_SETUP:
+		case CODE_FOR_RANGE:
 		case CODE_AND:
 		case CODE_OR:
 		case CODE_IS:
+		case CODE_CONCAT_N:
 		case CODE_CLOSE_UPVALUE:
 		case CODE_CLOSURE:
 			break;
@@ -451,4 +451,12 @@ static void listStatistics(CardinalVM* vm) {
 	printf(" new objects:           %d\n", gcNewObjects);
 	printf(" start new cycle:       %d\n", gcNext);
 	printf(" number of host objects:%d\n", nbHosts);
+	
+	size_t usage, peak, limit;
+	cardinalGetMemoryStatistics(vm, &usage, &peak, &limit);
+	
+	printf("Memory:\n");
+	printf(" in use:                %lu\n", (unsigned long) usage);
+	printf(" peak:                  %lu\n", (unsigned long) peak);
+	printf(" limit:                 %lu\n", (unsigned long) limit);
 }
\ No newline at end of file
@@ -0,0 +1,488 @@
+#include <ctype.h>
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cardinal_number.h"
+
+///////////////////////////////////////////////////////////////////////////////////
+//// FORMATTING
+///////////////////////////////////////////////////////////////////////////////////
+
+// Numbers with more digits than this before the decimal point are written with
+// an exponent.
+#define PLAIN_DIGITS_MAX (14)
+
+// The smallest integer that has more than [PLAIN_DIGITS_MAX] digits.
+#define PLAIN_INTEGER_LIMIT (INT64_C(100000000000000))
+
+// The digits are generated with the Grisu2 algorithm from "Printing
+// Floating-Point Numbers Quickly and Accurately with Integers" by Florian
+// Loitsch. It only needs 64 bit integer arithmetic, and its digits always read
+// back as the same double. In rare cases there is one digit more than needed.
+
+// A number with a 64 bit significand: f * 2^e.
+typedef struct DiyFp {
+	/// The significand
+	uint64_t f;
+	/// The binary exponent
+	int e;
+} DiyFp;
+
+#define DOUBLE_SIGNIFICAND_SIZE (52)
+#define DOUBLE_EXPONENT_BIAS (0x3ff + DOUBLE_SIGNIFICAND_SIZE)
+#define DOUBLE_HIDDEN_BIT ((uint64_t)1 << DOUBLE_SIGNIFICAND_SIZE)
+#define DOUBLE_SIGNIFICAND_MASK (DOUBLE_HIDDEN_BIT - 1)
+#define DOUBLE_EXPONENT_MASK ((uint64_t)0x7ff << DOUBLE_SIGNIFICAND_SIZE)
+
+// The normalized significands and binary exponents of the powers of ten from
+// 10^-348 to 10^340 in steps of eight, rounded to the nearest 64 bit value.
+static const uint64_t cachedPowerSignificands[] = {
+	UINT64_C(0xfa8fd5a0081c0288), UINT64_C(0xbaaee17fa23ebf76), UINT64_C(0x8b16fb203055ac76),
+	UINT64_C(0xcf42894a5dce35ea), UINT64_C(0x9a6bb0aa55653b2d), UINT64_C(0xe61acf033d1a45df),
+	UINT64_C(0xab70fe17c79ac6ca), UINT64_C(0xff77b1fcbebcdc4f), UINT64_C(0xbe5691ef416bd60c),
+	UINT64_C(0x8dd01fad907ffc3c), UINT64_C(0xd3515c2831559a83), UINT64_C(0x9d71ac8fada6c9b5),
+	UINT64_C(0xea9c227723ee8bcb), UINT64_C(0xaecc49914078536d), UINT64_C(0x823c12795db6ce57),
+	UINT64_C(0xc21094364dfb5637), UINT64_C(0x9096ea6f3848984f), UINT64_C(0xd77485cb25823ac7),
+	UINT64_C(0xa086cfcd97bf97f4), UINT64_C(0xef340a98172aace5), UINT64_C(0xb23867fb2a35b28e),
+	UINT64_C(0x84c8d4dfd2c63f3b), UINT64_C(0xc5dd44271ad3cdba), UINT64_C(0x936b9fcebb25c996),
+	UINT64_C(0xdbac6c247d62a584), UINT64_C(0xa3ab66580d5fdaf6), UINT64_C(0xf3e2f893dec3f126),
+	UINT64_C(0xb5b5ada8aaff80b8), UINT64_C(0x87625f056c7c4a8b), UINT64_C(0xc9bcff6034c13053),
+	UINT64_C(0x964e858c91ba2655), UINT64_C(0xdff9772470297ebd), UINT64_C(0xa6dfbd9fb8e5b88f),
+	UINT64_C(0xf8a95fcf88747d94), UINT64_C(0xb94470938fa89bcf), UINT64_C(0x8a08f0f8bf0f156b),
+	UINT64_C(0xcdb02555653131b6), UINT64_C(0x993fe2c6d07b7fac), UINT64_C(0xe45c10c42a2b3b06),
+	UINT64_C(0xaa242499697392d3), UINT64_C(0xfd87b5f28300ca0e), UINT64_C(0xbce5086492111aeb),
+	UINT64_C(0x8cbccc096f5088cc), UINT64_C(0xd1b71758e219652c), UINT64_C(0x9c40000000000000),
+	UINT64_C(0xe8d4a51000000000), UINT64_C(0xad78ebc5ac620000), UINT64_C(0x813f3978f8940984),
+	UINT64_C(0xc097ce7bc90715b3), UINT64_C(0x8f7e32ce7bea5c70), UINT64_C(0xd5d238a4abe98068),
+	UINT64_C(0x9f4f2726179a2245), UINT64_C(0xed63a231d4c4fb27), UINT64_C(0xb0de65388cc8ada8),
+	UINT64_C(0x83c7088e1aab65db), UINT64_C(0xc45d1df942711d9a), UINT64_C(0x924d692ca61be758),
+	UINT64_C(0xda01ee641a708dea), UINT64_C(0xa26da3999aef774a), UINT64_C(0xf209787bb47d6b85),
+	UINT64_C(0xb454e4a179dd1877), UINT64_C(0x865b86925b9bc5c2), UINT64_C(0xc83553c5c8965d3d),
+	UINT64_C(0x952ab45cfa97a0b3), UINT64_C(0xde469fbd99a05fe3), UINT64_C(0xa59bc234db398c25),
+	UINT64_C(0xf6c69a72a3989f5c), UINT64_C(0xb7dcbf5354e9bece), UINT64_C(0x88fcf317f22241e2),
+	UINT64_C(0xcc20ce9bd35c78a5), UINT64_C(0x98165af37b2153df), UINT64_C(0xe2a0b5dc971f303a),
+	UINT64_C(0xa8d9d1535ce3b396), UINT64_C(0xfb9b7cd9a4a7443c), UINT64_C(0xbb764c4ca7a44410),
+	UINT64_C(0x8bab8eefb6409c1a), UINT64_C(0xd01fef10a657842c), UINT64_C(0x9b10a4e5e9913129),
+	UINT64_C(0xe7109bfba19c0c9d), UINT64_C(0xac2820d9623bf429), UINT64_C(0x80444b5e7aa7cf85),
+	UINT64_C(0xbf21e44003acdd2d), UINT64_C(0x8e679c2f5e44ff8f), UINT64_C(0xd433179d9c8cb841),
+	UINT64_C(0x9e19db92b4e31ba9), UINT64_C(0xeb96bf6ebadf77d9), UINT64_C(0xaf87023b9bf0ee6b)
+};
+
+static const int cachedPowerExponents[] = {
+	-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+	-954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+	-688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+	-422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+	-157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+	109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+	375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+	641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+	907, 933, 960, 986, 1013, 1039, 1066
+};
+
+// Powers of ten, up to the largest one that fits in 64 bits.
+static const uint64_t powersOfTen[] = {
+	UINT64_C(1), UINT64_C(10), UINT64_C(100), UINT64_C(1000), UINT64_C(10000),
+	UINT64_C(100000), UINT64_C(1000000), UINT64_C(10000000), UINT64_C(100000000),
+	UINT64_C(1000000000), UINT64_C(10000000000), UINT64_C(100000000000),
+	UINT64_C(1000000000000), UINT64_C(10000000000000), UINT64_C(100000000000000),
+	UINT64_C(1000000000000000), UINT64_C(10000000000000000),
+	UINT64_C(100000000000000000), UINT64_C(1000000000000000000),
+	UINT64_C(10000000000000000000)
+};
+
+static DiyFp makeDiyFp(uint64_t f, int e) {
+	DiyFp fp;
+	fp.f = f;
+	fp.e = e;
+	return fp;
+}
+
+// Splits the positive, finite [value] into its significand and exponent.
+static DiyFp diyFpFromDouble(double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	int biasedExponent = (int)((bits & DOUBLE_EXPONENT_MASK) >> DOUBLE_SIGNIFICAND_SIZE);
+	uint64_t significand = bits & DOUBLE_SIGNIFICAND_MASK;
+
+	// Denormals have no hidden bit, and share the exponent of the smallest
+	// normal numbers.
+	if (biasedExponent == 0) return makeDiyFp(significand, 1 - DOUBLE_EXPONENT_BIAS);
+	return makeDiyFp(significand + DOUBLE_HIDDEN_BIT, biasedExponent - DOUBLE_EXPONENT_BIAS);
+}
+
+// Returns the product of [a] and [b], with the significand rounded to its
+// upper 64 bits.
+static DiyFp multiplyDiyFp(DiyFp a, DiyFp b) {
+	const uint64_t mask = 0xffffffff;
+	uint64_t aHigh = a.f >> 32;
+	uint64_t aLow = a.f & mask;
+	uint64_t bHigh = b.f >> 32;
+	uint64_t bLow = b.f & mask;
+
+	uint64_t highHigh = aHigh * bHigh;
+	uint64_t lowHigh = aLow * bHigh;
+	uint64_t highLow = aHigh * bLow;
+	uint64_t lowLow = aLow * bLow;
+
+	uint64_t middle = (lowLow >> 32) + (highLow & mask) + (lowHigh & mask);
+	middle += (uint64_t)1 << 31;
+
+	return makeDiyFp(highHigh + (highLow >> 32) + (lowHigh >> 32) + (middle >> 32),
+	                 a.e + b.e + 64);
+}
+
+// Shifts the significand of [fp] left until its highest bit is set.
+static DiyFp normalizeDiyFp(DiyFp fp) {
+	while ((fp.f & ((uint64_t)1 << 63)) == 0) {
+		fp.f <<= 1;
+		fp.e--;
+	}
+	return fp;
+}
+
+// Calculates the normalized bounds of the numbers that are closer to [v] than
+// to its neighbouring doubles. Both get the exponent of the upper bound.
+static void boundaries(DiyFp v, DiyFp* lower, DiyFp* upper) {
+	DiyFp plus = makeDiyFp((v.f << 1) + 1, v.e - 1);
+	while ((plus.f & (DOUBLE_HIDDEN_BIT << 1)) == 0) {
+		plus.f <<= 1;
+		plus.e--;
+	}
+	plus.f <<= 64 - DOUBLE_SIGNIFICAND_SIZE - 2;
+	plus.e -= 64 - DOUBLE_SIGNIFICAND_SIZE - 2;
+
+	// Below a power of two, the neighbouring double is twice as close.
+	DiyFp minus;
+	if (v.f == DOUBLE_HIDDEN_BIT) {
+		minus = makeDiyFp((v.f << 2) - 1, v.e - 2);
+	}
+	else {
+		minus = makeDiyFp((v.f << 1) - 1, v.e - 1);
+	}
+	minus.f <<= minus.e - plus.e;
+	minus.e = plus.e;
+
+	*lower = minus;
+	*upper = plus;
+}
+
+// Returns the cached power of ten that brings a number with binary exponent
+// [e] into the range Grisu works in, and stores its negated decimal exponent
+// in [k].
+static DiyFp cachedPower(int e, int* k) {
+	double estimate = (-61 - e) * 0.30102999566398114 + 347;
+	int exponent = (int) estimate;
+	if (estimate - exponent > 0.0) exponent++;
+
+	int index = (exponent >> 3) + 1;
+	*k = -(-348 + index * 8);
+	return makeDiyFp(cachedPowerSignificands[index], cachedPowerExponents[index]);
+}
+
+// Moves the last of the [count] [digits] down while that brings the number
+// closer to the exact value and keeps it within [delta].
+static void roundDigits(char* digits, int count, uint64_t delta, uint64_t rest,
+                        uint64_t tenKappa, uint64_t distance) {
+	while (rest < distance && delta - rest >= tenKappa &&
+	        (rest + tenKappa < distance || distance - rest > rest + tenKappa - distance)) {
+		digits[count - 1]--;
+		rest += tenKappa;
+	}
+}
+
+// Returns the number of decimal digits of [value].
+static int countDigits(uint32_t value) {
+	int count = 1;
+	while (count < 10 && value >= powersOfTen[count]) count++;
+	return count;
+}
+
+// Generates the digits of [w], which lies within [delta] below [upper], and
+// adds the position of the last digit to [k].
+static void generateDigits(DiyFp w, DiyFp upper, uint64_t delta, char* digits,
+                           int* count, int* k) {
+	DiyFp one = makeDiyFp((uint64_t)1 << -upper.e, upper.e);
+	uint64_t distance = upper.f - w.f;
+
+	// Split [upper] into its integral and fractional part.
+	uint32_t integral = (uint32_t)(upper.f >> -one.e);
+	uint64_t fraction = upper.f & (one.f - 1);
+
+	int kappa = countDigits(integral);
+	*count = 0;
+
+	while (kappa > 0) {
+		uint32_t power = (uint32_t) powersOfTen[kappa - 1];
+		uint32_t digit = integral / power;
+		integral %= power;
+
+		if (digit != 0 || *count != 0) digits[(*count)++] = (char)('0' + digit);
+		kappa--;
+
+		uint64_t rest = ((uint64_t) integral << -one.e) + fraction;
+		if (rest <= delta) {
+			*k += kappa;
+			roundDigits(digits, *count, delta, rest, powersOfTen[kappa] << -one.e, distance);
+			return;
+		}
+	}
+
+	for (;;) {
+		fraction *= 10;
+		delta *= 10;
+
+		char digit = (char)(fraction >> -one.e);
+		if (digit != 0 || *count != 0) digits[(*count)++] = (char)('0' + digit);
+		fraction &= one.f - 1;
+		kappa--;
+
+		if (fraction < delta) {
+			*k += kappa;
+			roundDigits(digits, *count, delta, fraction, one.f, distance * powersOfTen[-kappa]);
+			return;
+		}
+	}
+}
+
+// Generates the digits of the positive, finite [value]. The value is the
+// digits times 10 to the power of [exponent].
+static void grisu2(double value, char* digits, int* count, int* exponent) {
+	DiyFp v = diyFpFromDouble(value);
+	DiyFp lower;
+	DiyFp upper;
+	boundaries(v, &lower, &upper);
+
+	int k;
+	DiyFp power = cachedPower(upper.e, &k);
+	DiyFp w = multiplyDiyFp(normalizeDiyFp(v), power);
+	DiyFp scaledUpper = multiplyDiyFp(upper, power);
+	DiyFp scaledLower = multiplyDiyFp(lower, power);
+
+	// Stay inside the bounds despite the rounding of the multiplications.
+	scaledLower.f++;
+	scaledUpper.f--;
+
+	*exponent = k;
+	generateDigits(w, scaledUpper, scaledUpper.f - scaledLower.f, digits, count, exponent);
+}
+
+// Writes the decimal [exponent] as "%g" does, with a sign and at least two
+// digits, and returns the number of characters written.
+static int writeExponent(int exponent, char* out) {
+	char* start = out;
+	*out++ = 'e';
+	if (exponent < 0) {
+		*out++ = '-';
+		exponent = -exponent;
+	}
+	else {
+		*out++ = '+';
+	}
+
+	if (exponent >= 100) {
+		*out++ = (char)('0' + exponent / 100);
+		exponent %= 100;
+	}
+	*out++ = (char)('0' + exponent / 10);
+	*out++ = (char)('0' + exponent % 10);
+	return (int)(out - start);
+}
+
+int cardinalFormatNumber(double value, char* buffer) {
+	// Different versions of libc format NaN differently, so it is always
+	// written the same way here.
+	if (value != value) {
+		memcpy(buffer, "nan", 4);
+		return 3;
+	}
+
+	char* out = buffer;
+	if (signbit(value)) {
+		*out++ = '-';
+		value = -value;
+	}
+
+	if (isinf(value)) {
+		memcpy(out, "inf", 4);
+		return (int)(out - buffer) + 3;
+	}
+
+	if (value == 0) {
+		memcpy(out, "0", 2);
+		return (int)(out - buffer) + 1;
+	}
+
+	char digits[20];
+	int count;
+	int exponent;
+	grisu2(value, digits, &count, &exponent);
+
+	// Like "%g", don't write trailing zeros.
+	while (count > 1 && digits[count - 1] == '0') {
+		count--;
+		exponent++;
+	}
+
+	// The position of the decimal point relative to the first digit.
+	int point = count + exponent;
+
+	if (point - 1 < -4 || point > PLAIN_DIGITS_MAX) {
+		*out++ = digits[0];
+		if (count > 1) {
+			*out++ = '.';
+			memcpy(out, digits + 1, count - 1);
+			out += count - 1;
+		}
+		out += writeExponent(point - 1, out);
+	}
+	else if (point <= 0) {
+		*out++ = '0';
+		*out++ = '.';
+		memset(out, '0', -point);
+		out += -point;
+		memcpy(out, digits, count);
+		out += count;
+	}
+	else if (point >= count) {
+		memcpy(out, digits, count);
+		out += count;
+		memset(out, '0', point - count);
+		out += point - count;
+	}
+	else {
+		memcpy(out, digits, point);
+		out += point;
+		*out++ = '.';
+		memcpy(out, digits + point, count - point);
+		out += count - point;
+	}
+
+	*out = '\0';
+	return (int)(out - buffer);
+}
+
+int cardinalFormatInteger(int64_t value, char* buffer) {
+	// Larger integers get an exponent, so they are left to the general case.
+	if (value <= -PLAIN_INTEGER_LIMIT || value >= PLAIN_INTEGER_LIMIT) {
+		return cardinalFormatNumber((double) value, buffer);
+	}
+
+	char* out = buffer;
+	if (value < 0) {
+		*out++ = '-';
+		value = -value;
+	}
+
+	// The digits are generated from the last one.
+	char digits[PLAIN_DIGITS_MAX];
+	int count = 0;
+	do {
+		digits[count++] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+
+	while (count > 0) *out++ = digits[--count];
+	*out = '\0';
+	return (int)(out - buffer);
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+//// PARSING
+///////////////////////////////////////////////////////////////////////////////////
+
+// The powers of ten that doubles hold exactly.
+static const double exactPowersOfTen[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// The fast path needs every operation to round to double precision, which
+// isn't the case when the compiler evaluates in extended precision.
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0
+	#define NUMBER_FAST_PARSE 0
+#else
+	#define NUMBER_FAST_PARSE 1
+#endif
+
+double cardinalParseNumber(const char* text, char** end) {
+	const char* c = text;
+	while (isspace((unsigned char) *c)) c++;
+
+	bool negative = *c == '-';
+	if (*c == '-' || *c == '+') c++;
+
+	// Hexadecimal numbers, infinity and NaN are left to the C library.
+	bool hasDigit = isdigit((unsigned char) c[0]) ||
+	                (c[0] == '.' && isdigit((unsigned char) c[1]));
+	if (!hasDigit || (c[0] == '0' && (c[1] == 'x' || c[1] == 'X'))) return strtod(text, end);
+
+	// Read the significant digits into an integer, and count the position of
+	// the decimal point in [exponent].
+	uint64_t significand = 0;
+	int digits = 0;
+	int exponent = 0;
+
+	while (*c == '0') c++;
+	while (isdigit((unsigned char) *c)) {
+		if (digits < 19) significand = significand * 10 + (uint64_t)(*c - '0');
+		digits++;
+		c++;
+	}
+
+	if (*c == '.') {
+		c++;
+		if (digits == 0) {
+			while (*c == '0') {
+				exponent--;
+				c++;
+			}
+		}
+		while (isdigit((unsigned char) *c)) {
+			if (digits < 19) significand = significand * 10 + (uint64_t)(*c - '0');
+			digits++;
+			exponent--;
+			c++;
+		}
+	}
+
+	// The exponent only belongs to the number if it has digits.
+	if (*c == 'e' || *c == 'E') {
+		const char* e = c + 1;
+		bool negativeExponent = *e == '-';
+		if (*e == '-' || *e == '+') e++;
+
+		if (isdigit((unsigned char) *e)) {
+			int value = 0;
+			while (isdigit((unsigned char) *e)) {
+				if (value < 100000) value = value * 10 + (*e - '0');
+				e++;
+			}
+			exponent += negativeExponent ? -value : value;
+			c = e;
+		}
+	}
+
+	// With at most 2^53 as significand and a power of ten up to 10^22, both
+	// operands are exact doubles, so a single correctly rounded operation gives
+	// the exact result.
+	if (NUMBER_FAST_PARSE && digits <= 19 && significand <= DOUBLE_HIDDEN_BIT &&
+	        exponent >= -22 && exponent <= 22) {
+		double result = (double) significand;
+		if (exponent < 0) {
+			result /= exactPowersOfTen[-exponent];
+		}
+		else {
+			result *= exactPowersOfTen[exponent];
+		}
+
+		if (end != NULL) *end = (char*)(uintptr_t) c;
+		return negative ? -result : result;
+	}
+
+	return strtod(text, end);
+}
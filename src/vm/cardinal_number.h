@@ -0,0 +1,37 @@
+#ifndef cardinal_number_h
+#define cardinal_number_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cardinal_config.h"
+
+// This module converts numbers to and from text without the locale handling
+// of the C library.
+//
+// Numbers are formatted with the shortest digits that read back as the same
+// double, laid out like "%.14g" would: in exponent notation if the decimal
+// exponent is below -4 or at least 14, with trailing zeros removed.
+//
+// Numbers are parsed exactly. Decimal numbers with at most 19 significant
+// digits and a power of ten that fits in a double take a fast path. Every
+// other number is left to strtod.
+
+// The number of bytes a buffer for [cardinalFormatNumber] must hold, including
+// the terminating zero.
+#define NUMBER_BUFFER_SIZE (32)
+
+// Writes [value] to [buffer] as a zero terminated string and returns its
+// length. NaN is written as "nan" and infinities as "inf" and "-inf".
+int cardinalFormatNumber(double value, char* buffer);
+
+// Writes the integer [value] to [buffer] exactly like [cardinalFormatNumber]
+// would, without searching for the shortest digits when it has at most 14.
+int cardinalFormatInteger(int64_t value, char* buffer);
+
+// Parses the number at the start of [text], skipping leading whitespace, like
+// strtod does. If [end] is not NULL, it is set to the character after the
+// number, or to [text] if there is no number.
+double cardinalParseNumber(const char* text, char** end);
+
+#endif
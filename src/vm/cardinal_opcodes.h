@@ -136,9 +136,26 @@ OPCODE(AND)
 // and continue.
 OPCODE(OR)
 
+// Starts a for loop over `from..to` or `from...to`. The locals [arg1] and the
+// one after it hold [from] and [to]. If both are numbers, jump [arg2] forward
+// past the code that creates a range object from them.
+OPCODE(FOR_RANGE_SETUP)
+
+// Advances a for loop over a range of numbers without creating the range. The
+// locals [arg1], [arg1] + 1 and [arg1] + 2 hold from, to and the iterator, and
+// [arg2] is true if the range includes [to]. If [to] is not a number, the range
+// is an object and the instruction does nothing. Otherwise it pushes the next
+// number and jumps [arg4] forward to the loop body, or pushes false and jumps
+// [arg3] forward to the loop exit test. Both offsets start after [arg4].
+OPCODE(FOR_RANGE)
+
 // Pop [a] then [b] and push true if [b] is an instance of [a].
 OPCODE(IS)
 
+// Pop [arg] strings and push their concatenation, allocating the result once.
+// Used for string interpolation and chains of "+" that start with a string.
+OPCODE(CONCAT_N)
+
 // Close the upvalue for the local on the top of the stack) then pop it.
 OPCODE(CLOSE_UPVALUE)
 
@@ -0,0 +1,356 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "cardinal_simd.h"
+
+// AVX kernels need the compiler to generate AVX code for single functions,
+// and a way to ask the processor whether it supports AVX.
+#if CARDINAL_SIMD && (defined(__GNUC__) || defined(_MSC_VER))
+	#define SIMD_AVX 1
+#else
+	#define SIMD_AVX 0
+#endif
+
+#if CARDINAL_SIMD
+	#include <emmintrin.h>
+#endif
+
+#if SIMD_AVX
+	#include <immintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+	#endif
+#endif
+
+// The table of kernels for one instruction set.
+typedef struct SimdKernels {
+	/// The name of the instruction set
+	const char* name;
+
+	void (*add)(double* dst, const double* a, const double* b, double bScalar, size_t count);
+	void (*sub)(double* dst, const double* a, const double* b, double bScalar, size_t count);
+	void (*mul)(double* dst, const double* a, const double* b, double bScalar, size_t count);
+	void (*fma)(double* dst, const double* a, const double* b, double bScalar, const double* c, size_t count);
+	void (*clamp)(double* dst, const double* a, double low, double high, size_t count);
+	void (*lerp)(double* dst, const double* a, const double* b, double bScalar, double t, size_t count);
+	double (*sum)(const double* a, size_t count);
+	double (*dot)(const double* a, const double* b, size_t count);
+	double (*min)(const double* a, size_t count);
+	double (*max)(const double* a, size_t count);
+} SimdKernels;
+
+#define SIMD_TABLE(name, suffix) { name, add##suffix, sub##suffix, mul##suffix, \
+	fma##suffix, clamp##suffix, lerp##suffix, sum##suffix, dot##suffix, min##suffix, max##suffix }
+
+///////////////////////////////////////////////////////////////////////////////////
+//// SCALAR
+///////////////////////////////////////////////////////////////////////////////////
+
+#if !CARDINAL_SIMD
+
+#define SIMD_KERNEL(name) name##Scalar
+#define SIMD_TARGET
+#define SimdVector double
+#define SIMD_WIDTH 1
+#define SIMD_LOAD(p) (*(p))
+#define SIMD_STORE(p, v) (*(p) = (v))
+#define SIMD_SET(x) (x)
+#define SIMD_ADD(a, b) ((a) + (b))
+#define SIMD_SUB(a, b) ((a) - (b))
+#define SIMD_MUL(a, b) ((a) * (b))
+#define SIMD_MIN(a, b) ((a) < (b) ? (a) : (b))
+#define SIMD_MAX(a, b) ((a) > (b) ? (a) : (b))
+#define SIMD_HSUM(v) (v)
+#define SIMD_HMIN(v) (v)
+#define SIMD_HMAX(v) (v)
+
+#include "cardinal_simd_kernels.h"
+
+static const SimdKernels scalarKernels = SIMD_TABLE("scalar", Scalar);
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////
+//// SSE2
+///////////////////////////////////////////////////////////////////////////////////
+
+#if CARDINAL_SIMD
+
+static inline double hsumSse2(__m128d v) {
+	return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+static inline double hminSse2(__m128d v) {
+	return _mm_cvtsd_f64(_mm_min_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+static inline double hmaxSse2(__m128d v) {
+	return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+#define SIMD_KERNEL(name) name##Sse2
+#define SIMD_TARGET
+#define SimdVector __m128d
+#define SIMD_WIDTH 2
+#define SIMD_LOAD(p) _mm_loadu_pd(p)
+#define SIMD_STORE(p, v) _mm_storeu_pd(p, v)
+#define SIMD_SET(x) _mm_set1_pd(x)
+#define SIMD_ADD(a, b) _mm_add_pd(a, b)
+#define SIMD_SUB(a, b) _mm_sub_pd(a, b)
+#define SIMD_MUL(a, b) _mm_mul_pd(a, b)
+#define SIMD_MIN(a, b) _mm_min_pd(a, b)
+#define SIMD_MAX(a, b) _mm_max_pd(a, b)
+#define SIMD_HSUM(v) hsumSse2(v)
+#define SIMD_HMIN(v) hminSse2(v)
+#define SIMD_HMAX(v) hmaxSse2(v)
+
+#include "cardinal_simd_kernels.h"
+
+static const SimdKernels sse2Kernels = SIMD_TABLE("sse2", Sse2);
+
+#undef SIMD_KERNEL
+#undef SIMD_TARGET
+#undef SimdVector
+#undef SIMD_WIDTH
+#undef SIMD_LOAD
+#undef SIMD_STORE
+#undef SIMD_SET
+#undef SIMD_ADD
+#undef SIMD_SUB
+#undef SIMD_MUL
+#undef SIMD_MIN
+#undef SIMD_MAX
+#undef SIMD_HSUM
+#undef SIMD_HMIN
+#undef SIMD_HMAX
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////
+//// AVX
+///////////////////////////////////////////////////////////////////////////////////
+
+#if SIMD_AVX
+
+#if defined(_MSC_VER)
+	#define SIMD_AVX_TARGET
+#else
+	#define SIMD_AVX_TARGET __attribute__((target("avx")))
+#endif
+
+// The 256 bit vector is first folded into a 128 bit one.
+static inline SIMD_AVX_TARGET double hsumAvx(__m256d v) {
+	return hsumSse2(_mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+}
+
+static inline SIMD_AVX_TARGET double hminAvx(__m256d v) {
+	return hminSse2(_mm_min_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+}
+
+static inline SIMD_AVX_TARGET double hmaxAvx(__m256d v) {
+	return hmaxSse2(_mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+}
+
+#define SIMD_KERNEL(name) name##Avx
+#define SIMD_TARGET SIMD_AVX_TARGET
+#define SimdVector __m256d
+#define SIMD_WIDTH 4
+#define SIMD_LOAD(p) _mm256_loadu_pd(p)
+#define SIMD_STORE(p, v) _mm256_storeu_pd(p, v)
+#define SIMD_SET(x) _mm256_set1_pd(x)
+#define SIMD_ADD(a, b) _mm256_add_pd(a, b)
+#define SIMD_SUB(a, b) _mm256_sub_pd(a, b)
+#define SIMD_MUL(a, b) _mm256_mul_pd(a, b)
+#define SIMD_MIN(a, b) _mm256_min_pd(a, b)
+#define SIMD_MAX(a, b) _mm256_max_pd(a, b)
+#define SIMD_HSUM(v) hsumAvx(v)
+#define SIMD_HMIN(v) hminAvx(v)
+#define SIMD_HMAX(v) hmaxAvx(v)
+
+#include "cardinal_simd_kernels.h"
+
+static const SimdKernels avxKernels = SIMD_TABLE("avx", Avx);
+
+// Returns true if both the processor and the operating system support AVX.
+static bool cpuSupportsAvx() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+
+	// The processor has to support AVX and the XSAVE feature the operating
+	// system uses to save the AVX registers.
+	bool hasAvx = (info[2] & (1 << 28)) != 0;
+	bool hasOsxsave = (info[2] & (1 << 27)) != 0;
+	if (!hasAvx || !hasOsxsave) return false;
+
+	// The operating system has to actually save the AVX registers.
+	return (_xgetbv(0) & 6) == 6;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx") != 0;
+#endif
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////
+//// DISPATCH
+///////////////////////////////////////////////////////////////////////////////////
+
+// The kernels for this machine, or NULL before the first kernel is called.
+static const SimdKernels* kernels = NULL;
+
+static const SimdKernels* currentKernels() {
+	if (kernels != NULL) return kernels;
+
+#if SIMD_AVX
+	if (cpuSupportsAvx()) {
+		kernels = &avxKernels;
+		return kernels;
+	}
+#endif
+
+#if CARDINAL_SIMD
+	kernels = &sse2Kernels;
+#else
+	kernels = &scalarKernels;
+#endif
+	return kernels;
+}
+
+void cardinalSimdAdd(double* dst, const double* a, const double* b, double bScalar, size_t count) {
+	currentKernels()->add(dst, a, b, bScalar, count);
+}
+
+void cardinalSimdSub(double* dst, const double* a, const double* b, double bScalar, size_t count) {
+	currentKernels()->sub(dst, a, b, bScalar, count);
+}
+
+void cardinalSimdMul(double* dst, const double* a, const double* b, double bScalar, size_t count) {
+	currentKernels()->mul(dst, a, b, bScalar, count);
+}
+
+void cardinalSimdFma(double* dst, const double* a, const double* b, double bScalar, const double* c, size_t count) {
+	currentKernels()->fma(dst, a, b, bScalar, c, count);
+}
+
+void cardinalSimdClamp(double* dst, const double* a, double low, double high, size_t count) {
+	currentKernels()->clamp(dst, a, low, high, count);
+}
+
+void cardinalSimdLerp(double* dst, const double* a, const double* b, double bScalar, double t, size_t count) {
+	currentKernels()->lerp(dst, a, b, bScalar, t, count);
+}
+
+double cardinalSimdSum(const double* a, size_t count) {
+	return currentKernels()->sum(a, count);
+}
+
+double cardinalSimdDot(const double* a, const double* b, size_t count) {
+	return currentKernels()->dot(a, b, count);
+}
+
+double cardinalSimdMin(const double* a, size_t count) {
+	return currentKernels()->min(a, count);
+}
+
+double cardinalSimdMax(const double* a, size_t count) {
+	return currentKernels()->max(a, count);
+}
+
+const char* cardinalSimdInstructionSet() {
+	return currentKernels()->name;
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+//// BYTES
+///////////////////////////////////////////////////////////////////////////////////
+
+#if CARDINAL_SIMD
+
+// Returns the index of the lowest bit set in [mask], which is not zero.
+static inline int lowestBit(int mask) {
+#if defined(_MSC_VER)
+	unsigned long bit;
+	_BitScanForward(&bit, (unsigned long) mask);
+	return (int) bit;
+#else
+	return __builtin_ctz((unsigned int) mask);
+#endif
+}
+
+#endif
+
+bool cardinalSimdIsAscii(const char* bytes, size_t count) {
+	size_t index = 0;
+	
+#if CARDINAL_SIMD
+	// Collect the high bits of 16 bytes at once.
+	__m128i bits = _mm_setzero_si128();
+	for (; index + 16 <= count; index += 16) {
+		bits = _mm_or_si128(bits, _mm_loadu_si128((const __m128i*)(bytes + index)));
+	}
+	if (_mm_movemask_epi8(bits) != 0) return false;
+#endif
+
+	for (; index < count; index++) {
+		if (bytes[index] & 0x80) return false;
+	}
+	return true;
+}
+
+size_t cardinalSimdFindByte(const char* bytes, size_t count, char byte) {
+	size_t index = 0;
+	
+#if CARDINAL_SIMD
+	__m128i pattern = _mm_set1_epi8(byte);
+	for (; index + 16 <= count; index += 16) {
+		__m128i block = _mm_loadu_si128((const __m128i*)(bytes + index));
+		int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern));
+		if (mask != 0) return index + lowestBit(mask);
+	}
+#endif
+
+	for (; index < count; index++) {
+		if (bytes[index] == byte) return index;
+	}
+	return SIZE_MAX;
+}
+
+size_t cardinalSimdFind(const char* haystack, size_t length, const char* needle, size_t needleLength) {
+	if (needleLength == 0) return 0;
+	if (needleLength > length) return SIZE_MAX;
+	if (needleLength == 1) return cardinalSimdFindByte(haystack, length, needle[0]);
+	
+	// Only a window whose first and last bytes match the needle has to be
+	// compared in full. That filter rejects almost every window in ordinary text.
+	size_t last = needleLength - 1;
+	size_t windows = length - last;
+	size_t index = 0;
+	
+#if CARDINAL_SIMD
+	// Test the first and last bytes of 16 windows at once.
+	__m128i firstBytes = _mm_set1_epi8(needle[0]);
+	__m128i lastBytes = _mm_set1_epi8(needle[last]);
+	for (; index + 16 <= windows; index += 16) {
+		__m128i starts = _mm_loadu_si128((const __m128i*)(haystack + index));
+		__m128i ends = _mm_loadu_si128((const __m128i*)(haystack + index + last));
+		int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(starts, firstBytes),
+		                                           _mm_cmpeq_epi8(ends, lastBytes)));
+		
+		while (mask != 0) {
+			size_t start = index + lowestBit(mask);
+			if (memcmp(haystack + start + 1, needle + 1, needleLength - 2) == 0) return start;
+			mask &= mask - 1;
+		}
+	}
+#endif
+
+	for (; index < windows; index++) {
+		if (haystack[index] == needle[0] && haystack[index + last] == needle[last] &&
+		        memcmp(haystack + index + 1, needle + 1, needleLength - 2) == 0) {
+			return index;
+		}
+	}
+	return SIZE_MAX;
+}
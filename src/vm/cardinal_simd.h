@@ -0,0 +1,73 @@
+#ifndef cardinal_simd_h
+#define cardinal_simd_h
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cardinal_config.h"
+
+// This module contains the bulk numeric kernels behind the element-wise methods
+// of typed arrays. Every kernel works on plain arrays of doubles and has three
+// implementations: a plain loop, an SSE2 one and an AVX one. The fastest one
+// the processor supports is picked the first time a kernel is called.
+//
+// The element-wise kernels write [count] results to [dst]. [dst] may be the
+// same array as any of the sources, but must not partially overlap one. When
+// an optional source pointer is NULL, the matching scalar is used for every
+// element instead.
+//
+// The reductions add up their elements in a different order depending on the
+// instruction set, so their results may differ in the last bits between
+// machines. Elements that are NaN give an unspecified minimum or maximum.
+//
+// The byte kernels at the end search strings. They use SSE2 whenever the
+// numeric kernels can, since every processor with SIMD support has it.
+
+// dst[i] = a[i] + b[i]
+void cardinalSimdAdd(double* dst, const double* a, const double* b, double bScalar, size_t count);
+
+// dst[i] = a[i] - b[i]
+void cardinalSimdSub(double* dst, const double* a, const double* b, double bScalar, size_t count);
+
+// dst[i] = a[i] * b[i]
+void cardinalSimdMul(double* dst, const double* a, const double* b, double bScalar, size_t count);
+
+// dst[i] = a[i] * b[i] + c[i]
+void cardinalSimdFma(double* dst, const double* a, const double* b, double bScalar, const double* c, size_t count);
+
+// dst[i] = a[i] clamped to [low, high]
+void cardinalSimdClamp(double* dst, const double* a, double low, double high, size_t count);
+
+// dst[i] = a[i] + (b[i] - a[i]) * t
+void cardinalSimdLerp(double* dst, const double* a, const double* b, double bScalar, double t, size_t count);
+
+// Returns the sum of the elements in [a].
+double cardinalSimdSum(const double* a, size_t count);
+
+// Returns the sum of the products of the elements in [a] and [b].
+double cardinalSimdDot(const double* a, const double* b, size_t count);
+
+// Returns the smallest element in [a]. [count] must be at least one.
+double cardinalSimdMin(const double* a, size_t count);
+
+// Returns the largest element in [a]. [count] must be at least one.
+double cardinalSimdMax(const double* a, size_t count);
+
+// Returns true if none of the [count] bytes at [bytes] has its high bit set,
+// which means they are all ASCII characters.
+bool cardinalSimdIsAscii(const char* bytes, size_t count);
+
+// Returns the index of the first [byte] in the [count] bytes at [bytes], or
+// SIZE_MAX if there is none.
+size_t cardinalSimdFindByte(const char* bytes, size_t count, char byte);
+
+// Returns the index of the first occurrence of the [needleLength] bytes at
+// [needle] in the [length] bytes at [haystack], or SIZE_MAX if there is none.
+// An empty needle is found at index zero.
+size_t cardinalSimdFind(const char* haystack, size_t length, const char* needle, size_t needleLength);
+
+// Returns the name of the instruction set the kernels use on this machine:
+// "avx", "sse2" or "scalar".
+const char* cardinalSimdInstructionSet();
+
+#endif
@@ -0,0 +1,155 @@
+// The bodies of the bulk numeric kernels, written once for all instruction
+// sets. There is no include guard: cardinal_simd.c includes this file once for
+// every instruction set, after defining these macros:
+//
+//		SIMD_KERNEL(name)	The name of a kernel for this instruction set.
+//		SIMD_TARGET			Attributes that enable the instruction set.
+//		SimdVector			The vector type.
+//		SIMD_WIDTH			The number of doubles in a vector.
+//		SIMD_LOAD(p)		Loads a vector from a possibly unaligned pointer.
+//		SIMD_STORE(p, v)	Stores a vector to a possibly unaligned pointer.
+//		SIMD_SET(x)			A vector with [x] in every lane.
+//		SIMD_ADD(a, b), SIMD_SUB(a, b), SIMD_MUL(a, b)
+//		SIMD_MIN(a, b)		a < b ? a : b, per lane.
+//		SIMD_MAX(a, b)		a > b ? a : b, per lane.
+//		SIMD_HSUM(v), SIMD_HMIN(v), SIMD_HMAX(v)
+//							Reduces the lanes of a vector to a double.
+//
+// The scalar loops that handle the last few elements use the same operations,
+// so every element gets the same result whatever instruction set is used.
+
+#define SIMD_DEFINE_BINARY(name, VECTOR_OP, OP)                                      \
+	static SIMD_TARGET void SIMD_KERNEL(name)(double* dst, const double* a,          \
+	                                          const double* b, double bScalar,       \
+	                                          size_t count) {                        \
+		size_t i = 0;                                                                \
+		if (b != NULL) {                                                             \
+			for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {                       \
+				SIMD_STORE(dst + i, VECTOR_OP(SIMD_LOAD(a + i), SIMD_LOAD(b + i)));  \
+			}                                                                        \
+			for (; i < count; i++) dst[i] = a[i] OP b[i];                            \
+			return;                                                                  \
+		}                                                                            \
+		SimdVector bVector = SIMD_SET(bScalar);                                      \
+		for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {                           \
+			SIMD_STORE(dst + i, VECTOR_OP(SIMD_LOAD(a + i), bVector));               \
+		}                                                                            \
+		for (; i < count; i++) dst[i] = a[i] OP bScalar;                             \
+	}
+
+SIMD_DEFINE_BINARY(add, SIMD_ADD, +)
+SIMD_DEFINE_BINARY(sub, SIMD_SUB, -)
+SIMD_DEFINE_BINARY(mul, SIMD_MUL, *)
+
+#undef SIMD_DEFINE_BINARY
+
+static SIMD_TARGET void SIMD_KERNEL(fma)(double* dst, const double* a, const double* b,
+                                         double bScalar, const double* c, size_t count) {
+	size_t i = 0;
+	if (b != NULL) {
+		for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+			SimdVector product = SIMD_MUL(SIMD_LOAD(a + i), SIMD_LOAD(b + i));
+			SIMD_STORE(dst + i, SIMD_ADD(product, SIMD_LOAD(c + i)));
+		}
+		for (; i < count; i++) dst[i] = a[i] * b[i] + c[i];
+		return;
+	}
+
+	SimdVector bVector = SIMD_SET(bScalar);
+	for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+		SimdVector product = SIMD_MUL(SIMD_LOAD(a + i), bVector);
+		SIMD_STORE(dst + i, SIMD_ADD(product, SIMD_LOAD(c + i)));
+	}
+	for (; i < count; i++) dst[i] = a[i] * bScalar + c[i];
+}
+
+static SIMD_TARGET void SIMD_KERNEL(clamp)(double* dst, const double* a, double low,
+                                           double high, size_t count) {
+	SimdVector lowVector = SIMD_SET(low);
+	SimdVector highVector = SIMD_SET(high);
+	size_t i = 0;
+	for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+		SIMD_STORE(dst + i, SIMD_MIN(SIMD_MAX(SIMD_LOAD(a + i), lowVector), highVector));
+	}
+	for (; i < count; i++) {
+		double value = a[i] > low ? a[i] : low;
+		dst[i] = value < high ? value : high;
+	}
+}
+
+static SIMD_TARGET void SIMD_KERNEL(lerp)(double* dst, const double* a, const double* b,
+                                          double bScalar, double t, size_t count) {
+	SimdVector tVector = SIMD_SET(t);
+	size_t i = 0;
+	if (b != NULL) {
+		for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+			SimdVector from = SIMD_LOAD(a + i);
+			SimdVector delta = SIMD_SUB(SIMD_LOAD(b + i), from);
+			SIMD_STORE(dst + i, SIMD_ADD(from, SIMD_MUL(delta, tVector)));
+		}
+		for (; i < count; i++) dst[i] = a[i] + (b[i] - a[i]) * t;
+		return;
+	}
+
+	SimdVector bVector = SIMD_SET(bScalar);
+	for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+		SimdVector from = SIMD_LOAD(a + i);
+		SIMD_STORE(dst + i, SIMD_ADD(from, SIMD_MUL(SIMD_SUB(bVector, from), tVector)));
+	}
+	for (; i < count; i++) dst[i] = a[i] + (bScalar - a[i]) * t;
+}
+
+// The sums keep two accumulators so consecutive additions do not have to wait
+// for each other.
+static SIMD_TARGET double SIMD_KERNEL(sum)(const double* a, size_t count) {
+	SimdVector first = SIMD_SET(0.0);
+	SimdVector second = SIMD_SET(0.0);
+	size_t i = 0;
+	for (; i + 2 * SIMD_WIDTH <= count; i += 2 * SIMD_WIDTH) {
+		first = SIMD_ADD(first, SIMD_LOAD(a + i));
+		second = SIMD_ADD(second, SIMD_LOAD(a + i + SIMD_WIDTH));
+	}
+
+	double result = SIMD_HSUM(SIMD_ADD(first, second));
+	for (; i < count; i++) result += a[i];
+	return result;
+}
+
+static SIMD_TARGET double SIMD_KERNEL(dot)(const double* a, const double* b, size_t count) {
+	SimdVector first = SIMD_SET(0.0);
+	SimdVector second = SIMD_SET(0.0);
+	size_t i = 0;
+	for (; i + 2 * SIMD_WIDTH <= count; i += 2 * SIMD_WIDTH) {
+		first = SIMD_ADD(first, SIMD_MUL(SIMD_LOAD(a + i), SIMD_LOAD(b + i)));
+		second = SIMD_ADD(second, SIMD_MUL(SIMD_LOAD(a + i + SIMD_WIDTH),
+		                                   SIMD_LOAD(b + i + SIMD_WIDTH)));
+	}
+
+	double result = SIMD_HSUM(SIMD_ADD(first, second));
+	for (; i < count; i++) result += a[i] * b[i];
+	return result;
+}
+
+static SIMD_TARGET double SIMD_KERNEL(min)(const double* a, size_t count) {
+	SimdVector smallest = SIMD_SET(a[0]);
+	size_t i = 0;
+	for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+		smallest = SIMD_MIN(SIMD_LOAD(a + i), smallest);
+	}
+
+	double result = SIMD_HMIN(smallest);
+	for (; i < count; i++) result = a[i] < result ? a[i] : result;
+	return result;
+}
+
+static SIMD_TARGET double SIMD_KERNEL(max)(const double* a, size_t count) {
+	SimdVector largest = SIMD_SET(a[0]);
+	size_t i = 0;
+	for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+		largest = SIMD_MAX(SIMD_LOAD(a + i), largest);
+	}
+
+	double result = SIMD_HMAX(largest);
+	for (; i < count; i++) result = a[i] > result ? a[i] : result;
+	return result;
+}
@@ -12,7 +12,12 @@ DEFINE_BUFFER(Char, char)
 
 // Initializes the symbol table.
 void cardinalSymbolTableInit(CardinalVM* vm, SymbolTable* symbols) {
-	cardinalStringBufferInit(vm, symbols);
+	UNUSED(vm);
+	symbols->data = NULL;
+	symbols->count = 0;
+	symbols->capacity = 0;
+	symbols->index = NULL;
+	symbols->indexCapacity = 0;
 }
 
 // Frees all dynamically allocated memory used by the symbol table, but not the
@@ -21,7 +26,43 @@ void cardinalSymbolTableClear(CardinalVM* vm, SymbolTable* symbols) {
 	for(int i=symbols->count-1;i>=0;i--) {
 		DEALLOCATE(vm, symbols->data[i].buffer);
 	}
-	cardinalStringBufferClear(vm, symbols);
+	DEALLOCATE(vm, symbols->data);
+	DEALLOCATE(vm, symbols->index);
+	cardinalSymbolTableInit(vm, symbols);
+}
+
+// FNV-1a hash of the name.
+static uint32_t hashSymbol(const char* name, size_t length) {
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (uint8_t) name[i];
+		hash *= 16777619;
+	}
+	return hash;
+}
+
+// Stores the position [symbol] in the hash index of [symbols].
+static void indexSymbol(SymbolTable* symbols, int symbol) {
+	String* name = &symbols->data[symbol];
+	uint32_t mask = (uint32_t) symbols->indexCapacity - 1;
+	uint32_t slot = hashSymbol(name->buffer, name->length) & mask;
+	
+	// A name that is added twice lands after the first one, so lookups keep
+	// finding the first.
+	while (symbols->index[slot] != 0) slot = (slot + 1) & mask;
+	symbols->index[slot] = symbol + 1;
+}
+
+// Replaces the hash index of [symbols] with one of [capacity] slots.
+static void resizeSymbolIndex(CardinalVM* vm, SymbolTable* symbols, int capacity) {
+	DEALLOCATE(vm, symbols->index);
+	symbols->index = ALLOCATE_ARRAY(vm, int, capacity);
+	memset(symbols->index, 0, sizeof(int) * capacity);
+	symbols->indexCapacity = capacity;
+	
+	for (int i = 0; i < symbols->count; i++) {
+		indexSymbol(symbols, i);
+	}
 }
 
 // Adds name to the symbol table. Returns the index of it in the table. Returns
@@ -34,7 +75,26 @@ int cardinalSymbolTableAdd(CardinalVM* vm, SymbolTable* symbols, const char* nam
 	symbol.buffer[length] = '\0';
 	symbol.length = (int)length;
 
-	cardinalStringBufferWrite(vm, symbols, symbol);
+	if (symbols->capacity < symbols->count + 1) {
+		int capacity = symbols->capacity == 0 ? 8 : symbols->capacity * 2;
+		symbols->data = (String*) cardinalReallocate(vm, symbols->data,
+			symbols->capacity * sizeof(String), capacity * sizeof(String));
+		symbols->capacity = capacity;
+	}
+	symbols->data[symbols->count] = symbol;
+	symbols->count++;
+	
+	if (symbols->index != NULL &&
+	    symbols->count * 100 <= symbols->indexCapacity * SYMBOL_TABLE_LOAD_PERCENT) {
+		indexSymbol(symbols, symbols->count - 1);
+	}
+	else if (symbols->count >= SYMBOL_TABLE_INDEX_THRESHOLD) {
+		// Build the index or grow it, which adds the new name as well.
+		int capacity = symbols->indexCapacity == 0 ? 16 : symbols->indexCapacity;
+		while (symbols->count * 100 > capacity * SYMBOL_TABLE_LOAD_PERCENT) capacity *= 2;
+		resizeSymbolIndex(vm, symbols, capacity);
+	}
+	
 	return symbols->count - 1;
 }
 
@@ -50,10 +110,25 @@ int cardinalSymbolTableEnsure(CardinalVM* vm, SymbolTable* symbols, const char*
 
 // Looks up name in the symbol table. Returns its index if found or -1 if not.
 int cardinalSymbolTableFind(SymbolTable* symbols, const char* name, size_t length) {
-	// See if the symbol is already defined.
-	for (int i = 0; i < symbols->count; i++) {
-		if (symbols->data[i].length == length &&
-			memcmp(symbols->data[i].buffer, name, length) == 0) return i;
+	if (symbols->index == NULL) {
+		// Small tables are cheaper to scan than to hash.
+		for (int i = 0; i < symbols->count; i++) {
+			if (symbols->data[i].length == length &&
+				memcmp(symbols->data[i].buffer, name, length) == 0) return i;
+		}
+		return -1;
+	}
+	
+	uint32_t mask = (uint32_t) symbols->indexCapacity - 1;
+	uint32_t slot = hashSymbol(name, length) & mask;
+	
+	// The index is never full, so the probe always reaches an empty slot.
+	while (symbols->index[slot] != 0) {
+		String* symbol = &symbols->data[symbols->index[slot] - 1];
+		if (symbol->length == length && memcmp(symbol->buffer, name, length) == 0) {
+			return symbols->index[slot] - 1;
+		}
+		slot = (slot + 1) & mask;
 	}
 	return -1;
 }
@@ -87,9 +87,22 @@ void cardinalStackClear(CardinalVM* vm, CardinalStack* buffer);
 // Push an integer onto the cardinal stack
 void cardinalStackPush(CardinalVM* vm, CardinalStack* buffer, int elem);
 
-// The symboltable maps to a stringbuffer 
+// The symboltable is a growable array of names with a hash index to find them
 //
-typedef StringBuffer SymbolTable;
+typedef struct {
+	/// The names, in the order they were added
+	String* data;
+	/// Number of names in the table
+	int count;
+	/// Number of names that fit in [data]
+	int capacity;
+	/// Open addressed hash index into [data]. Each slot holds the position of a
+	/// name plus one, or zero if the slot is empty. NULL while the table is
+	/// small enough to be searched linearly
+	int* index;
+	/// Number of slots in [index], always a power of two
+	int indexCapacity;
+} SymbolTable;
 
 // Initializes the symbol table.
 // The symbol table is growable
@@ -9,11 +9,16 @@
 
 #include "cardinal.h"
 #include "cardinal_vm.h"
+#include "cardinal_number.h"
+#include "cardinal_simd.h"
 
 #include <stdarg.h>
 
+#if CARDINAL_MAP_SSE2
+	#include <emmintrin.h>
+#endif
+
 
-DEFINE_BUFFER(Method, Method)
 DEFINE_BUFFER(Value, Value)
 DEFINE_BUFFER(ValuePtr, Value*);
 
@@ -67,7 +72,9 @@ ObjClass* cardinalNewSingleClass(CardinalVM* vm, int numFields, ObjString* name)
 	obj->superclasses = NULL;
 	
 	CARDINAL_PIN(vm, obj);
-	cardinalMethodBufferInit(vm, &obj->methods);
+	obj->methods.entries = NULL;
+	obj->methods.capacity = 0;
+	obj->methods.count = 0;
 	obj->superclasses = cardinalNewList(vm, 0);
 	CARDINAL_UNPIN(vm);
 	
@@ -105,17 +112,10 @@ void cardinalBindSuperclass(CardinalVM* vm, ObjClass* subclass, ObjClass* superc
 
 	//subclass->superclass += superclass->numFields;
 	
-	// Include the superclass in the total number of fields.
+	// Include the superclass in the total number of fields. The methods are
+	// not copied, lookups that miss in the subclass continue in its
+	// superclasses.
 	subclass->numFields += superclass->numFields;
-
-	// Inherit methods from its superclass.
-	for (int i = superclass->methods.count-1; i >= 0; i--) {
-		if (superclass->methods.data[i].type != METHOD_NONE) {
-			Method meth;
-			meth.type = METHOD_SUPERCLASS;
-			cardinalBindMethod(vm, subclass, i, meth); //superclass->methods.data[i]);
-		}
-	}
 }
 
 // Creates a new class object as well 
@@ -156,23 +156,60 @@ ObjClass* cardinalNewClass(CardinalVM* vm, ObjClass* superclass, int numFields,
 	return classObj;
 }
 
+// Stores [method] under [symbol] in [entries], which has [capacity] entries.
+static void addMethodEntry(MethodEntry* entries, int capacity, int symbol, Method method) {
+	uint32_t mask = (uint32_t) capacity - 1;
+	uint32_t index = ((uint32_t) symbol * 2654435769u) & mask;
+	
+	while (entries[index].symbol != -1 && entries[index].symbol != symbol) {
+		index = (index + 1) & mask;
+	}
+	entries[index].symbol = symbol;
+	entries[index].method = method;
+}
+
+// Updates the method table of [classObj] to [capacity] entries.
+static void resizeMethodTable(CardinalVM* vm, ObjClass* classObj, int capacity) {
+	MethodTable* table = &classObj->methods;
+	MethodEntry* entries = ALLOCATE_ARRAY(vm, MethodEntry, capacity);
+	for (int i = 0; i < capacity; i++) {
+		entries[i].symbol = -1;
+	}
+	
+	for (int i = 0; i < table->capacity; i++) {
+		if (table->entries[i].symbol == -1) continue;
+		addMethodEntry(entries, capacity, table->entries[i].symbol, table->entries[i].method);
+	}
+	
+	DEALLOCATE(vm, table->entries);
+	table->entries = entries;
+	table->capacity = capacity;
+}
+
 // Bind a method to the VM
 void cardinalBindMethod(CardinalVM* vm, ObjClass* classObj, int symbol, Method method) {
-	// Make sure the buffer is big enough to reach the symbol's index.
-	Method noMethod;
-	noMethod.type = METHOD_NONE;
-	while (symbol >= classObj->methods.count) {
-		cardinalMethodBufferWrite(vm, &classObj->methods, noMethod);
+	MethodTable* table = &classObj->methods;
+	
+	Method* existing = cardinalFindMethod(classObj, symbol);
+	if (existing != NULL) {
+		*existing = method;
+		return;
 	}
-
-	classObj->methods.data[symbol] = method;
+	
+	// Make sure the table stays sparse enough to find methods quickly.
+	if ((table->count + 1) * 100 > table->capacity * METHOD_TABLE_LOAD_PERCENT) {
+		int capacity = table->capacity == 0 ? METHOD_TABLE_MIN_CAPACITY : table->capacity * 2;
+		resizeMethodTable(vm, classObj, capacity);
+	}
+	
+	addMethodEntry(table->entries, table->capacity, symbol, method);
+	table->count++;
 }
 
 Method* cardinalGetMethod(CardinalVM* vm, ObjClass* classObj, int symbol, int& adjustment) {
-	if (symbol > classObj->methods.count) return NULL;
-	Method* meth = &classObj->methods.data[symbol];
+	Method* meth = cardinalFindMethod(classObj, symbol);
 	
-	if (meth->type == METHOD_NONE || meth->type == METHOD_SUPERCLASS) {
+	if (meth == NULL || meth->type == METHOD_NONE || meth->type == METHOD_SUPERCLASS) {
 		adjustment += classObj->superclass;
 		int nb = classObj->superclasses->count;
 		for(int a=0; a<nb; a++) {
@@ -229,19 +266,33 @@ ObjClosure* cardinalNewClosure(CardinalVM* vm, ObjFn* fn) {
 // Creates a new fiber object that will invoke [fn], which can be a function or
 // closure.
 ObjFiber* cardinalNewFiber(CardinalVM* vm, Obj* fn) {
+	// Reuse a collected fiber, including its stack and call frames.
+	if (vm->fiberPool.first != NULL) {
+		ObjFiber* fiber = vm->fiberPool.first;
+		vm->fiberPool.first = (ObjFiber*) fiber->obj.next;
+		vm->fiberPool.count--;
+		
+		initObj(vm, &fiber->obj, OBJ_FIBER, vm->metatable.fiberClass);
+		fiber->rootDirectory = vm->fiber != NULL ? vm->fiber->rootDirectory : vm->rootDirectory;
+		cardinalResetFiber(fiber, fn);
+		return fiber;
+	}
+	
 	ObjFiber* fiber = ALLOCATE(vm, ObjFiber);
 	initObj(vm, &fiber->obj, OBJ_FIBER, vm->metatable.fiberClass);
 	
+	fiber->segment = NULL;
 	fiber->stack = NULL;
 	fiber->frames = NULL;
+	fiber->framesize = 0;
+	fiber->rootDirectory = vm->fiber != NULL ? vm->fiber->rootDirectory : vm->rootDirectory;
 	CARDINAL_PIN(vm, fiber);
 	cardinalResetFiber(fiber, fn);
 	// Initialise stack and callframe
-	fiber->stacksize = STACKSIZE;
-	fiber->stack = ALLOCATE_ARRAY(vm, Value, fiber->stacksize);
+	fiber->segment = cardinalNewStackSegment(vm, NULL, vm->fiberStackSize);
 	
-	fiber->framesize = CALLFRAMESIZE;
-	fiber->frames = ALLOCATE_ARRAY(vm, CallFrame, fiber->framesize);
+	fiber->frames = ALLOCATE_ARRAY(vm, CallFrame, vm->fiberCallFrames);
+	fiber->framesize = vm->fiberCallFrames;
 
 	cardinalResetFiber(fiber, fn);
 	CARDINAL_UNPIN(vm);
@@ -249,12 +300,57 @@ ObjFiber* cardinalNewFiber(CardinalVM* vm, Obj* fn) {
 	return fiber;
 }
 
+// Puts the collected [fiber] in the fiber pool of [vm]. Only its first stack
+// segment is kept, and it and the call frames are shrunk back to the sizes a
+// new fiber starts with, so the pool never holds more than [FIBER_POOL_MAX]
+// fibers of that size.
+static void poolFiber(CardinalVM* vm, ObjFiber* fiber) {
+	StackSegment* segment = fiber->segment;
+	while (segment->previous != NULL) segment = segment->previous;
+	if (segment->next != NULL) cardinalFreeStackSegments(vm, segment->next);
+	
+	// The collector did not count the memory of the fiber, so it is shrunk
+	// without going through [cardinalReallocate].
+	if (segment->size > (size_t) vm->fiberStackSize) {
+		segment = (StackSegment*) vm->reallocate(segment,
+			sizeof(StackSegment) + sizeof(Value) * segment->size,
+			sizeof(StackSegment) + sizeof(Value) * vm->fiberStackSize);
+		segment->size = vm->fiberStackSize;
+	}
+	fiber->segment = segment;
+	
+	if (fiber->framesize > (size_t) vm->fiberCallFrames) {
+		fiber->frames = (CallFrame*) vm->reallocate(fiber->frames,
+			sizeof(CallFrame) * fiber->framesize,
+			sizeof(CallFrame) * vm->fiberCallFrames);
+		fiber->framesize = vm->fiberCallFrames;
+	}
+	
+	fiber->obj.type = OBJ_DEAD;
+	fiber->obj.next = (Obj*) vm->fiberPool.first;
+	vm->fiberPool.first = fiber;
+	vm->fiberPool.count++;
+}
+
+void cardinalFreeFiberPool(CardinalVM* vm) {
+	while (vm->fiberPool.first != NULL) {
+		ObjFiber* fiber = vm->fiberPool.first;
+		vm->fiberPool.first = (ObjFiber*) fiber->obj.next;
+		
+		cardinalFreeStackSegments(vm, fiber->segment);
+		DEALLOCATE(vm, fiber->frames);
+		DEALLOCATE(vm, fiber);
+	}
+	vm->fiberPool.count = 0;
+}
+
 void cardinalResetFiber(ObjFiber* fiber, Obj* fn) {
 	// Push the stack frame for the function.
-	fiber->stacktop = fiber->stack;
+	cardinalClearFiberStack(fiber);
 	fiber->numFrames = 1;
 	fiber->openUpvalues = NULL;
 	fiber->caller = NULL;
+	fiber->nativeCaller = NULL;
 	fiber->error = NULL;
 	fiber->callerIsTrying = false;
 	fiber->yielded = false;
@@ -273,6 +369,39 @@ void cardinalResetFiber(ObjFiber* fiber, Obj* fn) {
 	}
 }
 
+void cardinalClearFiberStack(ObjFiber* fiber) {
+	if (fiber->segment != NULL) {
+		// Segments above the first one are kept, so they can be reused.
+		while (fiber->segment->previous != NULL) fiber->segment = fiber->segment->previous;
+		fiber->stack = fiber->segment->values;
+		fiber->stacksize = fiber->segment->size;
+	}
+	fiber->stacktop = fiber->stack;
+}
+
+StackSegment* cardinalNewStackSegment(CardinalVM* vm, StackSegment* previous, size_t size) {
+	StackSegment* segment = ALLOCATE_FLEX(vm, StackSegment, Value, size);
+	segment->previous = previous;
+	segment->next = NULL;
+	segment->returnSlot = NULL;
+	segment->frame = 0;
+	segment->depth = 0;
+	segment->size = size;
+	
+	if (previous != NULL) previous->next = segment;
+	return segment;
+}
+
+void cardinalFreeStackSegments(CardinalVM* vm, StackSegment* segment) {
+	if (segment->previous != NULL) segment->previous->next = NULL;
+	
+	while (segment != NULL) {
+		StackSegment* next = segment->next;
+		DEALLOCATE(vm, segment);
+		segment = next;
+	}
+}
+
 FnDebug* cardinalNewDebug(CardinalVM* vm, ObjString* debugSourcePath, const char* debugName, int debugNameLength, 
 						int* sourceLines, SymbolTable locals, SymbolTable lines) {
 	FnDebug* debug = ALLOCATE(vm, FnDebug);
@@ -380,7 +509,7 @@ static uint32_t hashObject(Obj* object) {
 		}
 
 		case OBJ_STRING:
-			return ((ObjString*)object)->hash;
+			return cardinalStringHash((ObjString*)object);
 
 		default:
 			ASSERT(false, "Only immutable objects can be hashed.");
@@ -404,6 +533,7 @@ static uint32_t hashValue(Value value) {
 		case VAL_FALSE: return 0;
 		case VAL_NULL: return 1;
 		case VAL_NUM: return hashNumber(AS_NUM(value));
+		case VAL_INT: return hashNumber(AS_NUM(value));
 		case VAL_TRUE: return 2;
 		case VAL_OBJ: return hashObject(AS_OBJ(value));
 		default:
@@ -412,6 +542,26 @@ static uint32_t hashValue(Value value) {
 	}
 #endif
 }
+
+// Scrambles the bits of [hash]. Hashes of numbers differ mostly in their high
+// bits, which a mask would otherwise throw away.
+static inline uint32_t mixHash(uint32_t hash) {
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+// Returns the smallest capacity of a table or map that holds [count] pairs
+// without exceeding MAP_LOAD_PERCENT.
+static int hashCapacityFor(int count) {
+	int capacity = TABLE_MIN_CAPACITY;
+	while (capacity * MAP_LOAD_PERCENT / 100 < count) capacity *= TABLE_GROW_FACTOR;
+	return capacity;
+}
+
 // Creates a new list with [numElements] elements (which are left
 // uninitialized.)
 ObjList* cardinalNewList(CardinalVM* vm, int numElements) {
@@ -427,11 +577,57 @@ ObjList* cardinalNewList(CardinalVM* vm, int numElements) {
 	list->capacity = numElements;
 	list->count = numElements;
 	list->elements = elements;
+	list->source = NULL;
 	return list;
 }
 
+ObjList* cardinalNewListView(CardinalVM* vm, ObjList* list, int start, int count) {
+	CARDINAL_PIN(vm, list);
+
+	// The elements are first handed over to a list nothing else refers to, so
+	// [list] can later give up its share without freeing them under the view.
+	if (list->source == NULL) {
+		ObjList* storage = cardinalNewList(vm, 0);
+		storage->elements = list->elements;
+		storage->capacity = list->capacity;
+		storage->count = list->count;
+
+		list->source = storage;
+		list->capacity = 0;
+	}
+
+	ObjList* view = cardinalNewList(vm, 0);
+	CARDINAL_UNPIN(vm);
+
+	view->elements = list->elements + start;
+	view->count = count;
+	view->source = list->source;
+	return view;
+}
+
+// Gives [list] its own copy of the elements it shares, with room for at least
+// [capacity] elements.
+static void unshareList(CardinalVM* vm, ObjList* list, int capacity) {
+	if (capacity < list->count) capacity = list->count;
+
+	Value* elements = NULL;
+	if (capacity > 0) {
+		elements = ALLOCATE_ARRAY(vm, Value, capacity);
+		memcpy(elements, list->elements, sizeof(Value) * list->count);
+	}
+
+	list->elements = elements;
+	list->capacity = capacity;
+	list->source = NULL;
+}
+
+void cardinalListUnshare(CardinalVM* vm, ObjList* list) {
+	if (list->source != NULL) unshareList(vm, list, list->count);
+}
+
 // Grows [list] if needed to ensure it can hold [count] elements.
 static void ensureListCapacity(CardinalVM* vm, ObjList* list, int count) {
+	if (list->source != NULL) unshareList(vm, list, count);
 	if (list->capacity >= count) return;
 
 	int capacity = list->capacity * LIST_GROW_FACTOR;
@@ -474,8 +670,17 @@ void cardinalListInsert(CardinalVM* vm, ObjList* list, Value value, int index) {
 Value cardinalListRemoveAt(CardinalVM* vm, ObjList* list, int index) {
 	Value removed = list->elements[index];
 
+	// Removing the first element of a view only moves the view.
+	if (list->source != NULL && index == 0) {
+		list->elements++;
+		list->count--;
+		return removed;
+	}
+
 	if (IS_OBJ(removed)) CARDINAL_PIN(vm, AS_OBJ(removed));
 
+	cardinalListUnshare(vm, list);
+
 	// Shift items up.
 	for (int i = index; i < list->count - 1; i++) {
 		list->elements[i] = list->elements[i + 1];
@@ -496,8 +701,9 @@ Value cardinalListRemoveAt(CardinalVM* vm, ObjList* list, int index) {
 }
 
 void cardinalListRemoveLast(CardinalVM* vm, ObjList* list) {
-	// If we have too much excess capacity, shrink it.
-	if (list->capacity / LIST_GROW_FACTOR >= list->count) {
+	// If we have too much excess capacity, shrink it. A view does not own its
+	// elements, so it only gets shorter.
+	if (list->source == NULL && list->capacity / LIST_GROW_FACTOR >= list->count) {
 		list->elements = (Value*) cardinalReallocate(vm, list->elements,
 										sizeof(Value) * list->capacity,
 										sizeof(Value) * (list->capacity / LIST_GROW_FACTOR));
@@ -512,131 +718,173 @@ ObjMap* cardinalNewMap(CardinalVM* vm) {
 	initObj(vm, &map->obj, OBJ_MAP, vm->metatable.mapClass);
 	map->capacity = 0;
 	map->count = 0;
+	map->deleted = 0;
 	map->entries = NULL;
+	map->hashes = NULL;
+	map->control = NULL;
 	return map;
 }
 
-// Inserts [key] and [value] in the array of [entries] with the given
-// [capacity].
-//
-// Returns `true` if this is the first time [key] was added to the map.
-static bool addEntry(MapEntry* entries, uint32_t capacity,
-                     Value key, Value value) {
-	// Figure out where to insert it in the table. Use open addressing and
-	// basic linear probing.
-	uint32_t index = hashValue(key) % capacity;
-
-	// We don't worry about an infinite loop here because resizeMap() ensures
-	// there are open slots in the array.
-	while (true) {
-		MapEntry* entry = &entries[index];
+ObjMap* cardinalNewSet(CardinalVM* vm) {
+	ObjMap* set = cardinalNewMap(vm);
+	set->obj.type = OBJ_SET;
+	set->obj.classObj = vm->metatable.setClass;
+	return set;
+}
 
-		// If we found an open slot, the key is not in the table.
-		if (IS_UNDEFINED(entry->key)) {
-			// Don't stop at a tombstone, though, because the key may be found after
-			// it.
-			if (IS_FALSE(entry->value)) {
-				entry->key = key;
-				entry->value = value;
-				return true;
+bool cardinalSetAdd(CardinalVM* vm, ObjMap* set, Value value) {
+	if (cardinalMapFind(set, value) != UINT32_MAX) return false;
+
+	cardinalMapSet(vm, set, value, TRUE_VAL);
+	return true;
+}
+
+// The number of entries whose control bytes are compared at once.
+#define MAP_GROUP_SIZE 16
+
+// The control byte of an entry that was never used.
+#define MAP_EMPTY ((uint8_t) 0x80)
+
+// The control byte of an entry whose key was removed.
+#define MAP_DELETED ((uint8_t) 0xfe)
+
+// A full entry stores the low seven bits of its hash in its control byte, the
+// other bits select the group where probing starts.
+#define MAP_H1(hash) ((hash) >> 7)
+#define MAP_H2(hash) ((uint8_t) ((hash) & 0x7f))
+
+// Returns a mask with a bit set for every control byte in the group at
+// [control] that equals [byte].
+static inline uint32_t matchGroup(const uint8_t* control, uint8_t byte) {
+#if CARDINAL_MAP_SSE2
+	__m128i group = _mm_loadu_si128((const __m128i*) control);
+	return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char) byte)));
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < MAP_GROUP_SIZE; i++) {
+		if (control[i] == byte) mask |= 1u << i;
+	}
+	return mask;
+#endif
+}
+
+// Returns a mask with a bit set for every entry in the group at [control] that
+// is empty or deleted. Only those have the high bit of their control byte set.
+static inline uint32_t matchGroupFree(const uint8_t* control) {
+#if CARDINAL_MAP_SSE2
+	return (uint32_t) _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) control));
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < MAP_GROUP_SIZE; i++) {
+		if (control[i] & 0x80) mask |= 1u << i;
+	}
+	return mask;
+#endif
+}
+
+// Returns the index of the lowest bit set in [mask], which is not zero.
+static inline uint32_t lowestBit(uint32_t mask) {
+#if defined(__GNUC__)
+	return (uint32_t) __builtin_ctz(mask);
+#else
+	uint32_t bit = 0;
+	while ((mask & 1) == 0) {
+		mask >>= 1;
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+// Returns the index of [key] with [hash] in [map], or UINT32_MAX if it is not
+// in the map.
+static uint32_t findMapIndex(ObjMap* map, Value key, uint32_t hash) {
+	uint32_t groupMask = map->capacity / MAP_GROUP_SIZE - 1;
+	uint32_t group = MAP_H1(hash) & groupMask;
+	uint8_t h2 = MAP_H2(hash);
+	
+	// Moving one group further at every step visits every group, since the
+	// number of groups is a power of two.
+	for (uint32_t step = 1; ; step++) {
+		const uint8_t* control = &map->control[group * MAP_GROUP_SIZE];
+		
+		// Only keys that share the seven bits of the control byte and the whole
+		// cached hash are ever compared.
+		uint32_t match = matchGroup(control, h2);
+		while (match != 0) {
+			uint32_t index = group * MAP_GROUP_SIZE + lowestBit(match);
+			if (map->hashes[index] == hash && cardinalValuesEqual(map->entries[index].key, key)) {
+				return index;
 			}
+			match &= match - 1;
 		}
-		else if (cardinalValuesEqual(entry->key, key)) {
-			// If the key already exists, just replace the value.
-			entry->value = value;
-			return false;
-		}
+		
+		// A key is never stored past a group that has an empty entry.
+		if (matchGroup(control, MAP_EMPTY) != 0) return UINT32_MAX;
+		
+		group = (group + step) & groupMask;
+	}
+}
 
-		// Try the next slot.
-		index = (index + 1) % capacity;
+// Returns the index of the first empty or deleted entry on the probe sequence
+// of [hash] in [control], which holds [capacity] control bytes.
+static uint32_t findFreeIndex(const uint8_t* control, uint32_t capacity, uint32_t hash) {
+	uint32_t groupMask = capacity / MAP_GROUP_SIZE - 1;
+	uint32_t group = MAP_H1(hash) & groupMask;
+	
+	for (uint32_t step = 1; ; step++) {
+		uint32_t free = matchGroupFree(&control[group * MAP_GROUP_SIZE]);
+		if (free != 0) return group * MAP_GROUP_SIZE + lowestBit(free);
+		
+		group = (group + step) & groupMask;
 	}
 }
 
-// Updates [map]'s entry array to [capacity].
+// Updates [map]'s entry array to [capacity]. The cached hashes are used to
+// place the entries, so no key is hashed again.
 static void resizeMap(CardinalVM* vm, ObjMap* map, uint32_t capacity) {
+	// The entries, hashes and control bytes share a single allocation.
+	size_t size = capacity * (sizeof(MapEntry) + sizeof(uint32_t) + sizeof(uint8_t));
+	MapEntry* entries = (MapEntry*) cardinalReallocate(vm, NULL, 0, size);
+	uint32_t* hashes = (uint32_t*) (entries + capacity);
+	uint8_t* control = (uint8_t*) (hashes + capacity);
 	
-	// Create the new empty hash table.
-	MapEntry* entries = ALLOCATE_ARRAY(vm, MapEntry, capacity);
 	for (uint32_t i = 0; i < capacity; i++) {
 		entries[i].key = UNDEFINED_VAL;
 		entries[i].value = FALSE_VAL;
 	}
+	memset(control, MAP_EMPTY, capacity);
 
 	// Re-add the existing entries.
-	if (map->capacity > 0) {
-		for (uint32_t i = 0; i < map->capacity; i++) {
-			MapEntry* entry = &map->entries[i];
-			if (IS_UNDEFINED(entry->key)) continue;
-
-			addEntry(entries, capacity, entry->key, entry->value);
-		}
+	for (uint32_t i = 0; i < map->capacity; i++) {
+		if (map->control[i] & 0x80) continue;
+		
+		uint32_t hash = map->hashes[i];
+		uint32_t index = findFreeIndex(control, capacity, hash);
+		control[index] = MAP_H2(hash);
+		hashes[index] = hash;
+		entries[index] = map->entries[i];
 	}
 
 	// Replace the array.
-	cardinalReallocate(vm, map->entries, 0, 0);
+	DEALLOCATE(vm, map->entries);
 	map->entries = entries;
+	map->hashes = hashes;
+	map->control = control;
 	map->capacity = capacity;
+	map->deleted = 0;
 }
 
 uint32_t cardinalMapFind(ObjMap* map, Value key) {
-	// If there is no entry array (an empty map), we definitely won't find it.
-	if (map->capacity == 0) return UINT32_MAX;
-
-	// Figure out where to insert it in the table. Use open addressing and
-	// basic linear probing.
-	uint32_t index = hashValue(key) % map->capacity;
-
-	// We don't worry about an infinite loop here because ensureMapCapacity()
-	// ensures there are empty (i.e. UNDEFINED) spaces in the table.
-	while (true) {
-		MapEntry* entry = &map->entries[index];
-
-		if (IS_UNDEFINED(entry->key)) {
-			// If we found an empty slot, the key is not in the table. If we found a
-			// slot that contains a deleted key, we have to keep looking.
-			if (IS_FALSE(entry->value)) return UINT32_MAX;
-		}
-		else if (cardinalValuesEqual(entry->key, key)) {
-			// If the key matches, we found it.
-			return index;
-		}
-
-		// Try the next slot.
-		index = (index + 1) % map->capacity;
-	}
-}
-
-static MapEntry* findEntry(ObjMap* map, Value key) {
-	// If there is no entry array (an empty map), we definitely won't find it.
-	if (map->capacity == 0) return NULL;
-
-	// Figure out where to insert it in the table. Use open addressing and
-	// basic linear probing.
-	uint32_t index = hashValue(key) % map->capacity;
-
-	// We don't worry about an infinite loop here because ensureMapCapacity()
-	// ensures there are empty (i.e. UNDEFINED) spaces in the table.
-	while (true) {
-		MapEntry* entry = &map->entries[index];
-
-		if (IS_UNDEFINED(entry->key)) {
-			// If we found an empty slot, the key is not in the table. If we found a
-			// slot that contains a deleted key, we have to keep looking.
-			if (IS_FALSE(entry->value)) return NULL;
-		}
-		else if (cardinalValuesEqual(entry->key, key)) {
-			// If the key matches, we found it.
-			return entry;
-		}
-
-		// Try the next slot.
-		index = (index + 1) % map->capacity;
-	}
+	// If there are no entries, we definitely won't find it.
+	if (map->count == 0) return UINT32_MAX;
+	
+	return findMapIndex(map, key, mixHash(hashValue(key)));
 }
 
 Value cardinalMapGet(ObjMap* map, Value key) {
-	MapEntry *entry = findEntry(map, key);
-	if (entry != NULL) return entry->value;
+	uint32_t index = cardinalMapFind(map, key);
+	if (index != UINT32_MAX) return map->entries[index].value;
   
 	return UNDEFINED_VAL;
 }
@@ -646,39 +894,68 @@ Value cardinalMapGetInd(ObjMap* map, uint32_t ind) {
 }
 
 void cardinalMapSet(CardinalVM* vm, ObjMap* map, Value key, Value value) {
-	// If the map is getting too full, make room first.
-	if (map->count + 5 > map->capacity * MAP_LOAD_PERCENT / 100) {
-		// Figure out the new hash table size.
-		uint32_t capacity = map->capacity * TABLE_GROW_FACTOR;
-		if (capacity < TABLE_MIN_CAPACITY) capacity = TABLE_MIN_CAPACITY;
-
-		resizeMap(vm, map, capacity);
+	uint32_t hash = mixHash(hashValue(key));
+	
+	// If the key already exists, just replace the value.
+	if (map->count > 0) {
+		uint32_t index = findMapIndex(map, key, hash);
+		if (index != UINT32_MAX) {
+			map->entries[index].value = value;
+			return;
+		}
 	}
-	if (addEntry(map->entries, map->capacity, key, value)) {
-		// A new key was added.
-		map->count++;
+	
+	// If the map is getting too full, make room first. Deleted entries count
+	// too, so that every probe still ends at an empty entry.
+	if (map->count + map->deleted + 1 > map->capacity * MAP_LOAD_PERCENT / 100) {
+		if (IS_OBJ(value)) CARDINAL_PIN(vm, AS_OBJ(value));
+		if (IS_OBJ(key)) CARDINAL_PIN(vm, AS_OBJ(key));
+		
+		resizeMap(vm, map, hashCapacityFor(map->count + 1));
+		
+		if (IS_OBJ(key)) CARDINAL_UNPIN(vm);
+		if (IS_OBJ(value)) CARDINAL_UNPIN(vm);
 	}
+	
+	uint32_t index = findFreeIndex(map->control, map->capacity, hash);
+	if (map->control[index] == MAP_DELETED) map->deleted--;
+	
+	map->control[index] = MAP_H2(hash);
+	map->hashes[index] = hash;
+	map->entries[index].key = key;
+	map->entries[index].value = value;
+	map->count++;
 }
 
 void cardinalMapClear(CardinalVM* vm, ObjMap* map) {
-	cardinalReallocate(vm, map->entries, 0, 0);
+	DEALLOCATE(vm, map->entries);
 	map->entries = NULL;
+	map->hashes = NULL;
+	map->control = NULL;
 	map->capacity = 0;
 	map->count = 0;
+	map->deleted = 0;
 }
 
 Value cardinalMapRemoveKey(CardinalVM* vm, ObjMap* map, Value key) {
-	MapEntry *entry = findEntry(map, key);
-	if (entry == NULL) return NULL_VAL;
+	uint32_t index = cardinalMapFind(map, key);
+	if (index == UINT32_MAX) return NULL_VAL;
 
 	// Remove the entry from the map. Set this value to true, which marks it as a
-	// deleted slot. When searching for a key, we will stop on empty slots, but
-	// continue past deleted slots.
-	Value value = entry->value;
-	entry->key = UNDEFINED_VAL;
-	entry->value = TRUE_VAL;
-
-	if (IS_OBJ(value)) cardinalPushRoot(vm, AS_OBJ(value));
+	// deleted slot.
+	Value value = map->entries[index].value;
+	map->entries[index].key = UNDEFINED_VAL;
+	map->entries[index].value = TRUE_VAL;
+	
+	// Probes stop at a group with an empty entry, so the entry only has to be
+	// marked as deleted when its group is full.
+	if (matchGroup(&map->control[index & ~(MAP_GROUP_SIZE - 1)], MAP_EMPTY) != 0) {
+		map->control[index] = MAP_EMPTY;
+	}
+	else {
+		map->control[index] = MAP_DELETED;
+		map->deleted++;
+	}
 
 	map->count--;
 
@@ -687,15 +964,13 @@ Value cardinalMapRemoveKey(CardinalVM* vm, ObjMap* map, Value key) {
 		cardinalMapClear(vm, map);
 	}
 	else if (map->capacity > TABLE_MIN_CAPACITY &&
-	         map->count < map->capacity / TABLE_GROW_FACTOR * MAP_LOAD_PERCENT / 100) {
-		uint32_t capacity = map->capacity / TABLE_GROW_FACTOR;
-		if (capacity < TABLE_MIN_CAPACITY) capacity = TABLE_MIN_CAPACITY;
-
+	         map->count < map->capacity * MAP_LOAD_PERCENT / 100 / 4) {
 		// The map is getting empty, so shrink the entry array back down.
-		resizeMap(vm, map, capacity);
+		if (IS_OBJ(value)) cardinalPushRoot(vm, AS_OBJ(value));
+		resizeMap(vm, map, map->capacity / TABLE_GROW_FACTOR);
+		if (IS_OBJ(value)) cardinalPopRoot(vm);
 	}
 
-	if (IS_OBJ(value)) cardinalPopRoot(vm);
 	return value;
 }
 
@@ -761,32 +1036,66 @@ Value cardinalNewRange(CardinalVM* vm, double from, double to, bool isInclusive)
 // Creates a new string object with a null-terminated buffer large enough to
 // hold a string of [length] but does not fill in the bytes.
 //
-// The caller is expected to fill in the buffer and then calculate the string's
-// hash.
+// The caller is expected to fill in the buffer. The hash is calculated lazily
+// the first time it is needed.
 static ObjString* allocateString(CardinalVM* vm, size_t length) {
   ObjString* string = ALLOCATE_FLEX(vm, ObjString, char, length + 1);
   initObj(vm, &string->obj, OBJ_STRING, vm->metatable.stringClass);
   string->length = (int)length;
+  string->hashed = false;
+  string->interned = false;
+  string->encoding = STRING_UNKNOWN;
+  string->codePointCount = -1;
+  string->codePointIndex = NULL;
   string->value[length] = '\0';
 
   return string;
 }
 
-// Calculates and stores the hash code for [string].
-void hashString(ObjString* string) {
+// Calculates the hash code of [length] bytes of [text], consuming eight bytes
+// at a time. Used for long strings where the byte-wise loop is too slow.
+static uint32_t hashWords(const char* text, size_t length) {
+	// FNV-1a over 64 bit words, with an extra shift to mix the high bits down.
+	uint64_t hash = (uint64_t)0xcbf29ce484222325ULL;
+	size_t i = 0;
+
+	for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, text + i, sizeof(uint64_t));
+		hash ^= word;
+		hash *= (uint64_t)0x100000001b3ULL;
+		hash ^= hash >> 32;
+	}
+
+	for (; i < length; i++) {
+		hash ^= (uint8_t)text[i];
+		hash *= (uint64_t)0x100000001b3ULL;
+	}
+
+	return (uint32_t)(hash ^ (hash >> 32));
+}
+
+// Calculates the hash code of [length] bytes of [text].
+static uint32_t hashBytes(const char* text, size_t length) {
+	if (length >= STRING_HASH_WORD_LENGTH) return hashWords(text, length);
+
 	// FNV-1a hash. See: http://www.isthe.com/chongo/tech/comp/fnv/
 	uint32_t hash = 2166136261u;
 
-	// This is O(n) on the length of the string, but we only call this when a new
-	// string is created. Since the creation is also O(n) (to copy/initialize all
-	// the bytes), we allow this here.
-	for (uint32_t i = 0; i < (uint32_t) string->length; i++) {
-		hash ^= string->value[i];
+	for (size_t i = 0; i < length; i++) {
+		hash ^= text[i];
 		hash *= 16777619;
 	}
 
-	string->hash = hash;
+	return hash;
+}
+
+// Calculates and stores the hash code for [string].
+void hashString(ObjString* string) {
+	string->hash = hashBytes(string->value, string->length);
+	string->hashed = true;
 }
+
 // Creates a new string object of [length] and copies [text] into it.
 //
 // [text] may be NULL if [length] is zero.
@@ -795,14 +1104,16 @@ Value cardinalNewString(CardinalVM* vm, const char* text, size_t length) {
 	// characters for a zero-length string.
 	ASSERT(length == 0 || text != NULL, "Unexpected NULL string.");
 
+	// Short strings are shared through the string table.
+	if (length <= STRING_INTERN_MAX_LENGTH) return cardinalNewInternedString(vm, text, length);
+
 	ObjString* string = allocateString(vm, length); //AS_STRING(cardinalNewUninitializedString(vm, length));
 
 	// Copy the string (if given one).
-	if (length > 0) strncpy(string->value, text, length);
+	if (length > 0) memcpy(string->value, text, length);
 
 	string->value[length] = '\0';
-	
-	hashString(string);
+	cardinalStringCheckEncoding(string);
 
 	return OBJ_VAL(string);
 }
@@ -817,11 +1128,112 @@ Value cardinalNewUninitializedString(CardinalVM* vm, size_t length) {
 	ObjString* string = ALLOCATE_FLEX(vm, ObjString, char, length + 1);
 	initObj(vm, &string->obj, OBJ_STRING, vm->metatable.stringClass);
 	string->length = (int)length;
+	string->hashed = false;
+	string->interned = false;
+	string->encoding = STRING_UNKNOWN;
+	string->codePointCount = -1;
+	string->codePointIndex = NULL;
 	string->value[length] = '\0';
 
 	return OBJ_VAL(string);
 }
 
+// Inserts [string] in the array of string table [entries] with the given
+// [capacity].
+static void addInternedString(Value* entries, uint32_t capacity, ObjString* string) {
+	uint32_t index = string->hash % capacity;
+
+	// Deleted slots can be reused since the string is known to be absent.
+	while (IS_OBJ(entries[index])) {
+		index = (index + 1) % capacity;
+	}
+
+	entries[index] = OBJ_VAL(string);
+}
+
+// Rebuilds the string table of [vm], dropping all deleted slots and growing
+// it if needed to make room for another string.
+static void resizeStringTable(CardinalVM* vm) {
+	CardinalStringTable* table = &vm->strings;
+
+	uint32_t live = 0;
+	for (uint32_t i = 0; i < table->capacity; i++) {
+		if (IS_OBJ(table->entries[i])) live++;
+	}
+
+	uint32_t capacity = TABLE_MIN_CAPACITY;
+	while (capacity * MAP_LOAD_PERCENT / 100 < (live + 1) * TABLE_GROW_FACTOR) {
+		capacity *= TABLE_GROW_FACTOR;
+	}
+
+	// This may trigger a GC, which only removes strings from the old array.
+	Value* entries = ALLOCATE_ARRAY(vm, Value, capacity);
+	for (uint32_t i = 0; i < capacity; i++) {
+		entries[i] = UNDEFINED_VAL;
+	}
+
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < table->capacity; i++) {
+		if (!IS_OBJ(table->entries[i])) continue;
+
+		addInternedString(entries, capacity, AS_STRING(table->entries[i]));
+		count++;
+	}
+
+	DEALLOCATE(vm, table->entries);
+	table->entries = entries;
+	table->capacity = capacity;
+	table->count = count;
+}
+
+Value cardinalNewInternedString(CardinalVM* vm, const char* text, size_t length) {
+	ASSERT(length == 0 || text != NULL, "Unexpected NULL string.");
+
+	CardinalStringTable* table = &vm->strings;
+	uint32_t hash = hashBytes(text, length);
+
+	if (table->capacity > 0) {
+		uint32_t index = hash % table->capacity;
+
+		// Stop at the first empty slot, but continue past deleted slots.
+		while (!IS_UNDEFINED(table->entries[index])) {
+			if (IS_OBJ(table->entries[index])) {
+				ObjString* string = AS_STRING(table->entries[index]);
+				// [text] may be NULL for the empty string, which memcmp does not allow.
+				if (string->hash == hash && string->length == (int)length &&
+				        (length == 0 || memcmp(string->value, text, length) == 0)) {
+					return OBJ_VAL(string);
+				}
+			}
+
+			index = (index + 1) % table->capacity;
+		}
+	}
+
+	ObjString* string = allocateString(vm, length);
+	if (length > 0) memcpy(string->value, text, length);
+	cardinalStringCheckEncoding(string);
+	string->hash = hash;
+	string->hashed = true;
+	string->interned = true;
+
+	if ((table->count + 1) * 100 > table->capacity * MAP_LOAD_PERCENT) {
+		CARDINAL_PIN(vm, string);
+		resizeStringTable(vm);
+		CARDINAL_UNPIN(vm);
+	}
+
+	// Count the slot only when it was empty, deleted slots are already counted.
+	uint32_t index = hash % table->capacity;
+	while (IS_OBJ(table->entries[index])) {
+		index = (index + 1) % table->capacity;
+	}
+	if (IS_UNDEFINED(table->entries[index])) table->count++;
+	table->entries[index] = OBJ_VAL(string);
+
+	return OBJ_VAL(string);
+}
+
 // Creates a new string that is the concatenation of [left] and [right].
 ObjString* cardinalStringConcat(CardinalVM* vm, const char* left, int leftLength,
                             const char* right, int rightLength) {
@@ -833,7 +1245,6 @@ ObjString* cardinalStringConcat(CardinalVM* vm, const char* left, int leftLength
 	memcpy(string->value, left, leftLength);
 	memcpy(string->value + leftLength, right, rightLength);
 	string->value[leftLength + rightLength] = '\0';
-	hashString(string);
 	return string;
 }
 
@@ -844,7 +1255,6 @@ Value cardinalStringFromCodePoint(CardinalVM* vm, int value) {
   ObjString* string = allocateString(vm, length);
 
   cardinalUtf8Encode(value, (uint8_t*)string->value);
-  hashString(string);
 
   return OBJ_VAL(string);
 }
@@ -860,8 +1270,6 @@ ObjString* cardinalStringFormat(CardinalVM* vm, const char* str, ...) {
 
 	Value value = cardinalNewString(vm, a, len+1);
 	ObjString* string = AS_STRING(value);
-	
-	hashString(string);
     
     return string;
 /*	
@@ -926,6 +1334,8 @@ ObjString* cardinalStringFormat(CardinalVM* vm, const char* str, ...) {
 Value cardinalStringCodePointAt(CardinalVM* vm, ObjString* string, int index) {
   ASSERT(index < string->length, "Index out of bounds.");
 
+  if (cardinalStringIsAscii(string)) return cardinalNewString(vm, string->value + index, 1);
+
   char first = string->value[index];
 
   // The first byte's high bits tell us how many bytes are in the UTF-8
@@ -941,86 +1351,395 @@ Value cardinalStringCodePointAt(CardinalVM* vm, ObjString* string, int index) {
   return cardinalNewString(vm, string->value + index, numBytes);
 }
 
-// Uses the Boyer-Moore-Horspool string matching algorithm.
-uint32_t cardinalStringFind(CardinalVM* vm, ObjString* haystack, ObjString* needle) {
-	UNUSED(vm);
-	// Corner case, an empty needle is always found.
-	if (needle->length == 0) return 0;
-
-	// If the needle is longer than the haystack it won't be found.
-	if (needle->length > haystack->length) return UINT32_MAX;
-
-	// Pre-calculate the shift table. For each character (8-bit value), we
-	// determine how far the search window can be advanced if that character is
-	// the last character in the haystack where we are searching for the needle
-	// and the needle doesn't match there.
-	uint32_t shift[UINT8_MAX];
-	uint32_t needleEnd = needle->length - 1;
-
-	// By default, we assume the character is not the needle at all. In that case
-	// case, if a match fails on that character, we can advance one whole needle
-	// width since.
-	for (uint32_t index = 0; index < UINT8_MAX; index++) {
-		shift[index] = needle->length;
-	}
-
-	// Then, for every character in the needle, determine how far it is from the
-	// end. If a match fails on that character, we can advance the window such
-	// that it the last character in it lines up with the last place we could
-	// find it in the needle.
-	for (uint32_t index = 0; index < needleEnd; index++) {
-		char c = needle->value[index];
-		shift[(uint8_t)c] = needleEnd - index;
-	}
-
-	// Slide the needle across the haystack, looking for the first match or
-	// stopping if the needle goes off the end.
-	char lastChar = needle->value[needleEnd];
-	uint32_t range = haystack->length - needle->length;
-
-	for (uint32_t index = 0; index <= range; ) {
-		// Compare the last character in the haystack's window to the last character
-		// in the needle. If it matches, see if the whole needle matches.
-		char c = haystack->value[index + needleEnd];
-		if (lastChar == c &&
-		        memcmp(haystack->value + index, needle->value, needleEnd) == 0) {
-			// Found a match.
-			return index;
-		}
+void cardinalStringCheckEncoding(ObjString* string) {
+	bool isAscii = cardinalSimdIsAscii(string->value, string->length);
+	string->encoding = isAscii ? STRING_ASCII : STRING_UTF8;
+}
+
+// Returns true if [c] is the first byte of a code point, and not one of the
+// bytes that continue a UTF-8 sequence.
+static inline bool startsCodePoint(char c) {
+	return (c & 0xc0) != 0x80;
+}
 
-		// Otherwise, slide the needle forward.
-		index += shift[(uint8_t)c];
+int cardinalStringCodePointCount(ObjString* string) {
+	if (string->codePointCount != -1) return string->codePointCount;
+	
+	if (cardinalStringIsAscii(string)) {
+		string->codePointCount = string->length;
+	}
+	else {
+		int count = 0;
+		for (int i = 0; i < string->length; i++) {
+			if (startsCodePoint(string->value[i])) count++;
+		}
+		string->codePointCount = count;
 	}
+	return string->codePointCount;
+}
 
-	// Not found.
-	return UINT32_MAX;
+// Builds the code point index of [string].
+static void indexCodePoints(CardinalVM* vm, ObjString* string) {
+	int count = cardinalStringCodePointCount(string);
+	uint32_t* index = ALLOCATE_ARRAY(vm, uint32_t, (count / STRING_CODE_POINT_STRIDE + 1));
+	
+	int codePoint = 0;
+	for (int i = 0; i < string->length; i++) {
+		if (!startsCodePoint(string->value[i])) continue;
+		
+		if (codePoint % STRING_CODE_POINT_STRIDE == 0) {
+			index[codePoint / STRING_CODE_POINT_STRIDE] = (uint32_t) i;
+		}
+		codePoint++;
+	}
+	
+	string->codePointIndex = index;
 }
 
-// Creates a new open upvalue pointing to [value] on the stack.
-Upvalue* cardinalNewUpvalue(CardinalVM* vm, Value* value) {
-	Upvalue* upvalue = ALLOCATE(vm, Upvalue);
+int cardinalStringCodePointOffset(CardinalVM* vm, ObjString* string, int index) {
+	if (cardinalStringIsAscii(string)) return index;
+	
+	if (string->codePointIndex == NULL) indexCodePoints(vm, string);
+	if (index >= string->codePointCount) return string->length;
+	
+	// Walk to the code point from the closest one in the index before it. The
+	// terminating zero byte stops the walk at the end of the string.
+	int offset = (int) string->codePointIndex[index / STRING_CODE_POINT_STRIDE];
+	for (int skip = index % STRING_CODE_POINT_STRIDE; skip > 0; skip--) {
+		do {
+			offset++;
+		}
+		while (!startsCodePoint(string->value[offset]));
+	}
+	return offset;
+}
 
-	// Upvalues are never used as first-class objects, so don't need a class.
-	initObj(vm, &upvalue->obj, OBJ_UPVALUE, NULL);
+// Finds [needle] with the SIMD substring kernel, which only compares the whole
+// needle where its first and last byte match.
+uint32_t cardinalStringFind(CardinalVM* vm, ObjString* haystack, ObjString* needle, uint32_t start) {
+	UNUSED(vm);
+	if (start > (uint32_t) haystack->length) return UINT32_MAX;
 
-	upvalue->value = value;
-	upvalue->closed = NULL_VAL;
-	upvalue->next = NULL;
-	return upvalue;
+	size_t index = cardinalSimdFind(haystack->value + start, haystack->length - start,
+	                                needle->value, needle->length);
+	if (index == SIZE_MAX) return UINT32_MAX;
+	return start + (uint32_t) index;
 }
 
-// Sets the mark flag on [obj]. Returns true if it was already set so that we
-// can avoid recursing into already-processed objects. That ensures we don't
-// crash on an object cycle.
-static bool setMarkedFlag(CardinalVM* vm, Obj* obj) {
-	UNUSED(vm);
-	if (obj->gcflag & FLAG_MARKED) return true;
-	obj->gcflag = (GCFlag) (obj->gcflag | FLAG_MARKED);
-	return false;
+ObjStringBuilder* cardinalNewStringBuilder(CardinalVM* vm) {
+	ObjStringBuilder* builder = ALLOCATE(vm, ObjStringBuilder);
+	initObj(vm, &builder->obj, OBJ_STRINGBUILDER, vm->metatable.stringBuilderClass);
+	builder->buffer = NULL;
+	builder->length = 0;
+	builder->capacity = 0;
+	return builder;
 }
 
-static void markClass(CardinalVM* vm, ObjClass* classObj);
-static void markFn(CardinalVM* vm, ObjFn* fn);
+void cardinalStringBuilderAdd(CardinalVM* vm, ObjStringBuilder* builder, const char* text, int length) {
+	if (length == -1) length = (int)strlen(text);
+
+	if (builder->length + length > builder->capacity) {
+		int capacity = cardinalStringBuilderCapacity(builder, length);
+		builder->buffer = (char*) cardinalReallocate(vm, builder->buffer, builder->capacity, capacity);
+		builder->capacity = capacity;
+	}
+
+	memcpy(builder->buffer + builder->length, text, length);
+	builder->length += length;
+}
+
+Value cardinalStringBuilderToString(CardinalVM* vm, ObjStringBuilder* builder) {
+	return cardinalNewString(vm, builder->buffer, builder->length);
+}
+
+// Returns the class of typed arrays of [type].
+static ObjClass* typedArrayClass(CardinalVM* vm, CardinalArrayType type) {
+	switch (type) {
+		case CARDINAL_ARRAY_FLOAT64: return vm->metatable.float64ArrayClass;
+		case CARDINAL_ARRAY_INT32: return vm->metatable.int32ArrayClass;
+		case CARDINAL_ARRAY_BYTE: return vm->metatable.byteArrayClass;
+		default:
+			UNREACHABLE("typed array type");
+			return NULL;
+	}
+}
+
+size_t cardinalTypedArrayElementSize(CardinalArrayType type) {
+	switch (type) {
+		case CARDINAL_ARRAY_FLOAT64: return sizeof(double);
+		case CARDINAL_ARRAY_INT32: return sizeof(int32_t);
+		case CARDINAL_ARRAY_BYTE: return sizeof(uint8_t);
+		default:
+			UNREACHABLE("typed array type");
+			return 0;
+	}
+}
+
+ObjTypedArray* cardinalNewTypedArray(CardinalVM* vm, CardinalArrayType type, uint32_t count) {
+	// Allocate this before the array object in case it triggers a GC which would
+	// free the array.
+	uint8_t* data = NULL;
+	if (count > 0) {
+		size_t size = count * cardinalTypedArrayElementSize(type);
+		data = (uint8_t*) cardinalReallocate(vm, NULL, 0, size);
+		memset(data, 0, size);
+	}
+	
+	ObjTypedArray* array = ALLOCATE(vm, ObjTypedArray);
+	initObj(vm, &array->obj, OBJ_TYPEDARRAY, typedArrayClass(vm, type));
+	array->type = type;
+	array->count = count;
+	array->data = data;
+	array->owner = NULL;
+	return array;
+}
+
+ObjTypedArray* cardinalNewTypedArrayView(CardinalVM* vm, ObjTypedArray* array, uint32_t start, uint32_t count) {
+	// A view of a view refers to the array that owns the buffer directly.
+	ObjTypedArray* owner = array->owner != NULL ? array->owner : array;
+	
+	CARDINAL_PIN(vm, array);
+	ObjTypedArray* view = ALLOCATE(vm, ObjTypedArray);
+	CARDINAL_UNPIN(vm);
+	
+	initObj(vm, &view->obj, OBJ_TYPEDARRAY, array->obj.classObj);
+	view->type = array->type;
+	view->count = count;
+	view->data = count > 0 ? array->data + start * cardinalTypedArrayElementSize(array->type) : NULL;
+	view->owner = owner;
+	return view;
+}
+
+Value cardinalTypedArrayGet(ObjTypedArray* array, uint32_t index) {
+	switch (array->type) {
+		case CARDINAL_ARRAY_FLOAT64: return NUM_VAL(((double*) array->data)[index]);
+		case CARDINAL_ARRAY_INT32: return NUM_VAL(((int32_t*) array->data)[index]);
+		case CARDINAL_ARRAY_BYTE: return NUM_VAL(array->data[index]);
+		default:
+			UNREACHABLE("typed array type");
+			return NULL_VAL;
+	}
+}
+
+// Truncates [value] and wraps it around to 32 bits. NaN and infinities become
+// zero.
+static uint32_t wrapToUint32(double value) {
+	if (value >= -2147483648.0 && value < 2147483648.0) return (uint32_t) (int32_t) value;
+	if (!isfinite(value)) return 0;
+	
+	double wrapped = fmod(trunc(value), 4294967296.0);
+	if (wrapped < 0) wrapped += 4294967296.0;
+	return (uint32_t) wrapped;
+}
+
+void cardinalTypedArraySet(ObjTypedArray* array, uint32_t index, double value) {
+	switch (array->type) {
+		case CARDINAL_ARRAY_FLOAT64: ((double*) array->data)[index] = value; break;
+		case CARDINAL_ARRAY_INT32: ((int32_t*) array->data)[index] = (int32_t) wrapToUint32(value); break;
+		case CARDINAL_ARRAY_BYTE: array->data[index] = (uint8_t) wrapToUint32(value); break;
+		default: UNREACHABLE("typed array type");
+	}
+}
+
+void cardinalTypedArrayFill(ObjTypedArray* array, double value) {
+	if (array->count == 0) return;
+	
+	switch (array->type) {
+		case CARDINAL_ARRAY_FLOAT64: {
+			double* elements = (double*) array->data;
+			for (uint32_t i = 0; i < array->count; i++) elements[i] = value;
+			break;
+		}
+		case CARDINAL_ARRAY_INT32: {
+			int32_t* elements = (int32_t*) array->data;
+			int32_t element = (int32_t) wrapToUint32(value);
+			for (uint32_t i = 0; i < array->count; i++) elements[i] = element;
+			break;
+		}
+		case CARDINAL_ARRAY_BYTE:
+			memset(array->data, (uint8_t) wrapToUint32(value), array->count);
+			break;
+		default: UNREACHABLE("typed array type");
+	}
+}
+
+void cardinalTypedArrayCopy(ObjTypedArray* array, ObjTypedArray* source, uint32_t count) {
+	if (count == 0) return;
+	
+	// Views always have the type of the array they share a buffer with, so only
+	// arrays of the same type can overlap.
+	if (array->type == source->type) {
+		memmove(array->data, source->data, count * cardinalTypedArrayElementSize(array->type));
+		return;
+	}
+	
+	for (uint32_t i = 0; i < count; i++) {
+		cardinalTypedArraySet(array, i, AS_NUM(cardinalTypedArrayGet(source, i)));
+	}
+}
+
+ObjDeque* cardinalNewDeque(CardinalVM* vm) {
+	ObjDeque* deque = ALLOCATE(vm, ObjDeque);
+	initObj(vm, &deque->obj, OBJ_DEQUE, vm->metatable.dequeClass);
+	deque->elements = NULL;
+	deque->capacity = 0;
+	deque->count = 0;
+	deque->head = 0;
+	return deque;
+}
+
+// Makes room for one more element in [deque]. A full deque is copied into a
+// buffer twice as large, unwrapped so its first element is in the first slot.
+static void ensureDequeCapacity(CardinalVM* vm, ObjDeque* deque) {
+	if (deque->count < deque->capacity) return;
+
+	int capacity = deque->capacity * 2;
+	if (capacity < DEQUE_MIN_CAPACITY) capacity = DEQUE_MIN_CAPACITY;
+
+	Value* elements = ALLOCATE_ARRAY(vm, Value, capacity);
+	for (int i = 0; i < deque->count; i++) {
+		elements[i] = *cardinalDequeAt(deque, i);
+	}
+
+	DEALLOCATE(vm, deque->elements);
+	deque->elements = elements;
+	deque->capacity = capacity;
+	deque->head = 0;
+}
+
+void cardinalDequePushBack(CardinalVM* vm, ObjDeque* deque, Value value) {
+	if (IS_OBJ(value)) CARDINAL_PIN(vm, AS_OBJ(value));
+	ensureDequeCapacity(vm, deque);
+	if (IS_OBJ(value)) CARDINAL_UNPIN(vm);
+
+	*cardinalDequeAt(deque, deque->count) = value;
+	deque->count++;
+}
+
+void cardinalDequePushFront(CardinalVM* vm, ObjDeque* deque, Value value) {
+	if (IS_OBJ(value)) CARDINAL_PIN(vm, AS_OBJ(value));
+	ensureDequeCapacity(vm, deque);
+	if (IS_OBJ(value)) CARDINAL_UNPIN(vm);
+
+	deque->head = (deque->head - 1) & (deque->capacity - 1);
+	deque->elements[deque->head] = value;
+	deque->count++;
+}
+
+Value cardinalDequePopBack(ObjDeque* deque) {
+	deque->count--;
+	return *cardinalDequeAt(deque, deque->count);
+}
+
+Value cardinalDequePopFront(ObjDeque* deque) {
+	Value value = deque->elements[deque->head];
+	deque->head = (deque->head + 1) & (deque->capacity - 1);
+	deque->count--;
+	return value;
+}
+
+void cardinalDequeClear(CardinalVM* vm, ObjDeque* deque) {
+	DEALLOCATE(vm, deque->elements);
+	deque->elements = NULL;
+	deque->capacity = 0;
+	deque->count = 0;
+	deque->head = 0;
+}
+
+ObjPriorityQueue* cardinalNewPriorityQueue(CardinalVM* vm, Value comparator) {
+	ObjPriorityQueue* queue = ALLOCATE(vm, ObjPriorityQueue);
+	initObj(vm, &queue->obj, OBJ_PRIORITYQUEUE, vm->metatable.priorityQueueClass);
+	queue->elements = NULL;
+	queue->capacity = 0;
+	queue->count = 0;
+	queue->comparator = comparator;
+	queue->callFiber = NULL;
+	queue->isComparing = false;
+	return queue;
+}
+
+void cardinalPriorityQueueAppend(CardinalVM* vm, ObjPriorityQueue* queue, Value value) {
+	if (queue->count >= queue->capacity) {
+		int capacity = queue->capacity * 2;
+		if (capacity < PRIORITY_QUEUE_MIN_CAPACITY) capacity = PRIORITY_QUEUE_MIN_CAPACITY;
+
+		if (IS_OBJ(value)) CARDINAL_PIN(vm, AS_OBJ(value));
+		queue->elements = (Value*) cardinalReallocate(vm, queue->elements,
+		                     queue->capacity * sizeof(Value), capacity * sizeof(Value));
+		queue->capacity = capacity;
+		if (IS_OBJ(value)) CARDINAL_UNPIN(vm);
+	}
+
+	queue->elements[queue->count++] = value;
+}
+
+void cardinalPriorityQueueClear(CardinalVM* vm, ObjPriorityQueue* queue) {
+	DEALLOCATE(vm, queue->elements);
+	queue->elements = NULL;
+	queue->capacity = 0;
+	queue->count = 0;
+}
+
+ObjPipeline* cardinalNewPipeline(CardinalVM* vm, Value source, int numStages) {
+	ObjPipeline* pipeline = ALLOCATE_FLEX(vm, ObjPipeline, PipelineStage, numStages);
+	initObj(vm, &pipeline->obj, OBJ_PIPELINE, vm->metatable.pipelineClass);
+	pipeline->source = source;
+	pipeline->numStages = numStages;
+	for (int i = 0; i < numStages; i++) {
+		pipeline->stages[i].kind = PIPELINE_MAP;
+		pipeline->stages[i].arg = NULL_VAL;
+	}
+	return pipeline;
+}
+
+ObjPipelineIterator* cardinalNewPipelineIterator(CardinalVM* vm, ObjPipeline* pipeline) {
+	ObjPipelineIterator* iterator = ALLOCATE_FLEX(vm, ObjPipelineIterator, PipelineStageState,
+	                                              pipeline->numStages);
+	// Iterators are opaque to scripts, they only get the methods of Object.
+	initObj(vm, &iterator->obj, OBJ_PIPELINE_ITERATOR, vm->metatable.objectClass);
+	iterator->pipeline = pipeline;
+	iterator->sourceIterator = NULL_VAL;
+	iterator->value = NULL_VAL;
+	iterator->callArgs[0] = NULL_VAL;
+	iterator->callArgs[1] = NULL_VAL;
+	iterator->callFiber = NULL;
+	iterator->iterateFiber = NULL;
+	iterator->iteratorValueFiber = NULL;
+	iterator->isBusy = false;
+	for (int i = 0; i < pipeline->numStages; i++) {
+		iterator->stages[i].sequence = NULL_VAL;
+		iterator->stages[i].iterator = NULL_VAL;
+		iterator->stages[i].value = NULL_VAL;
+		iterator->stages[i].count = 0;
+	}
+	return iterator;
+}
+
+// Creates a new open upvalue pointing to [value] on the stack.
+Upvalue* cardinalNewUpvalue(CardinalVM* vm, Value* value) {
+	Upvalue* upvalue = ALLOCATE(vm, Upvalue);
+
+	// Upvalues are never used as first-class objects, so don't need a class.
+	initObj(vm, &upvalue->obj, OBJ_UPVALUE, NULL);
+
+	upvalue->value = value;
+	upvalue->closed = NULL_VAL;
+	upvalue->next = NULL;
+	return upvalue;
+}
+
+// Sets the mark flag on [obj]. Returns true if it was already set so that we
+// can avoid recursing into already-processed objects. That ensures we don't
+// crash on an object cycle.
+static bool setMarkedFlag(CardinalVM* vm, Obj* obj) {
+	UNUSED(vm);
+	if (obj->gcflag & FLAG_MARKED) return true;
+	obj->gcflag = (GCFlag) (obj->gcflag | FLAG_MARKED);
+	return false;
+}
+
+static void markClass(CardinalVM* vm, ObjClass* classObj);
+static void markFn(CardinalVM* vm, ObjFn* fn);
 static void markList(CardinalVM* vm, ObjList* list);
 static void markString(CardinalVM* vm, ObjString* string) ;
 static void markClosure(CardinalVM* vm, ObjClosure* closure);
@@ -1029,35 +1748,24 @@ static void markInstance(CardinalVM* vm, ObjInstance* instance);
 static void markUpvalue(CardinalVM* vm, Upvalue* upvalue);
 
 void markTable(CardinalVM* vm, ObjTable* value);
-void markTableElement(CardinalVM* vm, HashValue* value);
 
 // Mark [value] as reachable and still in use. This should only be called
 // during the sweep phase of a garbage collection.
 void markTable(CardinalVM* vm, ObjTable* list) {
 	if (setMarkedFlag(vm, &list->obj)) return;
 	
-	// Mark the elements.
-	HashValue** elements = list->hashmap;
-	HashValue* ptr = NULL;
+	// Mark the entries.
 	for (int i = 0; i < list->capacity; i++) {
-		if (elements[i] != NULL) {
-			ptr = elements[i];
-			
-			while (ptr != NULL) {
-				markTableElement(vm, ptr);
-				ptr = ptr->next;
-			}
-		}
+		MapEntry* entry = &list->entries[i];
+		if (IS_UNDEFINED(entry->key)) continue;
+		
+		cardinalMarkValue(vm, entry->key);
+		cardinalMarkValue(vm, entry->value);
 	}
-}
-
-// Mark [value] as reachable and still in use. This should only be called
-// during the sweep phase of a garbage collection.
-void markTableElement(CardinalVM* vm, HashValue* value) {
-	if (setMarkedFlag(vm, &value->obj)) return;
 	
-	cardinalMarkValue(vm, value->key);
-	cardinalMarkValue(vm, value->val);
+	// Keep track of how much memory is still in use.
+	vm->garbageCollector.bytesAllocated += sizeof(ObjTable);
+	vm->garbageCollector.bytesAllocated += sizeof(MapEntry) * list->capacity;
 }
 
 static void markClass(CardinalVM* vm, ObjClass* classObj) {
@@ -1070,9 +1778,10 @@ static void markClass(CardinalVM* vm, ObjClass* classObj) {
 	if (classObj->superclasses != NULL) markList(vm, classObj->superclasses);
 
 	// Method function objects.
-	for (int i = 0; i < classObj->methods.count; i++) {
-		if (classObj->methods.data[i].type == METHOD_BLOCK) {
-			cardinalMarkObj(vm, classObj->methods.data[i].fn.obj);
+	for (int i = 0; i < classObj->methods.capacity; i++) {
+		MethodEntry* entry = &classObj->methods.entries[i];
+		if (entry->symbol != -1 && entry->method.type == METHOD_BLOCK) {
+			cardinalMarkObj(vm, entry->method.fn.obj);
 		}
 	}
 
@@ -1081,7 +1790,7 @@ static void markClass(CardinalVM* vm, ObjClass* classObj) {
 	
 	// Keep track of how much memory is still in use.
 	vm->garbageCollector.bytesAllocated += sizeof(ObjClass);
-	vm->garbageCollector.bytesAllocated += classObj->methods.capacity * sizeof(Method);
+	vm->garbageCollector.bytesAllocated += classObj->methods.capacity * sizeof(MethodEntry);
 }
 
 static void markFn(CardinalVM* vm, ObjFn* fn) {
@@ -1110,10 +1819,15 @@ static void markFn(CardinalVM* vm, ObjFn* fn) {
 static void markList(CardinalVM* vm, ObjList* list) {
 	if (setMarkedFlag(vm, &list->obj)) return;
 
-	// Mark the elements.
-	Value* elements = list->elements;
-	for (int i = 0; i < list->count; i++) {
-		cardinalMarkValue(vm, elements[i]);
+	// The elements of a view are marked by the list that owns them.
+	if (list->source != NULL) {
+		cardinalMarkObj(vm, (Obj*) list->source);
+	}
+	else {
+		Value* elements = list->elements;
+		for (int i = 0; i < list->count; i++) {
+			cardinalMarkValue(vm, elements[i]);
+		}
 	}
 
 	// Keep track of how much memory is still in use.
@@ -1130,6 +1844,11 @@ static void markString(CardinalVM* vm, ObjString* string) {
 	vm->garbageCollector.bytesAllocated += sizeof(ObjString);
 
 	vm->garbageCollector.bytesAllocated += string->length;
+	
+	if (string->codePointIndex != NULL) {
+		vm->garbageCollector.bytesAllocated += sizeof(uint32_t) *
+		        (string->codePointCount / STRING_CODE_POINT_STRIDE + 1);
+	}
 }
 
 static void markClosure(CardinalVM* vm, ObjClosure* closure) {
@@ -1158,11 +1877,15 @@ static void markFiber(CardinalVM* vm, ObjFiber* fiber) {
 			cardinalMarkObj(vm, fiber->frames[i].fn);
 		}
 	
-	if (fiber->stack != NULL)
-		// Stack variables.
-		for (Value* slot = fiber->stack; slot < fiber->stacktop; slot++) {
+	// Stack variables. A segment below the current one is in use up to the
+	// slot that receives the result of the frame that was moved out of it.
+	Value* top = fiber->stacktop;
+	for (StackSegment* segment = fiber->segment; segment != NULL; segment = segment->previous) {
+		for (Value* slot = segment->values; slot < top; slot++) {
 			cardinalMarkValue(vm, *slot);
 		}
+		top = segment->returnSlot;
+	}
 
 	// Open upvalues.
 	Upvalue* upvalue = fiber->openUpvalues;
@@ -1173,6 +1896,7 @@ static void markFiber(CardinalVM* vm, ObjFiber* fiber) {
 
 	// The caller.
 	if (fiber->caller != NULL) markFiber(vm, fiber->caller);
+	if (fiber->nativeCaller != NULL) markFiber(vm, fiber->nativeCaller);
 
 	if (fiber->error != NULL) markInstance(vm, fiber->error);
 	
@@ -1180,6 +1904,13 @@ static void markFiber(CardinalVM* vm, ObjFiber* fiber) {
 
 	// Keep track of how much memory is still in use.
 	vm->garbageCollector.bytesAllocated += sizeof(ObjFiber);
+	vm->garbageCollector.bytesAllocated += sizeof(CallFrame) * fiber->framesize;
+	
+	StackSegment* segment = fiber->segment;
+	while (segment != NULL && segment->previous != NULL) segment = segment->previous;
+	for (; segment != NULL; segment = segment->next) {
+		vm->garbageCollector.bytesAllocated += sizeof(StackSegment) + sizeof(Value) * segment->size;
+	}
 }
 
 static void markInstance(CardinalVM* vm, ObjInstance* instance) {
@@ -1219,6 +1950,39 @@ static void markMethod(CardinalVM* vm, ObjMethod* method) {
 	if (method->name != NULL) markString(vm, method->name);
 }
 
+static void markStringBuilder(CardinalVM* vm, ObjStringBuilder* builder) {
+	if (setMarkedFlag(vm, &builder->obj)) return;
+
+	// Keep track of how much memory is still in use.
+	vm->garbageCollector.bytesAllocated += sizeof(ObjStringBuilder);
+	vm->garbageCollector.bytesAllocated += builder->capacity;
+}
+
+static void markDeque(CardinalVM* vm, ObjDeque* deque) {
+	if (setMarkedFlag(vm, &deque->obj)) return;
+
+	for (int i = 0; i < deque->count; i++) {
+		cardinalMarkValue(vm, *cardinalDequeAt(deque, i));
+	}
+
+	// Keep track of how much memory is still in use.
+	vm->garbageCollector.bytesAllocated += sizeof(ObjDeque);
+	vm->garbageCollector.bytesAllocated += sizeof(Value) * deque->capacity;
+}
+
+static void markTypedArray(CardinalVM* vm, ObjTypedArray* array) {
+	if (setMarkedFlag(vm, &array->obj)) return;
+	
+	// A view keeps the array that owns its buffer alive.
+	if (array->owner != NULL) cardinalMarkObj(vm, (Obj*) array->owner);
+
+	// Keep track of how much memory is still in use.
+	vm->garbageCollector.bytesAllocated += sizeof(ObjTypedArray);
+	if (array->owner == NULL) {
+		vm->garbageCollector.bytesAllocated += array->count * cardinalTypedArrayElementSize(array->type);
+	}
+}
+
 static void markMap(CardinalVM* vm, ObjMap* map) {
 	if (setMarkedFlag(vm, &map->obj)) return;
 
@@ -1233,8 +1997,60 @@ static void markMap(CardinalVM* vm, ObjMap* map) {
 
 	// Keep track of how much memory is still in use.
 	vm->garbageCollector.bytesAllocated += sizeof(ObjMap);
-	vm->garbageCollector.bytesAllocated += sizeof(MapEntry) * map->capacity;
+	vm->garbageCollector.bytesAllocated += (sizeof(MapEntry) + sizeof(uint32_t) + sizeof(uint8_t)) * map->capacity;
 }
+
+static void markPriorityQueue(CardinalVM* vm, ObjPriorityQueue* queue) {
+	if (setMarkedFlag(vm, &queue->obj)) return;
+
+	for (int i = 0; i < queue->count; i++) {
+		cardinalMarkValue(vm, queue->elements[i]);
+	}
+	cardinalMarkValue(vm, queue->comparator);
+	if (queue->callFiber != NULL) cardinalMarkObj(vm, (Obj*) queue->callFiber);
+
+	// Keep track of how much memory is still in use.
+	vm->garbageCollector.bytesAllocated += sizeof(ObjPriorityQueue);
+	vm->garbageCollector.bytesAllocated += sizeof(Value) * queue->capacity;
+}
+
+static void markPipeline(CardinalVM* vm, ObjPipeline* pipeline) {
+	if (setMarkedFlag(vm, &pipeline->obj)) return;
+
+	cardinalMarkValue(vm, pipeline->source);
+	for (int i = 0; i < pipeline->numStages; i++) {
+		cardinalMarkValue(vm, pipeline->stages[i].arg);
+	}
+
+	// Keep track of how much memory is still in use.
+	vm->garbageCollector.bytesAllocated += sizeof(ObjPipeline);
+	vm->garbageCollector.bytesAllocated += sizeof(PipelineStage) * pipeline->numStages;
+}
+
+static void markPipelineIterator(CardinalVM* vm, ObjPipelineIterator* iterator) {
+	if (setMarkedFlag(vm, &iterator->obj)) return;
+
+	cardinalMarkObj(vm, (Obj*) iterator->pipeline);
+	cardinalMarkValue(vm, iterator->sourceIterator);
+	cardinalMarkValue(vm, iterator->value);
+	cardinalMarkValue(vm, iterator->callArgs[0]);
+	cardinalMarkValue(vm, iterator->callArgs[1]);
+	if (iterator->callFiber != NULL) cardinalMarkObj(vm, (Obj*) iterator->callFiber);
+	if (iterator->iterateFiber != NULL) cardinalMarkObj(vm, (Obj*) iterator->iterateFiber);
+	if (iterator->iteratorValueFiber != NULL) cardinalMarkObj(vm, (Obj*) iterator->iteratorValueFiber);
+
+	int numStages = iterator->pipeline->numStages;
+	for (int i = 0; i < numStages; i++) {
+		cardinalMarkValue(vm, iterator->stages[i].sequence);
+		cardinalMarkValue(vm, iterator->stages[i].iterator);
+		cardinalMarkValue(vm, iterator->stages[i].value);
+	}
+
+	// Keep track of how much memory is still in use.
+	vm->garbageCollector.bytesAllocated += sizeof(ObjPipelineIterator);
+	vm->garbageCollector.bytesAllocated += sizeof(PipelineStageState) * numStages;
+}
+
 static void markModule(CardinalVM* vm, ObjModule* module) {
 	if (setMarkedFlag(vm, &module->obj)) return;
 
@@ -1285,10 +2101,16 @@ void cardinalMarkObj(CardinalVM* vm, Obj* obj) {
 		case OBJ_UPVALUE: markUpvalue(vm, (Upvalue*) obj); break;
 		case OBJ_RANGE: setMarkedFlag(vm, obj); break;
 		case OBJ_TABLE: markTable(vm, (ObjTable*) obj); break;
-		case OBJ_TABLE_ELEM: markTableElement(vm, (HashValue*) obj); break;
 		case OBJ_MAP: markMap(vm, (ObjMap*) obj); break;
 		case OBJ_MODULE: markModule(vm, (ObjModule*) obj); break;
 		case OBJ_METHOD: markMethod(vm, (ObjMethod*) obj); break;
+		case OBJ_STRINGBUILDER: markStringBuilder(vm, (ObjStringBuilder*) obj); break;
+		case OBJ_TYPEDARRAY: markTypedArray(vm, (ObjTypedArray*) obj); break;
+		case OBJ_DEQUE: markDeque(vm, (ObjDeque*) obj); break;
+		case OBJ_SET: markMap(vm, (ObjMap*) obj); break;
+		case OBJ_PRIORITYQUEUE: markPriorityQueue(vm, (ObjPriorityQueue*) obj); break;
+		case OBJ_PIPELINE: markPipeline(vm, (ObjPipeline*) obj); break;
+		case OBJ_PIPELINE_ITERATOR: markPipelineIterator(vm, (ObjPipelineIterator*) obj); break;
 		case OBJ_DEAD: break;
 		default: break;
 	}	
@@ -1306,6 +2128,13 @@ void cardinalFreeObj(CardinalVM* vm, Obj* obj) {
 	printf(" @ %p\n", obj);
 #endif
 
+	// Keep collected fibers, so creating a new one is cheap.
+	if (obj->type == OBJ_FIBER && ((ObjFiber*)obj)->segment != NULL &&
+	    vm->fiberPool.count < FIBER_POOL_MAX) {
+		poolFiber(vm, (ObjFiber*)obj);
+		return;
+	}
+
 	cardinalFreeObjContent(vm, obj);
 	cardinalReallocate(vm, obj, 0, 0);
 }
@@ -1314,7 +2143,7 @@ void cardinalFreeObj(CardinalVM* vm, Obj* obj) {
 void cardinalFreeObjContent(CardinalVM* vm, Obj* obj) {
 	switch (obj->type) {
 		case OBJ_CLASS:
-			cardinalMethodBufferClear(vm, &((ObjClass*)obj)->methods);
+			DEALLOCATE(vm, ((ObjClass*)obj)->methods.entries);
 			break;
 
 		case OBJ_FN: 
@@ -1333,20 +2162,49 @@ void cardinalFreeObjContent(CardinalVM* vm, Obj* obj) {
 		}
 
 		case OBJ_LIST:
-			cardinalReallocate(vm, ((ObjList*)obj)->elements, 0, 0);
+			if (((ObjList*)obj)->source == NULL) {
+				cardinalReallocate(vm, ((ObjList*)obj)->elements, 0, 0);
+			}
 			break;
 			
 		case OBJ_MAP:
+		case OBJ_SET:
 			cardinalReallocate(vm, ((ObjMap*)obj)->entries, 0, 0);
 			break;
 
+		case OBJ_STRING:
+			cardinalReallocate(vm, ((ObjString*)obj)->codePointIndex, 0, 0);
+			break;
+
+		case OBJ_PRIORITYQUEUE:
+			cardinalReallocate(vm, ((ObjPriorityQueue*)obj)->elements, 0, 0);
+			break;
+			
+		case OBJ_STRINGBUILDER:
+			cardinalReallocate(vm, ((ObjStringBuilder*)obj)->buffer, 0, 0);
+			break;
+			
+		case OBJ_TYPEDARRAY:
+			// Views don't own their buffer.
+			if (((ObjTypedArray*)obj)->owner == NULL) {
+				cardinalReallocate(vm, ((ObjTypedArray*)obj)->data, 0, 0);
+			}
+			break;
+
+		case OBJ_DEQUE:
+			cardinalReallocate(vm, ((ObjDeque*)obj)->elements, 0, 0);
+			break;
+
 		case OBJ_TABLE:
-			cardinalReallocate(vm, ((ObjTable*)obj)->hashmap, 0, 0);
+			cardinalReallocate(vm, ((ObjTable*)obj)->entries, 0, 0);
 			break;
-		case OBJ_FIBER:
-			cardinalReallocate(vm, ((ObjFiber*)obj)->stack, 0, 0);
+		case OBJ_FIBER: {
+			StackSegment* segment = ((ObjFiber*)obj)->segment;
+			while (segment != NULL && segment->previous != NULL) segment = segment->previous;
+			if (segment != NULL) cardinalFreeStackSegments(vm, segment);
 			cardinalReallocate(vm, ((ObjFiber*)obj)->frames, 0, 0);
 			break;
+		}
 		case OBJ_MODULE:
 			cardinalSymbolTableClear(vm, &((ObjModule*)obj)->variableNames);
 			cardinalValueBufferClear(vm, &((ObjModule*)obj)->variables);
@@ -1363,9 +2221,9 @@ void cardinalFreeObjContent(CardinalVM* vm, Obj* obj) {
 			cardinalReallocate(vm, inst->fields, 0, 0);
 			break;
 		}
-		case OBJ_STRING:
-		case OBJ_TABLE_ELEM:
 		case OBJ_CLOSURE:
+		case OBJ_PIPELINE:
+		case OBJ_PIPELINE_ITERATOR:
 		case OBJ_RANGE:
 		case OBJ_UPVALUE:
 		case OBJ_METHOD:
@@ -1408,20 +2266,41 @@ static void printObject(Obj* obj) {
 		case OBJ_STRING: printf("\"%s\"", ((ObjString*)obj)->value); break;
 		case OBJ_UPVALUE: printf("[upvalue %p]", obj); break;
 		case OBJ_TABLE: printf("[table %p]", obj); break;
-		case OBJ_TABLE_ELEM: printf("[table element %p]", obj); break;
 		case OBJ_MAP: printf("[map %p]", obj); break;
 		case OBJ_MODULE: printf("[module %p]", obj); break;
 		case OBJ_RANGE: printf("[fn %p]", obj); break;
 		case OBJ_METHOD: printf("[method %p]", obj); break;
+		case OBJ_STRINGBUILDER: printf("[stringbuilder %p]", obj); break;
+		case OBJ_TYPEDARRAY: printf("[typedarray %p]", obj); break;
+		case OBJ_DEQUE: printf("[deque %p]", obj); break;
+		case OBJ_SET: printf("[set %p]", obj); break;
+		case OBJ_PRIORITYQUEUE: printf("[priorityqueue %p]", obj); break;
+		case OBJ_PIPELINE: printf("[pipeline %p]", obj); break;
+		case OBJ_PIPELINE_ITERATOR: printf("[pipeline iterator %p]", obj); break;
 		case OBJ_DEAD: printf("[dead object %p]", obj); break;
 		default: printf("[unknown object]"); break;
 	}
 }
 
+static void printNumber(double value) {
+	char buffer[NUMBER_BUFFER_SIZE];
+	cardinalFormatNumber(value, buffer);
+	printf("%s", buffer);
+}
+
+static void printInteger(int64_t value) {
+	char buffer[NUMBER_BUFFER_SIZE];
+	cardinalFormatInteger(value, buffer);
+	printf("%s", buffer);
+}
+
 void cardinalPrintValue(Value value) {
 #if CARDINAL_NAN_TAGGING
-	if (IS_NUM(value)) {
-		printf("%.14g", AS_NUM(value));
+	if (IS_INT(value)) {
+		printInteger(AS_INT(value));
+	}
+	else if (IS_NUM(value)) {
+		printNumber(AS_NUM(value));
 	}
 	else if (IS_OBJ(value)) {
 		printObject(AS_OBJ(value));
@@ -1442,7 +2321,8 @@ void cardinalPrintValue(Value value) {
 	switch (value.type) {
 		case VAL_FALSE: printf("false"); break;
 		case VAL_NULL: printf("null"); break;
-		case VAL_NUM: printf("%.14g", AS_NUM(value)); break;
+		case VAL_NUM: printNumber(AS_NUM(value)); break;
+		case VAL_INT: printInteger(AS_INT(value)); break;
 		case VAL_TRUE: printf("true"); break;
 		case VAL_POINTER: printf("[pointer %p]", AS_POINTER(value)); break;
 		case VAL_OBJ: printObject(AS_OBJ(value));
@@ -1481,9 +2361,19 @@ bool cardinalValuesEqual(Value a, Value b) {
 		case OBJ_STRING: {
 			ObjString* aString = (ObjString*)aObj;
 			ObjString* bString = (ObjString*)bObj;
-			return aString->length == bString->length &&
-					aString->hash == bString->hash &&
-			       memcmp(aString->value, bString->value, aString->length) == 0;
+
+			// Interned strings are unique, so different ones are never equal.
+			if (aString->interned && bString->interned) return false;
+
+			if (aString->length != bString->length) return false;
+
+			// Only compare hashes when both are already known, rather than forcing
+			// them to be calculated.
+			if (aString->hashed && bString->hashed && aString->hash != bString->hash) {
+				return false;
+			}
+
+			return memcmp(aString->value, bString->value, aString->length) == 0;
 		}
 
 		default:
@@ -1493,281 +2383,289 @@ bool cardinalValuesEqual(Value a, Value b) {
 	}
 }
 
+// A handle stores the generation of its slot in the upper half of the pointer
+// and the index plus one in the lower half, so that no handle is `NULL`. On
+// 32-bit targets this leaves room for 65535 slots.
+#define HOST_HANDLE_SHIFT (sizeof(uintptr_t) * 4)
+#define HOST_HANDLE_MASK ((((uintptr_t) 1) << HOST_HANDLE_SHIFT) - 1)
+
+// The [nextFree] of a slot that is in use.
+#define HOST_SLOT_IN_USE (-2)
+
+static inline CardinalValue* makeHostHandle(int index, uintptr_t generation) {
+	return (CardinalValue*) ((generation << HOST_HANDLE_SHIFT) | (uintptr_t) (index + 1));
+}
+
+// Returns the slot of [key], or `NULL` if [key] has been released.
+static inline HostSlot* hostSlot(CardinalVM* vm, CardinalValue* key) {
+	uintptr_t handle = (uintptr_t) key;
+	int index = (int) (handle & HOST_HANDLE_MASK) - 1;
+	if (index < 0 || index >= vm->hostObjects.max) return NULL;
+	
+	HostSlot* slot = &vm->hostObjects.slots[index];
+	if (slot->generation != (handle >> HOST_HANDLE_SHIFT)) return NULL;
+	return slot;
+}
+
 Value cardinalGetHostObject(CardinalVM* vm, CardinalValue* key) {
-	//int ind = cardinalMapFind(vm->hostObjects.hostObjects, NUM_VAL(key->value));
-	//return vm->hostObjects.hostObjects->entries[ind].value;
-	return cardinalTableFind(vm, vm->hostObjects.hostObjects, NUM_VAL(key->value));
+	HostSlot* slot = hostSlot(vm, key);
+	ASSERT(slot != NULL, "Host object was already released.");
+	if (slot == NULL) return NULL_VAL;
+	return slot->value;
 }
 
 void cardinalSetHostObject(CardinalVM* vm, Value val, CardinalValue* key) {
-	cardinalTableAdd(vm, vm->hostObjects.hostObjects, NUM_VAL(key->value), val);
+	HostSlot* slot = hostSlot(vm, key);
+	if (slot != NULL) slot->value = val;
 }
 
 CardinalValue* cardinalCreateHostObject(CardinalVM* vm, Value val) {
-	if (IS_OBJ(val)) CARDINAL_PIN(vm, AS_OBJ(val));
-	CardinalValue* ret = ALLOCATE(vm, CardinalValue);
+	CardinalHost* host = &vm->hostObjects;
+	
+	if (host->firstFree == -1) {
+		// The index of the new slot would not fit in a handle.
+		if ((uintptr_t) host->max >= HOST_HANDLE_MASK) return NULL;
+		
+		if (host->max == host->capacity) {
+			// Growing may trigger a GC, and [val] is not in the table yet.
+			if (IS_OBJ(val)) CARDINAL_PIN(vm, AS_OBJ(val));
+			int capacity = host->capacity == 0 ? HOST_OBJECTS_MIN_CAPACITY : host->capacity * 2;
+			if ((uintptr_t) capacity > HOST_HANDLE_MASK) capacity = (int) HOST_HANDLE_MASK;
+			host->slots = (HostSlot*) cardinalReallocate(vm, host->slots,
+				host->capacity * sizeof(HostSlot), capacity * sizeof(HostSlot));
+			host->capacity = capacity;
+			if (IS_OBJ(val)) CARDINAL_UNPIN(vm);
+		}
+		
+		host->slots[host->max].generation = 0;
+		host->slots[host->max].nextFree = -1;
+		host->firstFree = host->max++;
+	}
+	
+	int index = host->firstFree;
+	HostSlot* slot = &host->slots[index];
+	host->firstFree = slot->nextFree;
+	host->count++;
+	
+	slot->nextFree = HOST_SLOT_IN_USE;
+	slot->value = val;
+	return makeHostHandle(index, slot->generation);
+}
 
-	if (vm->hostObjects.freeNums->count > 0)
-		ret->value = AS_NUM(cardinalListRemoveAt(vm, vm->hostObjects.freeNums, vm->hostObjects.freeNums->count-1));
-	else {
-		ret->value = vm->hostObjects.max;
-		vm->hostObjects.max++;
-	}	
+void cardinalRemoveHostObject(CardinalVM* vm, CardinalValue* key) {
+	HostSlot* slot = hostSlot(vm, key);
+	ASSERT(slot != NULL, "Host object was already released.");
+	if (slot == NULL) return;
+	
+	slot->value = NULL_VAL;
+	slot->generation = (slot->generation + 1) & (((uintptr_t) -1) >> HOST_HANDLE_SHIFT);
+	slot->nextFree = vm->hostObjects.firstFree;
+	vm->hostObjects.firstFree = (int) (slot - vm->hostObjects.slots);
+	vm->hostObjects.count--;
+}
 
-	cardinalTableAdd(vm, vm->hostObjects.hostObjects, NUM_VAL(ret->value), val);
-	if (IS_OBJ(val)) CARDINAL_UNPIN(vm);
-	return ret;
+CardinalValue* cardinalHostObjectAt(CardinalVM* vm, int index) {
+	if (index < 0 || index >= vm->hostObjects.max) return NULL;
+	
+	HostSlot* slot = &vm->hostObjects.slots[index];
+	if (slot->nextFree != HOST_SLOT_IN_USE) return NULL;
+	return makeHostHandle(index, slot->generation);
 }
 
-void cardinalRemoveHostObject(CardinalVM* vm, CardinalValue* key) {
-	Value v = NUM_VAL(key->value);
-	if (IS_OBJ(v)) CARDINAL_PIN(vm, AS_OBJ(v));
-	cardinalTableRemove(vm, vm->hostObjects.hostObjects, v);
-	cardinalListAdd(vm, vm->hostObjects.freeNums, NUM_VAL(key->value));
-	if (IS_OBJ(v)) CARDINAL_UNPIN(vm);
+void cardinalMarkHostObjects(CardinalVM* vm) {
+	for (int i = 0; i < vm->hostObjects.max; i++) {
+		cardinalMarkValue(vm, vm->hostObjects.slots[i].value);
+	}
 	
-	cardinalReallocate(vm, key, 0, 0);
+	// Keep track of how much memory is still in use.
+	vm->garbageCollector.bytesAllocated += vm->hostObjects.capacity * sizeof(HostSlot);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////
 //// FUNCTIONS: TABLE	
 ///////////////////////////////////////////////////////////////////////////////////
 
-// Creates a new list with [numElements] elements (which are left
-// uninitialized.)
-ObjTable* cardinalNewTable(CardinalVM* vm, int numElements) {
-	if (numElements < TABLE_MIN_CAPACITY)
-		numElements = TABLE_MIN_CAPACITY;
-
-	// Allocate this before the list object in case it triggers a GC which would
-	// free the list.
-	HashValue** elements = NULL;
-	if (numElements > 0) {
-		elements = ALLOCATE_ARRAY(vm, HashValue*, numElements);
+// Returns the entry of [key] in [entries], or the entry where [key] should be
+// inserted if it is not in the table. This is the first tombstone on the way,
+// if any.
+static MapEntry* findTableEntry(MapEntry* entries, int capacity, Value key) {
+	uint32_t mask = (uint32_t) capacity - 1;
+	uint32_t index = mixHash(hashValue(key)) & mask;
+	MapEntry* tombstone = NULL;
+	
+	// The table is never full, so this always reaches an open entry.
+	while (true) {
+		MapEntry* entry = &entries[index];
+		
+		if (IS_UNDEFINED(entry->key)) {
+			if (IS_FALSE(entry->value)) return tombstone != NULL ? tombstone : entry;
+			if (tombstone == NULL) tombstone = entry;
+		}
+		else if (cardinalValuesEqual(entry->key, key)) {
+			return entry;
+		}
 		
-		for(int i=0; i<numElements; i++)
-			elements[i] = NULL;
+		index = (index + 1) & mask;
 	}
+}
 
-	ObjTable* list = ALLOCATE(vm, ObjTable);
-	initObj(vm, &list->obj, OBJ_TABLE, vm->metatable.tableClass);
-	list->capacity = numElements;
+// Moves the pairs of [list] into a new array of [capacity] entries, which also
+// drops all tombstones.
+static void resizeTable(CardinalVM* vm, ObjTable* list, int capacity) {
+	// Allocate first, a GC still sees the old entries.
+	MapEntry* entries = ALLOCATE_ARRAY(vm, MapEntry, capacity);
+	for (int i = 0; i < capacity; i++) {
+		entries[i].key = UNDEFINED_VAL;
+		entries[i].value = FALSE_VAL;
+	}
 	
-	list->count = 0;
-	list->hashmap = elements;
+	// The keys are unique, so they only need an open entry.
+	uint32_t mask = (uint32_t) capacity - 1;
+	for (int i = 0; i < list->capacity; i++) {
+		MapEntry* entry = &list->entries[i];
+		if (IS_UNDEFINED(entry->key)) continue;
+		
+		uint32_t index = mixHash(hashValue(entry->key)) & mask;
+		while (!IS_UNDEFINED(entries[index].key)) index = (index + 1) & mask;
+		entries[index] = *entry;
+	}
 	
-	return list;
+	DEALLOCATE(vm, list->entries);
+	list->entries = entries;
+	list->capacity = capacity;
+	list->deleted = 0;
 }
 
-static void checkNullTable(CardinalVM* vm, ObjTable* list) {
-	if (list->hashmap != NULL) return;
+// Creates a new table with room for [numElements] pairs before it has to grow.
+ObjTable* cardinalNewTable(CardinalVM* vm, int numElements) {
+	ObjTable* list = ALLOCATE(vm, ObjTable);
+	initObj(vm, &list->obj, OBJ_TABLE, vm->metatable.tableClass);
+	list->capacity = 0;
+	list->count = 0;
+	list->deleted = 0;
+	list->entries = NULL;
 	
-	int numElements = TABLE_MIN_CAPACITY;
-	HashValue** elements = NULL;
 	if (numElements > 0) {
-		elements = ALLOCATE_ARRAY(vm, HashValue*, numElements);
-		
-		for(int i=0; i<numElements; i++)
-			elements[i] = NULL;
+		CARDINAL_PIN(vm, list);
+		resizeTable(vm, list, hashCapacityFor(numElements));
+		CARDINAL_UNPIN(vm);
 	}
-
-	list->capacity = numElements;
-	list->count = 0;
-	list->hashmap = elements;
+	
+	return list;
 }
 
 void cardinalTablePrint(CardinalVM* vm, ObjTable* list) {
-	checkNullTable(vm, list);
+	UNUSED(vm);
 	printf("Table: \n");
-	for(int i=0; i<list->capacity; i++) {
-		// check if element exists first
-		HashValue* ptr = list->hashmap[i];
-		while (ptr != NULL) {
-			printf("Key: ");
-			cardinalPrintValue(ptr->key);
-			printf(" Value: ");
-			cardinalPrintValue(ptr->val);
-			printf(" at hash: %d\n", i);
-			
-			ptr = ptr->next;
-		}
+	for (int i = 0; i < list->capacity; i++) {
+		MapEntry* entry = &list->entries[i];
+		if (IS_UNDEFINED(entry->key)) continue;
+		
+		printf("Key: ");
+		cardinalPrintValue(entry->key);
+		printf(" Value: ");
+		cardinalPrintValue(entry->value);
+		printf(" at hash: %d\n", i);
 	}
 }
 
-// Grows [list] if needed to ensure it can hold [count] elements.
-static bool ensureTableCapacity(CardinalVM* vm, ObjTable* list) {
-	HashValue** elements = NULL;
-	int newSize = 0;
-	if (list->count > list->capacity) {
-		newSize = list->capacity * TABLE_GROW_FACTOR;				
-	}
-	else if (list->capacity > TABLE_MIN_CAPACITY && list->count < list->capacity / 2 - 1) {
-		newSize = list->capacity / TABLE_GROW_FACTOR;		
-	}
-	else
-		return false;
-	
-	elements = ALLOCATE_ARRAY(vm, HashValue*, newSize);
-	for(int i=0; i<newSize; i++)
-		elements[i] = NULL;
+// Associates [key] with [value] in [list], growing its storage if needed.
+void cardinalTableAdd(CardinalVM* vm, ObjTable* list, Value key, Value value) {
+	MapEntry* entry = NULL;
+	if (list->capacity > 0) {
+		entry = findTableEntry(list->entries, list->capacity, key);
 		
-	for(int i=0; i<list->capacity; i++) {
-		// check if element exists first
-		HashValue* ptr = list->hashmap[i];
-		HashValue* temp;
-		while (ptr != NULL) {
-			cardinal_uinteger hash = hashValue(ptr->key);
-			hash = hash % newSize;
-			
-			temp = ptr->next;
-			
-			// set the element in the linked list
-			ptr->next = elements[hash];
-			elements[hash] = ptr;
-			ptr = temp;
+		if (!IS_UNDEFINED(entry->key)) {
+			entry->value = value;
+			return;
 		}
 	}
 	
-	cardinalReallocate(vm, list->hashmap, 0, 0);
-	list->hashmap = elements;
-	list->capacity = newSize;
-	return true;
-}
-
-// Adds [value] to [list], reallocating and growing its storage if needed.
-void cardinalTableAdd(CardinalVM* vm, ObjTable* list, Value key, Value value) {
-	if (IS_OBJ(value)) CARDINAL_PIN(vm, AS_OBJ(value));
-	if (IS_OBJ(key)) CARDINAL_PIN(vm, AS_OBJ(key));
-	
-	checkNullTable(vm, list);
-	
-	cardinal_uinteger hash = hashValue(key);
-	hash = hash % list->capacity;
-	
-	// check if element exists first
-	HashValue* ptr = list->hashmap[hash];
-	while (ptr != NULL && !cardinalValuesEqual(ptr->key, key)) ptr = ptr->next;
-	
-	if (ptr == NULL) {
-		if (ensureTableCapacity(vm, list)) {
-			hash = hashValue(key);
-			hash = hash % list->capacity;
-		}
-		
-		// create a new element
-		HashValue* element = ALLOCATE(vm, HashValue);
-		initObj(vm, &element->obj, OBJ_TABLE_ELEM, NULL);
+	// Keep an open entry to end every probe, tombstones included.
+	if ((list->count + list->deleted + 1) > list->capacity * MAP_LOAD_PERCENT / 100) {
+		if (IS_OBJ(value)) CARDINAL_PIN(vm, AS_OBJ(value));
+		if (IS_OBJ(key)) CARDINAL_PIN(vm, AS_OBJ(key));
 		
-		// set the values of the element
-		element->key = key;
-		element->val = value;
+		resizeTable(vm, list, hashCapacityFor(list->count + 1));
+		entry = findTableEntry(list->entries, list->capacity, key);
 		
-		// set the element in the linked list
-		element->next = list->hashmap[hash];
-		list->hashmap[hash] = element;
-		list->count++;
-	}
-	else {
-		ptr->val = value;
+		if (IS_OBJ(key)) CARDINAL_UNPIN(vm);
+		if (IS_OBJ(value)) CARDINAL_UNPIN(vm);
 	}
 	
-	if (IS_OBJ(key)) CARDINAL_UNPIN(vm);
-	if (IS_OBJ(value)) CARDINAL_UNPIN(vm);
+	// Reuse a tombstone.
+	if (IS_TRUE(entry->value)) list->deleted--;
+	
+	entry->key = key;
+	entry->value = value;
+	list->count++;
 }
 
-// Find [key] in [list], shifting down the other elements.
+// Find the value of [key] in [list], or null if it is not in the table.
 Value cardinalTableFind(CardinalVM* vm, ObjTable* list, Value key) {
-	if (IS_OBJ(key)) CARDINAL_PIN(vm, AS_OBJ(key));
-	checkNullTable(vm, list);
-	if (IS_OBJ(key)) CARDINAL_UNPIN(vm);
+	UNUSED(vm);
+	if (list->count == 0) return NULL_VAL;
 	
-	cardinal_uinteger hash = hashValue(key);
-	hash = hash % list->capacity;
+	MapEntry* entry = findTableEntry(list->entries, list->capacity, key);
+	if (IS_UNDEFINED(entry->key)) return NULL_VAL;
+	return entry->value;
+}
 
-	HashValue* ptr = list->hashmap[hash];
-	
-	while (ptr != NULL && !cardinalValuesEqual(ptr->key, key)) ptr = ptr->next;
+// Returns whether [key] is in [list].
+bool cardinalTableContains(ObjTable* list, Value key) {
+	if (list->count == 0) return false;
 	
-	if (ptr == NULL)
-		return NULL_VAL;
-	else
-		return ptr->val;
+	return !IS_UNDEFINED(findTableEntry(list->entries, list->capacity, key)->key);
 }
 
-// Removes and returns the item at [index] from [list].
+// Removes [key] from [list] and returns its value, or null if it was not there.
 Value cardinalTableRemove(CardinalVM* vm, ObjTable* list, Value key) {
-	if (IS_OBJ(key)) CARDINAL_PIN(vm, AS_OBJ(key));
-	checkNullTable(vm, list);
-	if (IS_OBJ(key)) CARDINAL_UNPIN(vm);
+	if (list->count == 0) return NULL_VAL;
 	
-	cardinal_uinteger hash = hashValue(key);
-	hash = hash % list->capacity;
+	MapEntry* entry = findTableEntry(list->entries, list->capacity, key);
+	if (IS_UNDEFINED(entry->key)) return NULL_VAL;
 	
-	HashValue* ptr = list->hashmap[hash];
-	HashValue* prev = NULL;
+	Value value = entry->value;
+	entry->key = UNDEFINED_VAL;
+	entry->value = TRUE_VAL;
+	list->count--;
+	list->deleted++;
 	
-	while (ptr != NULL && !cardinalValuesEqual(ptr->key, key)) {
-		prev = ptr;
-		ptr = ptr->next;
+	if (list->count == 0) {
+		cardinalTableClear(vm, list);
+	}
+	else if (list->capacity > TABLE_MIN_CAPACITY &&
+	         list->count < list->capacity * MAP_LOAD_PERCENT / 100 / 4) {
+		// Shrink once a quarter of the load is left, so that adding and removing
+		// around the boundary does not resize every time.
+		if (IS_OBJ(value)) CARDINAL_PIN(vm, AS_OBJ(value));
+		resizeTable(vm, list, list->capacity / TABLE_GROW_FACTOR);
+		if (IS_OBJ(value)) CARDINAL_UNPIN(vm);
 	}
 	
-	if (ptr == NULL)
-		return NULL_VAL;
-	else {
-		Value ret = ptr->val;
-		
-		if (prev)
-			prev->next = ptr->next;
-		else
-			list->hashmap[hash] = ptr->next;
-		list->count--;
-		return ret;
+	return value;
+}
+
+// Removes all pairs from [list] and frees its entries.
+void cardinalTableClear(CardinalVM* vm, ObjTable* list) {
+	DEALLOCATE(vm, list->entries);
+	list->entries = NULL;
+	list->capacity = 0;
+	list->count = 0;
+	list->deleted = 0;
+}
+
+int cardinalTableNext(ObjTable* table, int index) {
+	for (int i = index; i < table->capacity; i++) {
+		if (!IS_UNDEFINED(table->entries[i].key)) return i;
 	}
+	return -1;
 }
 
-HashValue* cardinalGetTableIndex(ObjTable* list, int ind) {
-	HashValue* ptr;
-	int i = 0;
-	int len = 0;
-	while (len < list->capacity) {
-		ptr = list->hashmap[len];
-		
-		if (ptr == NULL) {
-			len++;
-			continue;
-		}
-		
-		while (ptr != NULL && i != ind) {
-			ptr = ptr->next;
-			i++;
-		}
-		
-		if (i == ind && ptr != NULL)
-			return ptr;
-		len++;
+MapEntry* cardinalGetTableIndex(ObjTable* table, int ind) {
+	for (int i = 0; i < table->capacity; i++) {
+		if (IS_UNDEFINED(table->entries[i].key)) continue;
+		if (ind-- == 0) return &table->entries[i];
 	}
 	return NULL;
-	
-	/*
-	HashValue* ptr;
-	int i = 0;
-	int len = 0;
-	while (len < list->capacity) {
-		ptr = list->hashmap[len];
-		
-		if (ptr == NULL) {
-			len++;
-			continue;
-		}
-		
-		while (ptr != NULL && i != ind) {
-			ptr = ptr->next;
-			i++;
-		}
-		
-		if (i == ind)
-			return ptr;
-		len++;
-	}
-	return NULL;*/
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef cardinal_value_h
 #define cardinal_value_h
 
+#include <math.h>
 #include <stdbool.h>
 
 #include "cardinal_utils.h"
@@ -98,14 +99,26 @@ typedef enum ObjType {
 	OBJ_RANGE,
 	// HashTable class
 	OBJ_TABLE,
-	// HashTable element
-	OBJ_TABLE_ELEM,
 	// Hashmap
 	OBJ_MAP,
 	// Module
 	OBJ_MODULE,
 	// Method
 	OBJ_METHOD,
+	// Mutable string buffer
+	OBJ_STRINGBUILDER,
+	// Array of unboxed numbers
+	OBJ_TYPEDARRAY,
+	// Double-ended queue
+	OBJ_DEQUE,
+	// Set of value types, stored in a map
+	OBJ_SET,
+	// Binary heap
+	OBJ_PRIORITYQUEUE,
+	// Lazy chain of sequence adapters
+	OBJ_PIPELINE,
+	// State of an iteration over a pipeline
+	OBJ_PIPELINE_ITERATOR,
 	// Dead object
 	OBJ_DEAD
 } ObjType;
@@ -141,6 +154,7 @@ typedef struct rawObj {
 		VAL_TRUE,
 		VAL_NULL,
 		VAL_NUM,
+		VAL_INT,
 		VAL_POINTER,
 		VAL_UNDEFINED,
 		VAL_OBJ
@@ -155,6 +169,8 @@ typedef struct rawObj {
 	typedef union ValueUnion {
 		/// Real number
 		cardinal_number num;
+		/// Small integer
+		int64_t integer;
 		/// GC object
 		Obj* obj;
 	} ValueUnion;
@@ -170,14 +186,22 @@ typedef struct rawObj {
 #endif
 
 /// Type used to expose values to the API
-struct CardinalValue {
-	/// The exposed key of the value stored in the host application
-	int value;
-};
+/// [CardinalValue] is never defined: a handle encodes a slot of the host object
+/// table of the VM in the pointer itself. See [CardinalHost].
 
 DECLARE_BUFFER(Value, Value);
 DECLARE_BUFFER(ValuePtr, Value*);
 
+/// What is known about the characters of a string
+typedef enum StringEncoding {
+	/// The bytes have not been checked yet
+	STRING_UNKNOWN,
+	/// Every character is ASCII, so every byte is a code point
+	STRING_ASCII,
+	/// There are multi-byte UTF-8 sequences
+	STRING_UTF8
+} StringEncoding;
+
 /// OBJECT
 /// A string class
 typedef struct ObjString { EXTENDS(Obj) 
@@ -187,9 +211,27 @@ typedef struct ObjString { EXTENDS(Obj)
 	/// The length of the string
 	int length;
 	
-	/// The hash value of the string's contents.
+	/// The hash value of the string's contents. Only valid once [hashed] is set.
 	uint32_t hash;
 	
+	/// Indicates whether [hash] has been calculated yet. Hashing is deferred
+	/// until the string is first used as a key.
+	bool hashed;
+	
+	/// Indicates whether the string is stored in the string table of the VM
+	bool interned;
+	
+	/// Whether the string is ASCII, one of [StringEncoding]. Known from creation
+	/// unless the buffer was filled in after the string was allocated.
+	uint8_t encoding;
+	
+	/// The number of code points, or -1 if it has not been counted yet
+	int codePointCount;
+	
+	/// The byte offset of every [STRING_CODE_POINT_STRIDE]th code point. Built
+	/// when a code point of a non-ASCII string is first looked up by its index.
+	uint32_t* codePointIndex;
+	
 	/// The contained c-string;
 	char value[FLEXIBLE_ARRAY];
 } ObjString;
@@ -327,6 +369,34 @@ typedef struct ObjInstance { EXTENDS(Obj)
 	Value* fields; //[FLEXIBLE_ARRAY];
 } ObjInstance;
 
+/// A chunk of the stack of a fiber. When a segment is full, the slots of the
+/// running frame are moved into the next segment. The slots of all other frames
+/// (and the upvalues pointing at them) never move.
+typedef struct StackSegment {
+	/// The segment below this one, `NULL` for the first segment
+	struct StackSegment* previous;
+	
+	/// The segment above this one. It is kept when the fiber leaves it, so a
+	/// fiber crossing the same boundary again does not need to allocate.
+	struct StackSegment* next;
+	
+	/// The slot in [previous] that receives the result of the frame that was
+	/// moved into this segment
+	Value* returnSlot;
+	
+	/// The index of the frame that was moved into this segment
+	int frame;
+	
+	/// The number of slots in use below this segment
+	size_t depth;
+	
+	/// The number of slots in this segment
+	size_t size;
+	
+	/// The slots of the segment
+	Value values[FLEXIBLE_ARRAY];
+} StackSegment;
+
 /// OBJECT
 /// Fiber object
 /// Used for simulating threads
@@ -335,8 +405,11 @@ struct ObjFiber { EXTENDS(Obj)
 	/// Parent
 	Obj obj;
 	
-	///Stack used for the allocation of objects on the stack
-	Value* stack; //[STACKSIZE];
+	/// The stack segment that is currently in use
+	StackSegment* segment;
+	
+	/// Start of the current stack segment
+	Value* stack;
 	
 	/// Top of the stack
 	stackTop stacktop;
@@ -355,6 +428,11 @@ struct ObjFiber { EXTENDS(Obj)
 	/// The fiber that ran this one. If this fiber is yielded, control will resume
 	/// to this one. May be `NULL`.
 	struct ObjFiber* caller;
+	
+	/// The fiber that was running when native code called this one. It is
+	/// resumed once the call returns, so it is kept alive by this one. May be
+	/// `NULL`.
+	struct ObjFiber* nativeCaller;
 
 	/// If the fiber failed because of a runtime error, this will contain the
 	/// error message. Otherwise, it will be NULL.
@@ -373,7 +451,7 @@ struct ObjFiber { EXTENDS(Obj)
 	/// to the function.
 	int foreignCallNumArgs;
 	
-	/// Size of the stack
+	/// Size of the current stack segment
 	size_t stacksize;
 	
 	/// Size of the callframe
@@ -483,7 +561,26 @@ typedef struct ObjClosure { EXTENDS(Obj)
 	Upvalue* upvalues[FLEXIBLE_ARRAY];
 } ObjClosure;
 
-DECLARE_BUFFER(Method, Method);
+/// An entry in the method table of a class
+typedef struct MethodEntry {
+	/// The symbol of the method, or -1 if the entry is empty
+	int symbol;
+	
+	/// The method bound to the symbol
+	Method method;
+} MethodEntry;
+
+/// The methods defined in a class, in a hash table keyed by method symbol
+typedef struct MethodTable {
+	/// The entries, NULL until the first method is bound
+	MethodEntry* entries;
+	
+	/// The number of entries allocated, always a power of two
+	int capacity;
+	
+	/// The number of entries in use
+	int count;
+} MethodTable;
 
 /// OBJECT
 /// Represents a growable list
@@ -499,6 +596,11 @@ typedef struct ObjList { EXTENDS(Obj)
 
 	/// Pointer to a contiguous array of [capacity] elements.
 	Value* elements;
+
+	/// The list that owns [elements] if this list is a view that shares them,
+	/// or NULL. A view has a capacity of zero and copies its elements before
+	/// it is modified.
+	struct ObjList* source;
 } ObjList;
 
 /// OBJECT
@@ -523,15 +625,16 @@ struct ObjClass { EXTENDS(Obj)
 	/// of its superclass fields.
 	int numFields;
 
-	/// The table of methods that are defined in or inherited by this class.
-	/// Methods are called by symbol, and the symbol directly maps to an index in
-	/// this table. This makes method calls fast at the expense of empty cells in
-	/// the list for methods the class doesn't support.
+	/// The table of methods that are defined in this class. Methods are called
+	/// by symbol, and the symbol is hashed to find its entry in the table.
+	/// Inherited methods are not copied into the table: a lookup that misses
+	/// continues in the superclasses.
 	///
-	/// You can think of it as a hash table that never has collisions but has a
-	/// really low load factor. Since methods are pretty small (just a type and a
-	/// pointer), this should be a worthwhile trade-off.
-	MethodBuffer methods;
+	/// Symbols are handed out in order, and the methods of a class mostly get
+	/// neighbouring symbols. Multiplying a symbol by an odd constant spreads
+	/// such a run over the table without any collisions, so the table can stay
+	/// small while lookups mostly hit the first entry they probe.
+	MethodTable methods;
 
 	/// The name of the class.
 	ObjString* name;
@@ -557,6 +660,185 @@ typedef struct ObjMethod {
 	Value caller;
 } ObjMethod;
 
+/// OBJECT
+/// A growable byte buffer used to build a string in pieces
+/// Appending is amortized O(1), the final string is only created when asked for
+typedef struct ObjStringBuilder { EXTENDS(Obj)
+	/// Parent
+	Obj obj;
+	
+	/// The bytes added so far, NULL if nothing has been allocated yet
+	char* buffer;
+	
+	/// The number of bytes in use
+	int length;
+	
+	/// The number of bytes allocated for [buffer]
+	int capacity;
+} ObjStringBuilder;
+
+/// OBJECT
+/// A double-ended queue stored in a ring buffer
+/// Adding and removing at both ends is amortized O(1), and so is indexing
+typedef struct ObjDeque { EXTENDS(Obj)
+	/// Parent
+	Obj obj;
+
+	/// The elements, NULL if nothing has been allocated yet
+	Value* elements;
+
+	/// The number of slots allocated for [elements], zero or a power of two
+	int capacity;
+
+	/// The number of elements in the deque
+	int count;
+
+	/// The slot of the first element
+	int head;
+} ObjDeque;
+
+/// OBJECT
+/// A priority queue stored as a binary heap
+/// Adding an element and removing the first one are O(log n)
+typedef struct ObjPriorityQueue { EXTENDS(Obj)
+	/// Parent
+	Obj obj;
+
+	/// The elements in heap order, the first element is in slot zero
+	Value* elements;
+
+	/// The number of slots allocated for [elements]
+	int capacity;
+
+	/// The number of elements in the queue
+	int count;
+
+	/// The function that tells whether its first argument comes before its
+	/// second one, or null to compare the elements themselves
+	Value comparator;
+
+	/// The fiber that calls the comparator or the < operator of the elements,
+	/// NULL until the first call is made
+	ObjFiber* callFiber;
+
+	/// Set while the elements are compared, the queue cannot be changed then
+	bool isComparing;
+} ObjPriorityQueue;
+
+/// The kinds of stages of a [ObjPipeline]
+typedef enum PipelineStageKind {
+	/// Replaces the value with the result of the function
+	PIPELINE_MAP,
+	/// Drops the values for which the function returns false
+	PIPELINE_WHERE,
+	/// Ends the sequence after a number of values
+	PIPELINE_TAKE,
+	/// Drops the first values
+	PIPELINE_SKIP,
+	/// Ends the sequence at the first value for which the function returns false
+	PIPELINE_TAKE_WHILE,
+	/// Pairs the value with the next value of another sequence
+	PIPELINE_ZIP,
+	/// Replaces the value with the values of the sequence the function returns
+	PIPELINE_FLAT_MAP
+} PipelineStageKind;
+
+/// A stage of a [ObjPipeline]
+typedef struct PipelineStage {
+	/// What the stage does with a value
+	PipelineStageKind kind;
+
+	/// The function, count or sequence the stage uses
+	Value arg;
+} PipelineStage;
+
+/// OBJECT
+/// A lazy sequence that runs the values of another sequence through a chain
+/// of stages. Adding a stage creates a new pipeline, a pipeline never changes.
+typedef struct ObjPipeline { EXTENDS(Obj)
+	/// Parent
+	Obj obj;
+
+	/// The sequence whose values are run through the stages
+	Value source;
+
+	/// The number of stages
+	int numStages;
+
+	/// The stages, in the order a value runs through them
+	PipelineStage stages[FLEXIBLE_ARRAY];
+} ObjPipeline;
+
+/// The state of a stage of a [ObjPipelineIterator]
+typedef struct PipelineStageState {
+	/// The sequence whose values a flatMap stage runs through the stages after
+	/// it, null when there is none
+	Value sequence;
+
+	/// The iterator of the sequence of a flatMap or zip stage
+	Value iterator;
+
+	/// The value of the sequence of a zip stage while it is paired
+	Value value;
+
+	/// The number of values a take or skip stage has seen
+	int64_t count;
+} PipelineStageState;
+
+/// OBJECT
+/// The state of an iteration over a [ObjPipeline]. Scripts can only pass it
+/// back to the pipeline, so the state can be trusted.
+typedef struct ObjPipelineIterator { EXTENDS(Obj)
+	/// Parent
+	Obj obj;
+
+	/// The pipeline that is iterated
+	ObjPipeline* pipeline;
+
+	/// The iterator of the source
+	Value sourceIterator;
+
+	/// The value that is run through the stages, and then the current value
+	Value value;
+
+	/// The receiver and the argument of a call, which is also where a native
+	/// method stores what it returns
+	Value callArgs[2];
+
+	/// The fibers that call the functions of the stages and the iterators of
+	/// the sequences, NULL until the first call that needs them
+	ObjFiber* callFiber;
+	ObjFiber* iterateFiber;
+	ObjFiber* iteratorValueFiber;
+
+	/// Set while the iterator is advanced
+	bool isBusy;
+
+	/// The state of every stage of the pipeline
+	PipelineStageState stages[FLEXIBLE_ARRAY];
+} ObjPipelineIterator;
+
+/// OBJECT
+/// A fixed size array of numbers, stored unboxed in a flat native buffer
+/// A view shares the buffer of the array it was sliced from, and keeps that
+/// array alive
+typedef struct ObjTypedArray { EXTENDS(Obj)
+	/// Parent
+	Obj obj;
+	
+	/// The type of the elements
+	CardinalArrayType type;
+	
+	/// The number of elements
+	uint32_t count;
+	
+	/// The first element, NULL if the array is empty
+	uint8_t* data;
+	
+	/// The array that owns the buffer if this is a view, NULL otherwise
+	struct ObjTypedArray* owner;
+} ObjTypedArray;
+
 /// OBJECT
 /// Indicates a range from - to
 typedef struct ObjRange { EXTENDS(Obj)
@@ -573,66 +855,62 @@ typedef struct ObjRange { EXTENDS(Obj)
 	bool isInclusive;
 } ObjRange;
 
-/// HashValue used for hashtables
-typedef struct HashValue { EXTENDS(Obj)
-	/// Parent
-	Obj obj;
-	
-	/// The value stored by the hashtable
-	Value val;
-	/// The key that was used
+/// Entry in the Map
+typedef struct MapEntry {
+	/// The entry's key, or UNDEFINED_VAL if the entry is not in use.
 	Value key;
-	/// Pointer to the next value
-	struct HashValue* next;
-} HashValue;
+
+	/// The value associated with the key. If the key is UNDEFINED_VAL, this will
+	/// be false to indicate an open available entry or true to indicate a
+	/// tombstone -- an entry that was previously in use but was then deleted.
+	Value value;
+} MapEntry;
 
 /// OBJECT
 /// A hashmap object
 /// This is used to store key-value pairs
+///
+/// The entries are stored inline in a single array, using open addressing with
+/// linear probing and tombstones. The capacity is always a power
+/// of two, so a hash is mapped to an entry with a mask.
 typedef struct ObjTable { EXTENDS(Obj)
 	/// Parent
 	Obj obj;
 	
-	/// The allocated list
+	/// The number of entries allocated
 	int capacity;
 	
-	/// the size of the hashmap
+	/// The number of key-value pairs in the table
 	int count;
 	
-	/// The hashmap
-	HashValue** hashmap;
+	/// The number of tombstones in the entries
+	int deleted;
 	
+	/// The entries, NULL until the first pair is added
+	MapEntry* entries;
 } ObjTable;
 
-/// Entry in the Map
-typedef struct MapEntry {
-	/// The entry's key, or UNDEFINED_VAL if the entry is not in use.
-	Value key;
-
-	/// The value associated with the key. If the key is UNDEFINED_VAL, this will
-	/// be false to indicate an open available entry or true to indicate a
-	/// tombstone -- an entry that was previously in use but was then deleted.
-	Value value;
-} MapEntry;
-
 /// OBJECT
 /// A hash table mapping keys to values.
 ///
-/// We use something very simple: open addressing with linear probing. The hash
-/// table is an array of entries. Each entry is a key-value pair. If the key is
-/// the special UNDEFINED_VAL, it indicates no value is currently in that slot.
-/// Otherwise, it's a valid key, and the value is the value associated with it.
+/// The hash table is an array of entries. Each entry is a key-value pair. If the
+/// key is the special UNDEFINED_VAL, it indicates no value is currently in that
+/// slot. Otherwise, it's a valid key, and the value is the value associated
+/// with it.
 ///
-/// When entries are added, the array is dynamically scaled by GROW_FACTOR to
-/// keep the number of filled slots under MAP_LOAD_PERCENT. Likewise, if the map
-/// gets empty enough, it will be resized to a smaller array. When this happens,
-/// all existing entries are rehashed and re-added to the new array.
+/// Next to every entry the map keeps the full hash of its key and a control
+/// byte. The control byte of a full entry holds the low seven bits of the hash,
+/// otherwise it marks the entry as empty or deleted. The entries are probed in
+/// groups of 16: the control bytes of a group are compared with one SSE2
+/// instruction where available, and only keys whose control byte and cached
+/// hash match are compared with the key being looked up. A probe stops at the
+/// first group that has an empty entry.
 ///
-/// When an entry is removed, its slot is replaced with a "tombstone". This is an
-/// entry whose key is UNDEFINED_VAL and whose value is TRUE_VAL. When probing
-/// for a key, we will continue past tombstones, because the desired key may be
-/// found after them if the key that was removed was part of a prior collision.
-/// When the array gets resized, all tombstones are discarded.
+/// When entries are added, the array is dynamically scaled by GROW_FACTOR to
+/// keep the number of filled and deleted slots under MAP_LOAD_PERCENT.
+/// Likewise, if the map gets empty enough, it will be resized to a smaller
+/// array. Resizing places the entries using their cached hashes, so keys are
+/// never hashed again, and discards all deleted entries.
 typedef struct ObjMap { EXTENDS(Obj)
 	/// Parent
 	Obj obj;
@@ -643,8 +921,18 @@ typedef struct ObjMap { EXTENDS(Obj)
 	/// The number of entries in the map.
 	uint32_t count;
 
-	/// Pointer to a contiguous array of [capacity] entries.
+	/// The number of deleted entries.
+	uint32_t deleted;
+
+	/// Pointer to a contiguous array of [capacity] entries. The hashes and
+	/// control bytes live in the same allocation, right after the entries.
 	MapEntry* entries;
+
+	/// The hash of the key in every full entry.
+	uint32_t* hashes;
+
+	/// The control byte of every entry.
+	uint8_t* control;
 } ObjMap;
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -690,6 +978,27 @@ typedef struct ObjMap { EXTENDS(Obj)
 // Value -> ObjMethod*.
 #define AS_METHOD(value) ((ObjMethod*)AS_OBJ(value))
 
+// Value -> ObjStringBuilder*.
+#define AS_STRINGBUILDER(value) ((ObjStringBuilder*)AS_OBJ(value))
+
+// Value -> ObjTypedArray*.
+#define AS_TYPEDARRAY(value) ((ObjTypedArray*)AS_OBJ(value))
+
+// Value -> ObjDeque*.
+#define AS_DEQUE(value) ((ObjDeque*)AS_OBJ(value))
+
+// Value -> ObjMap* of a set.
+#define AS_SET(value) ((ObjMap*)AS_OBJ(value))
+
+// Value -> ObjPriorityQueue*.
+#define AS_PRIORITYQUEUE(value) ((ObjPriorityQueue*)AS_OBJ(value))
+
+// Value -> ObjPipeline*.
+#define AS_PIPELINE(value) ((ObjPipeline*)AS_OBJ(value))
+
+// Value -> ObjPipelineIterator*.
+#define AS_PIPELINE_ITERATOR(value) ((ObjPipelineIterator*)AS_OBJ(value))
+
 // Convert [boolean] to a boolean [Value].
 #define BOOL_VAL(boolean) (boolean ? TRUE_VAL : FALSE_VAL)
 
@@ -749,9 +1058,20 @@ typedef struct ObjMap { EXTENDS(Obj)
 // only actually use 48 bits for addresses, so we've got plenty. We just stuff
 // the address right into the mantissa.
 //
-// Ta-da, double precision numbers, pointers, and a bunch of singleton values,
-// all stuffed into a single 64-bit sequence. Even better, we don't have to
-// do any masking or work to extract number values: they are unmodified. This
+// Singletons leave the mantissa bit below the quiet bit set, so a NaN with a
+// cleared sign bit and a cleared second mantissa bit is still free. Small
+// integers use it, with the third mantissa bit set. The remaining 49 bits hold
+// the integer in two's complement:
+//
+// Integer bit--v
+// 0[NaN       ]101[49 bit integer                                ]
+//
+// The NaN that arithmetic produces has none of the lower mantissa bits set, so
+// it can't be mistaken for an integer.
+//
+// Ta-da, double precision numbers, integers, pointers, and a bunch of singleton
+// values, all stuffed into a single 64-bit sequence. Even better, we don't have
+// to do any masking or work to extract number values: they are unmodified. This
 // means math on numbers is fast.
 #if CARDINAL_NAN_TAGGING
 // A mask that selects the sign bit.
@@ -763,8 +1083,20 @@ typedef struct ObjMap { EXTENDS(Obj)
 	// The bits that must be set to indicate a quiet NaN.
 	#define QNAN_NUM ((uint64_t)0x7ffc000000000000)
 
-	// If the NaN bits are set, it's not a number.
-	#define IS_NUM(value) (((value) & QNAN) != QNAN)
+	// The mantissa bit that is set for small integers.
+	#define INT_BIT ((uint64_t)1 << 49)
+
+	// The bits that identify a small integer.
+	#define MASK_INT (SIGN_BIT | QNAN_NUM | INT_BIT)
+
+	// The bits that hold the value of a small integer.
+	#define MASK_INT_PAYLOAD (INT_BIT - 1)
+
+	// A small integer is a NaN with a cleared sign bit and a set integer bit.
+	#define IS_INT(value) (((value) & MASK_INT) == (QNAN | INT_BIT))
+
+	// If the NaN bits are set, it's not a number, unless it's a small integer.
+	#define IS_NUM(value) (((value) & QNAN) != QNAN || IS_INT(value))
 
 	// Singleton values are NaN with the sign bit cleared. (This includes the
 	// normal value of the actual NaN value used in numeric arithmetic.)
@@ -839,7 +1171,10 @@ typedef struct ObjMap { EXTENDS(Obj)
 	#define IS_NULL(value) ((value).type == VAL_NULL)
 
 	// Determines if [value] is a number
-	#define IS_NUM(value) ((value).type == VAL_NUM)
+	#define IS_NUM(value) ((value).type == VAL_NUM || (value).type == VAL_INT)
+
+	// Determines if [value] is a small integer
+	#define IS_INT(value) ((value).type == VAL_INT)
 
 	// Determines if [value] is undefined
 	#define IS_UNDEFINED(value) ((value).type == VAL_UNDEFINED)
@@ -894,6 +1229,27 @@ typedef struct ObjMap { EXTENDS(Obj)
 // Returns true if [value] is a method object.
 #define IS_METHOD(value) (cardinalIsObjType(value, OBJ_METHOD))
 
+// Returns true if [value] is a string builder object.
+#define IS_STRINGBUILDER(value) (cardinalIsObjType(value, OBJ_STRINGBUILDER))
+
+// Returns true if [value] is a typed array object.
+#define IS_TYPEDARRAY(value) (cardinalIsObjType(value, OBJ_TYPEDARRAY))
+
+// Returns true if [value] is a deque.
+#define IS_DEQUE(value) (cardinalIsObjType(value, OBJ_DEQUE))
+
+// Returns true if [value] is a set.
+#define IS_SET(value) (cardinalIsObjType(value, OBJ_SET))
+
+// Returns true if [value] is a priority queue.
+#define IS_PRIORITYQUEUE(value) (cardinalIsObjType(value, OBJ_PRIORITYQUEUE))
+
+// Returns true if [value] is a sequence pipeline.
+#define IS_PIPELINE(value) (cardinalIsObjType(value, OBJ_PIPELINE))
+
+// Returns true if [value] is the iterator of a sequence pipeline.
+#define IS_PIPELINE_ITERATOR(value) (cardinalIsObjType(value, OBJ_PIPELINE_ITERATOR))
+
 // Returns true if [value] is a list object.
 #define IS_LIST(value) (cardinalIsObjType(value, OBJ_LIST))
 
@@ -906,6 +1262,24 @@ typedef struct ObjMap { EXTENDS(Obj)
 // Value -> double.
 #define AS_NUM(value) (cardinalValueToNum(value))
 
+// int64_t -> Value. Integers outside the small integer range become doubles.
+#define INT_VAL(integer) (cardinalIntToValue(integer))
+
+// Value -> int64_t. The value must be a small integer.
+#define AS_INT(value) (cardinalValueToInt(value))
+
+// The smallest and largest integers that are stored as small integers. Every
+// integral number in this range is stored as a small integer, and every other
+// number as a double, so equal numbers always have the same representation.
+//
+// The range is [-2^48, 2^48), because a small integer has to fit in the
+// payload of a NaN. Larger integers up to 2^53 are still exact, but they are
+// doubles and take the slower double paths. Beyond 2^53 a double cannot hold
+// every integer, so 64-bit ids and hashes lose their low bits and have to be
+// kept as strings or split into smaller numbers.
+#define SMALL_INT_MIN (-((int64_t)1 << 48))
+#define SMALL_INT_MAX (((int64_t)1 << 48) - 1)
+
 /// A union to let us reinterpret a double as raw bits and back.
 typedef union {
 	/// 64 bit int
@@ -966,6 +1340,23 @@ void cardinalBindMethod(CardinalVM* vm, ObjClass* classObj, int symbol, Method m
 // Get the correct method to call
 Method* cardinalGetMethod(CardinalVM* vm, ObjClass* classObj, int symbol, int& adjustment);
 
+// Returns the method bound to [symbol] in [classObj] itself, or NULL if the
+// class does not define it.
+static inline Method* cardinalFindMethod(ObjClass* classObj, int symbol) {
+	MethodTable* table = &classObj->methods;
+	if (table->count == 0) return NULL;
+	
+	uint32_t mask = (uint32_t) table->capacity - 1;
+	uint32_t index = ((uint32_t) symbol * 2654435769u) & mask;
+	
+	// The table is never full, so the probe always reaches an empty entry.
+	while (table->entries[index].symbol != symbol) {
+		if (table->entries[index].symbol == -1) return NULL;
+		index = (index + 1) & mask;
+	}
+	return &table->entries[index].method;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////
 //// FUNCTIONS: METHOD	
 ///////////////////////////////////////////////////////////////////////////////////
@@ -1005,6 +1396,19 @@ ObjFiber* cardinalNewFiber(CardinalVM* vm, Obj* fn);
 // Resets [fiber] back to an initial state where it is ready to invoke [fn].
 void cardinalResetFiber(ObjFiber* fiber, Obj* fn);
 
+// Empties the stack of [fiber] and moves it back to its first segment.
+void cardinalClearFiberStack(ObjFiber* fiber);
+
+// Creates a new stack segment of [size] slots on top of [previous], which may
+// be `NULL`.
+StackSegment* cardinalNewStackSegment(CardinalVM* vm, StackSegment* previous, size_t size);
+
+// Frees [segment] and all segments above it.
+void cardinalFreeStackSegments(CardinalVM* vm, StackSegment* segment);
+
+// Frees the fibers that were kept in the fiber pool of [vm].
+void cardinalFreeFiberPool(CardinalVM* vm);
+
 ///////////////////////////////////////////////////////////////////////////////////
 //// FUNCTIONS: FUNCTION	
 ///////////////////////////////////////////////////////////////////////////////////
@@ -1025,23 +1429,33 @@ ObjFn* cardinalNewFunction(CardinalVM* vm, ObjModule* module,
 //// FUNCTIONS: TABLE	
 ///////////////////////////////////////////////////////////////////////////////////
 
-// Creates a new list with [numElements] elements (which are left
-// uninitialized.)
+// Creates a new table with room for [numElements] pairs before it has to grow.
 ObjTable* cardinalNewTable(CardinalVM* vm, int numElements);
 
-// Adds [value] to [list], reallocating and growing its storage if needed.
-void cardinalTableAdd(CardinalVM* vm, ObjTable* list, Value value, Value key);
+// Associates [key] with [value] in [list], growing its storage if needed.
+void cardinalTableAdd(CardinalVM* vm, ObjTable* list, Value key, Value value);
 
-// Find [key] in [list], shifting down the other elements.
+// Find the value of [key] in [list], or null if it is not in the table.
 Value cardinalTableFind(CardinalVM* vm, ObjTable* list, Value key);
 
-// Removes and returns the item at [index] from [list].
-Value cardinalTableRemove(CardinalVM* vm, ObjTable* list, Value index);
+// Returns whether [key] is in [list].
+bool cardinalTableContains(ObjTable* list, Value key);
+
+// Removes [key] from [list] and returns its value, or null if it was not there.
+Value cardinalTableRemove(CardinalVM* vm, ObjTable* list, Value key);
+
+// Removes all pairs from [list] and frees its entries.
+void cardinalTableClear(CardinalVM* vm, ObjTable* list);
 
 // Print an table to the console
 void cardinalTablePrint(CardinalVM* vm, ObjTable* list);
 
-HashValue* cardinalGetTableIndex(ObjTable* table, int ind);
+// Returns the index of the first entry in use at or after [index], or -1 if
+// there is none.
+int cardinalTableNext(ObjTable* table, int index);
+
+// Returns the [ind]-th pair of [table], or NULL if it has fewer pairs.
+MapEntry* cardinalGetTableIndex(ObjTable* table, int ind);
 
 ///////////////////////////////////////////////////////////////////////////////////
 //// FUNCTIONS: INSTANCE	
@@ -1077,6 +1491,17 @@ Value cardinalMapRemoveKey(CardinalVM* vm, ObjMap* map, Value key);
 
 Value cardinalMapGetInd(ObjMap* map, uint32_t ind);
 
+///////////////////////////////////////////////////////////////////////////////////
+//// FUNCTIONS: SET	
+///////////////////////////////////////////////////////////////////////////////////
+
+// Creates a new empty set. A set is a map with the elements as keys and true
+// as every value, so the map functions work on it as well.
+ObjMap* cardinalNewSet(CardinalVM* vm);
+
+// Adds [value] to [set]. Returns true if it was not in the set yet.
+bool cardinalSetAdd(CardinalVM* vm, ObjMap* set, Value value);
+
 ///////////////////////////////////////////////////////////////////////////////////
 //// FUNCTIONS: MODULE	
 ///////////////////////////////////////////////////////////////////////////////////
@@ -1101,6 +1526,17 @@ ObjList* cardinalNewList(CardinalVM* vm, int numElements);
 // Adds [value] to [list], reallocating and growing its storage if needed.
 void cardinalListAdd(CardinalVM* vm, ObjList* list, Value value);
 
+// Returns the number of bytes adding one element to [list] allocates.
+static inline size_t cardinalListGrowth(ObjList* list) {
+	// A view gets its own copy of the elements first.
+	if (list->source != NULL) return (size_t)(list->count + 1) * sizeof(Value);
+	if (list->count < list->capacity) return 0;
+
+	int capacity = list->capacity * LIST_GROW_FACTOR;
+	if (capacity < LIST_MIN_CAPACITY) capacity = LIST_MIN_CAPACITY;
+	return (size_t)(capacity - list->capacity) * sizeof(Value);
+}
+
 // Inserts [value] in [list] at [index], shifting down the other elements.
 void cardinalListInsert(CardinalVM* vm, ObjList* list, Value value, int index);
 
@@ -1109,6 +1545,14 @@ Value cardinalListRemoveAt(CardinalVM* vm, ObjList* list, int index);
 
 void cardinalListRemoveLast(CardinalVM* vm, ObjList* list);
 
+// Creates a view of the [count] elements of [list] starting at [start]. The
+// view shares the elements with [list] until either of them is modified.
+ObjList* cardinalNewListView(CardinalVM* vm, ObjList* list, int start, int count);
+
+// Gives [list] its own copy of its elements if it shares them with other
+// lists. Must be called before the elements are written to directly.
+void cardinalListUnshare(CardinalVM* vm, ObjList* list);
+
 ///////////////////////////////////////////////////////////////////////////////////
 //// FUNCTIONS: RANGE	
 ///////////////////////////////////////////////////////////////////////////////////
@@ -1148,14 +1592,146 @@ Value cardinalNewString(CardinalVM* vm, const char* text, size_t length);
 // The caller is expected to fully initialize the buffer after calling.
 Value cardinalNewUninitializedString(CardinalVM* vm, size_t length);
 
-// Search for the first occurence of [needle] within [haystack] and returns its
-// zero-based offset. Returns `UINT32_MAX` if [haystack] does not contain
-// [needle].
-uint32_t cardinalStringFind(CardinalVM* vm, ObjString* haystack, ObjString* needle);
+// Returns the interned string object containing [length] bytes of [text],
+// creating and interning a new string if there is none yet.
+Value cardinalNewInternedString(CardinalVM* vm, const char* text, size_t length);
+
+// Search for the first occurence of [needle] within [haystack] at or after byte
+// [start] and returns its zero-based offset. Returns `UINT32_MAX` if
+// [haystack] does not contain [needle] there.
+uint32_t cardinalStringFind(CardinalVM* vm, ObjString* haystack, ObjString* needle, uint32_t start);
 
 // Hash the string [string]
 void hashString(ObjString* string);
 
+// Checks whether [string] only contains ASCII characters and stores that in its
+// encoding.
+void cardinalStringCheckEncoding(ObjString* string);
+
+// Returns true if [string] only contains ASCII characters.
+static inline bool cardinalStringIsAscii(ObjString* string) {
+	if (string->encoding == STRING_UNKNOWN) cardinalStringCheckEncoding(string);
+	return string->encoding == STRING_ASCII;
+}
+
+// Returns the number of code points in [string].
+int cardinalStringCodePointCount(ObjString* string);
+
+// Returns the byte offset of the code point at [index] in [string], or the
+// length of [string] if [index] is its number of code points. [index] must not
+// be negative.
+int cardinalStringCodePointOffset(CardinalVM* vm, ObjString* string, int index);
+
+// Returns the hash code of [string], calculating it first if needed.
+static inline uint32_t cardinalStringHash(ObjString* string) {
+	if (!string->hashed) hashString(string);
+	return string->hash;
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+//// FUNCTIONS: STRINGBUILDER
+///////////////////////////////////////////////////////////////////////////////////
+
+// Creates a new empty string builder.
+ObjStringBuilder* cardinalNewStringBuilder(CardinalVM* vm);
+
+// Returns the capacity [builder] needs to hold [length] more bytes.
+static inline int cardinalStringBuilderCapacity(ObjStringBuilder* builder, int length) {
+	if (builder->length + length <= builder->capacity) return builder->capacity;
+
+	int capacity = builder->capacity * STRINGBUILDER_GROW_FACTOR;
+	if (capacity < STRINGBUILDER_MIN_CAPACITY) capacity = STRINGBUILDER_MIN_CAPACITY;
+	while (capacity < builder->length + length) capacity *= STRINGBUILDER_GROW_FACTOR;
+	return capacity;
+}
+
+// Appends [length] bytes of [text] to [builder], growing its buffer if needed.
+void cardinalStringBuilderAdd(CardinalVM* vm, ObjStringBuilder* builder, const char* text, int length);
+
+// Creates a new string containing the bytes added to [builder].
+Value cardinalStringBuilderToString(CardinalVM* vm, ObjStringBuilder* builder);
+
+///////////////////////////////////////////////////////////////////////////////////
+//// FUNCTIONS: TYPEDARRAY
+///////////////////////////////////////////////////////////////////////////////////
+
+// Creates a new typed array of [count] elements of [type], all set to zero.
+ObjTypedArray* cardinalNewTypedArray(CardinalVM* vm, CardinalArrayType type, uint32_t count);
+
+// Creates a view of [count] elements of [array], starting at [start]. The view
+// shares the buffer of [array].
+ObjTypedArray* cardinalNewTypedArrayView(CardinalVM* vm, ObjTypedArray* array, uint32_t start, uint32_t count);
+
+// Returns the size in bytes of a single element of [type].
+size_t cardinalTypedArrayElementSize(CardinalArrayType type);
+
+// Returns the element of [array] at [index].
+Value cardinalTypedArrayGet(ObjTypedArray* array, uint32_t index);
+
+// Stores [value] at [index] in [array]. Integer arrays truncate the value and
+// wrap it around, like a cast from an unsigned integer would.
+void cardinalTypedArraySet(ObjTypedArray* array, uint32_t index, double value);
+
+// Stores [value] in every element of [array].
+void cardinalTypedArrayFill(ObjTypedArray* array, double value);
+
+// Copies the first [count] elements of [source] to [array], converting them
+// if the types differ. The arrays may overlap.
+void cardinalTypedArrayCopy(ObjTypedArray* array, ObjTypedArray* source, uint32_t count);
+
+///////////////////////////////////////////////////////////////////////////////////
+//// FUNCTIONS: DEQUE
+///////////////////////////////////////////////////////////////////////////////////
+
+// Creates a new empty deque.
+ObjDeque* cardinalNewDeque(CardinalVM* vm);
+
+// Adds [value] after the last element of [deque], growing it if needed.
+void cardinalDequePushBack(CardinalVM* vm, ObjDeque* deque, Value value);
+
+// Adds [value] before the first element of [deque], growing it if needed.
+void cardinalDequePushFront(CardinalVM* vm, ObjDeque* deque, Value value);
+
+// Removes and returns the last element of [deque], which must not be empty.
+Value cardinalDequePopBack(ObjDeque* deque);
+
+// Removes and returns the first element of [deque], which must not be empty.
+Value cardinalDequePopFront(ObjDeque* deque);
+
+// Removes all elements from [deque] and frees its storage.
+void cardinalDequeClear(CardinalVM* vm, ObjDeque* deque);
+
+// Returns the slot that holds element [index] of [deque].
+static inline Value* cardinalDequeAt(ObjDeque* deque, int index) {
+	return &deque->elements[(deque->head + index) & (deque->capacity - 1)];
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+//// FUNCTIONS: PRIORITY QUEUE
+///////////////////////////////////////////////////////////////////////////////////
+
+// Creates a new empty priority queue that orders its elements with
+// [comparator], or by comparing them if it is null.
+ObjPriorityQueue* cardinalNewPriorityQueue(CardinalVM* vm, Value comparator);
+
+// Adds [value] after the last element of the heap of [queue], growing it if
+// needed. The caller has to move it up to its place in the heap.
+void cardinalPriorityQueueAppend(CardinalVM* vm, ObjPriorityQueue* queue, Value value);
+
+// Removes all elements from [queue] and frees its storage.
+void cardinalPriorityQueueClear(CardinalVM* vm, ObjPriorityQueue* queue);
+
+///////////////////////////////////////////////////////////////////////////////////
+//// FUNCTIONS: PIPELINE
+///////////////////////////////////////////////////////////////////////////////////
+
+// Creates a new pipeline over [source] with room for [numStages] stages. The
+// caller has to fill in the stages.
+ObjPipeline* cardinalNewPipeline(CardinalVM* vm, Value source, int numStages);
+
+// Creates a new iterator over [pipeline] that has not started yet.
+ObjPipelineIterator* cardinalNewPipelineIterator(CardinalVM* vm, ObjPipeline* pipeline);
+
 ///////////////////////////////////////////////////////////////////////////////////
 //// FUNCTIONS: UPVALUE	
 ///////////////////////////////////////////////////////////////////////////////////
@@ -1210,6 +1786,7 @@ static inline bool cardinalValuesSame(Value a, Value b) {
 #else
 	if (a.type != b.type) return false;
 	if (a.type == VAL_NUM) return compareFloat(a.value.num, b.value.num); //a.num == b.num;
+	if (a.type == VAL_INT) return a.value.integer == b.value.integer;
 	return a.value.obj == b.value.obj;
 #endif
 }
@@ -1261,8 +1838,32 @@ static inline Value cardinalPointerToValue(void* ptr) {
 #endif
 }
 
+// Interprets [value], which must be a small integer, as an [int64_t].
+static inline int64_t cardinalValueToInt(Value value) {
+#if CARDINAL_NAN_TAGGING
+	// Move the sign of the payload into the sign bit and back to sign extend it.
+	return ((int64_t)(value << 15)) >> 15;
+#else
+	return value.value.integer;
+#endif
+}
+
+// Converts [integer], which must be in the small integer range, to a [Value].
+static inline Value cardinalSmallIntToValue(int64_t integer) {
+#if CARDINAL_NAN_TAGGING
+	return (Value)(QNAN | INT_BIT | ((uint64_t)integer & MASK_INT_PAYLOAD));
+#else
+	Value value;
+	value.type = VAL_INT;
+	value.value.integer = integer;
+	return value;
+#endif
+}
+
 // Interprets [value] as a [double].
 static inline double cardinalValueToNum(Value value) {
+	if (IS_INT(value)) return (double) cardinalValueToInt(value);
+	
 #if CARDINAL_NAN_TAGGING
 	DoubleBits data;
 	data.bits64 = value;
@@ -1274,6 +1875,15 @@ static inline double cardinalValueToNum(Value value) {
 
 // Converts [num] to a [Value].
 static inline Value cardinalNumToValue(double n) {
+	// Integral numbers in the small integer range are small integers. Negative
+	// zero has to stay a double to keep its sign.
+	if (n >= SMALL_INT_MIN && n <= SMALL_INT_MAX) {
+		int64_t integer = (int64_t) n;
+		if ((double) integer == n && (integer != 0 || !signbit(n))) {
+			return cardinalSmallIntToValue(integer);
+		}
+	}
+	
 #if CARDINAL_NAN_TAGGING
 	DoubleBits data;
 	data.num = n;
@@ -1283,16 +1893,34 @@ static inline Value cardinalNumToValue(double n) {
 #endif
 }
 
+// Converts [integer] to a [Value].
+static inline Value cardinalIntToValue(int64_t integer) {
+	if (integer >= SMALL_INT_MIN && integer <= SMALL_INT_MAX) {
+		return cardinalSmallIntToValue(integer);
+	}
+	return cardinalNumToValue((double) integer);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////
 //// FUNCTIONS: HOST OBJECTS
 ///////////////////////////////////////////////////////////////////////////////////
 
+// Returns the value of the handle [key], or `NULL_VAL` if it was released.
 Value cardinalGetHostObject(CardinalVM* vm, CardinalValue* key);
 
 void cardinalSetHostObject(CardinalVM* vm, Value val, CardinalValue* key);
 
+// Stores [val] in the host object table and returns its handle, or `NULL` if
+// the table already holds as many slots as a handle can address.
 CardinalValue* cardinalCreateHostObject(CardinalVM* vm, Value val);
 
 void cardinalRemoveHostObject(CardinalVM* vm, CardinalValue* key);
 
+// Returns the handle of the slot at [index] in the host object table, or `NULL`
+// if that slot is not in use.
+CardinalValue* cardinalHostObjectAt(CardinalVM* vm, int index);
+
+// Marks all values in the host object table.
+void cardinalMarkHostObjects(CardinalVM* vm);
+
 #endif
@@ -124,6 +124,16 @@ static void loadCallBacks(CardinalConfiguration* configuration, CardinalVM* vm)
 		vm->callDepth = configuration->callDepth;
 	}
 	
+	vm->fiberStackSize = FIBER_STACKSIZE;
+	vm->fiberCallFrames = CALLFRAMESIZE;
+	vm->nativeCallDepth = 0;
+	if (configuration->fiberStackSize != 0) {
+		vm->fiberStackSize = configuration->fiberStackSize;
+	}
+	if (configuration->fiberCallFrames != 0) {
+		vm->fiberCallFrames = configuration->fiberCallFrames;
+	}
+	
 	vm->loadModule = moduleLoader;
 	vm->printFunction = print;
 	vm->callBackFunction = callback; 
@@ -183,6 +193,9 @@ void cardinalFreeVM(CardinalVM* vm) {
 		obj = next;
 	}
 	
+	cardinalFreeFiberPool(vm);
+	DEALLOCATE(vm, vm->strings.entries);
+	DEALLOCATE(vm, vm->hostObjects.slots);
 	cardinalSymbolTableClear(vm, &vm->methodNames);
 	cardinalFreeDebugger(vm, vm->debugger);
 	
@@ -250,6 +263,15 @@ static void initMetaClasses(CardinalVM* vm) {
 	vm->metatable.numClass = NULL;
 	vm->metatable.objectClass = NULL;
 	vm->metatable.tableClass = NULL;
+	vm->metatable.stringBuilderClass = NULL;
+	vm->metatable.typedArrayClass = NULL;
+	vm->metatable.float64ArrayClass = NULL;
+	vm->metatable.int32ArrayClass = NULL;
+	vm->metatable.byteArrayClass = NULL;
+	vm->metatable.dequeClass = NULL;
+	vm->metatable.setClass = NULL;
+	vm->metatable.priorityQueueClass = NULL;
+	vm->metatable.pipelineClass = NULL;
 }
 
 static void initGarbageCollector(CardinalVM* vm, CardinalConfiguration* configuration) {
@@ -265,6 +287,10 @@ static void initGarbageCollector(CardinalVM* vm, CardinalConfiguration* configur
 		vm->garbageCollector.minNextGC = configuration->minHeapSize;
 	}
 
+	vm->garbageCollector.maxBytes = configuration->maxHeapSize;
+	vm->garbageCollector.peakBytesAllocated = 0;
+	vm->garbageCollector.outOfMemory = false;
+
 	vm->garbageCollector.heapScalePercent = 150;
 	if (configuration->heapGrowthPercent != 0) {
 		// +100 here because the configuration gives us the *additional* size of
@@ -289,8 +315,16 @@ static void initGarbageCollector(CardinalVM* vm, CardinalConfiguration* configur
 	vm->fiber = NULL;
 	vm->rootDirectory = NULL;
 	vm->modules = NULL;
-	vm->hostObjects.freeNums = NULL;
-	vm->hostObjects.hostObjects = NULL;
+	vm->hostObjects.slots = NULL;
+	vm->hostObjects.capacity = 0;
+	vm->hostObjects.max = 0;
+	vm->hostObjects.count = 0;
+	vm->hostObjects.firstFree = -1;
+	vm->fiberPool.first = NULL;
+	vm->fiberPool.count = 0;
+	vm->strings.entries = NULL;
+	vm->strings.capacity = 0;
+	vm->strings.count = 0;
 	initMetaClasses(vm);
 	
 	vm->garbageCollector.isWorking = false;
@@ -317,8 +351,10 @@ static Upvalue* captureUpvalue(CardinalVM* vm, ObjFiber* fiber, Value* local) {
 	Upvalue* upvalue = fiber->openUpvalues;
 
 	// Walk towards the bottom of the stack until we find a previously existing
-	// upvalue or pass where it should be.
-	while (upvalue != NULL && upvalue->value > local) {
+	// upvalue or pass where it should be. Upvalues in older stack segments are
+	// always below [local].
+	Value* segmentEnd = fiber->stack + fiber->stacksize;
+	while (upvalue != NULL && upvalue->value > local && upvalue->value < segmentEnd) {
 		prevUpvalue = upvalue;
 		upvalue = upvalue->next;
 	}
@@ -427,6 +463,9 @@ static ObjFiber* runtimeError(CardinalVM* vm, ObjFiber* fiber, ObjString* error)
 	// If the caller ran this fiber using "try", give it the error.
 	if (fiber->callerIsTrying) {
 		ObjFiber* caller = fiber->caller;
+		
+		// Native code that runs a call fiber takes the error from the fiber.
+		if (caller == NULL) return NULL;
 
 		// Make the caller's try method return the error message.
 		*(caller->stacktop - 1) = OBJ_VAL(fiber->error);
@@ -438,6 +477,27 @@ static ObjFiber* runtimeError(CardinalVM* vm, ObjFiber* fiber, ObjString* error)
 	return NULL;
 }
 
+// Fails [fiber] because the heap limit of the VM was exceeded.
+//
+// Returns the fiber that should receive the error or `NULL` if no fiber
+// caught it.
+static ObjFiber* outOfMemoryError(CardinalVM* vm, ObjFiber* fiber) {
+	ObjString* error = AS_STRING(cardinalNewString(vm, "Out of memory", 13));
+	ObjFiber* failed = fiber;
+	fiber = runtimeError(vm, failed, error);
+	
+	// The failed fiber can never be resumed, so drop everything on its stack.
+	// This lets the next collection reclaim the memory that it was holding.
+	while (failed->openUpvalues != NULL) closeUpvalue(failed);
+	cardinalClearFiberStack(failed);
+	failed->numFrames = 0;
+	
+	// Creating the error may exceed the limit again, but that should not fail
+	// the fiber that receives it.
+	vm->garbageCollector.outOfMemory = false;
+	return fiber;
+}
+
 static ObjFiber* runtimeThrow(CardinalVM* vm, ObjFiber* fiber, Value error) {
 	if (IS_STRING(error)) return runtimeError(vm, fiber, AS_STRING(error));
 	
@@ -450,6 +510,9 @@ static ObjFiber* runtimeThrow(CardinalVM* vm, ObjFiber* fiber, Value error) {
 	// If the caller ran this fiber using "try", give it the error.
 	if (fiber->callerIsTrying) {
 		ObjFiber* caller = fiber->caller;
+		
+		// Native code that runs a call fiber takes the error from the fiber.
+		if (caller == NULL) return NULL;
 
 		// Make the caller's try method return the error message.
 		*(caller->stacktop - 1) = OBJ_VAL(fiber->error);
@@ -505,7 +568,16 @@ static ObjString* validateSuperclass(CardinalVM* vm, ObjString* name,
 	        superclass == vm->metatable.listClass ||
 	        superclass == vm->metatable.mapClass ||
 	        superclass == vm->metatable.rangeClass ||
-	        superclass == vm->metatable.stringClass) {
+	        superclass == vm->metatable.stringClass ||
+	        superclass == vm->metatable.stringBuilderClass ||
+	        superclass == vm->metatable.typedArrayClass ||
+	        superclass == vm->metatable.float64ArrayClass ||
+	        superclass == vm->metatable.int32ArrayClass ||
+	        superclass == vm->metatable.byteArrayClass ||
+	        superclass == vm->metatable.dequeClass ||
+	        superclass == vm->metatable.setClass ||
+	        superclass == vm->metatable.priorityQueueClass ||
+	        superclass == vm->metatable.pipelineClass) {
 		char message[70 + MAX_VARIABLE_NAME];
 		sprintf(message, "%s cannot inherit from %s.",
 		        name->value, superclass->name->value);
@@ -723,49 +795,90 @@ static bool importVariable(CardinalVM* vm, Value moduleName, Value variableName,
 ///////////////////////////////////////////////////////////////////////////////////
 
 bool cardinalFiberStack(CardinalVM* vm, ObjFiber* fiber, Value** stackstart) {
-	Value* oldStackBegin = fiber->stack;
-	int stacktop = (fiber->stacktop - fiber->stack);
-	int newSize = 0;
-	// Stack is too short, increase the length
-	if (stacktop + 2 > (int) fiber->stacksize) {
-		newSize = fiber->stacksize * STACKSIZE_GROW_FACTOR;
+	// There is still room in the current segment
+	if (fiber->stacktop + 2 <= fiber->stack + fiber->stacksize) return false;
+	
+	StackSegment* segment = fiber->segment;
+	CallFrame* frame = &fiber->frames[fiber->numFrames - 1];
+	
+	// Only the window of the running frame is moved, so the new segment must be
+	// able to hold it.
+	Value* window = frame->top;
+	size_t count = fiber->stacktop - window;
+	size_t depth = segment->depth + (window - segment->values);
+	
+	size_t size = (size_t) (segment->size * STACKSIZE_GROW_FACTOR);
+	if (size > STACKSIZE) size = STACKSIZE;
+	while (size < count + 2) size = (size_t) (size * STACKSIZE_GROW_FACTOR);
+	
+	if (depth + size > (size_t) vm->stackMax)
+		return true;
+	
+	StackSegment* target;
+	if (window == segment->values) {
+		// The frame already starts at the bottom of the segment, so grow the
+		// segment itself. Frames that start at the same slot move along.
+		target = (StackSegment*) cardinalReallocate(vm, segment,
+			sizeof(StackSegment) + sizeof(Value) * segment->size,
+			sizeof(StackSegment) + sizeof(Value) * size);
+		target->size = size;
+		if (target->previous != NULL) target->previous->next = target;
+		if (target->next != NULL) target->next->previous = target;
 		
-		if (newSize > vm->stackMax)
-			return true;
-	}
-	// Stack is too large, decrease the length
-	else if (fiber->stacksize > STACKSIZE && stacktop < (int) fiber->stacksize / STACKSIZE_GROW_FACTOR) {
-		newSize = fiber->stacksize / STACKSIZE_GROW_FACTOR;
+		for (int i = fiber->numFrames - 1; i >= 0 && fiber->frames[i].top == window; i--) {
+			fiber->frames[i].top = target->values;
+		}
 	}
-	else { 
-		return false; 
+	else {
+		// Reuse the segment above when it is large enough.
+		target = segment->next;
+		if (target != NULL && target->size < size) {
+			cardinalFreeStackSegments(vm, target);
+			target = NULL;
+		}
+		if (target == NULL) target = cardinalNewStackSegment(vm, segment, size);
+		
+		target->returnSlot = window;
+		target->frame = fiber->numFrames - 1;
+		target->depth = depth;
+		memcpy(target->values, window, count * sizeof(Value));
+		frame->top = target->values;
 	}
 	
-	fiber->stack = (Value*) cardinalReallocate(vm, fiber->stack, fiber->stacksize * sizeof(Value), newSize * sizeof(Value));
-	fiber->stacksize = newSize;
-	
-	// reset stacktop
-	fiber->stacktop = fiber->stack + stacktop;
-	
-	// reset upvalues
+	// The open upvalues of the running frame are at the start of the list.
 	Upvalue* upval = fiber->openUpvalues;
-	while (upval != NULL) {
-		upval->value = (upval->value - oldStackBegin) + fiber->stack;
+	while (upval != NULL && upval->value >= window && upval->value < window + count) {
+		upval->value = (upval->value - window) + target->values;
 		upval = upval->next;
 	}
 	
-	// reset tops for all the callframes
-	for(int i=0; i<fiber->numFrames; i++) {
-		CallFrame* call = &(fiber->frames[i]);
-		call->top = (call->top - oldStackBegin) + fiber->stack;
-	}
+	fiber->segment = target;
+	fiber->stack = target->values;
+	fiber->stacksize = target->size;
+	fiber->stacktop = target->values + count;
 	
 	// reset stackstart variable
-	*stackstart = (fiber->frames[fiber->numFrames-1]).top;
+	*stackstart = frame->top;
 
 	return false;
 }
 
+// Leaves the current stack segment of [fiber] after the frame that was moved
+// into it returned. Returns the slot in the previous segment that receives the
+// result of that frame.
+//
+// The segments above stay allocated, so a fiber that keeps growing and
+// shrinking its stack only pays for the allocation once. They are released
+// when the fiber is pooled or freed.
+static Value* popStackSegment(ObjFiber* fiber) {
+	StackSegment* segment = fiber->segment;
+	
+	fiber->segment = segment->previous;
+	fiber->stack = fiber->segment->values;
+	fiber->stacksize = fiber->segment->size;
+	return segment->returnSlot;
+}
+
 // Check if we need to grow or shrink the callframe size
 bool cardinalFiberCallFrame(CardinalVM* vm, ObjFiber* fiber, CallFrame** frame) {
 	int newSize = 0;
@@ -777,7 +890,10 @@ bool cardinalFiberCallFrame(CardinalVM* vm, ObjFiber* fiber, CallFrame** frame)
 			return true;
 	}
 	// Stack is too large, decrease the length
-	else if (fiber->framesize > CALLFRAMESIZE && fiber->numFrames < (int) fiber->framesize / CALLFRAME_GROW_FACTOR) {
+	// Wait until the frames use a quarter of the capacity, so a fiber that calls
+	// and returns around the boundary does not keep resizing.
+	else if ((int) fiber->framesize > vm->fiberCallFrames &&
+	         fiber->numFrames < (int) fiber->framesize / (CALLFRAME_GROW_FACTOR * CALLFRAME_GROW_FACTOR)) {
 		newSize = fiber->framesize / CALLFRAME_GROW_FACTOR;
 	}
 	else { 
@@ -830,7 +946,7 @@ bool checkMethodManual(CardinalVM* vm, ObjClass*& classObj, stackTop& stacktop,
 		}
 		symbol = cardinalSymbolTableFind(&vm->methodNames, str, i);
 		
-		if (symbol >= classObj->methods.count ) return false;
+		if (symbol < 0) return false;
 		
 		method = cardinalGetMethod(vm, classObj, symbol, adj);
 		if (method == NULL || method->type == METHOD_NONE) return false;
@@ -841,7 +957,16 @@ bool checkMethodManual(CardinalVM* vm, ObjClass*& classObj, stackTop& stacktop,
 	        AS_CLASS(args[0]) == vm->metatable.listClass ||
 	        AS_CLASS(args[0]) == vm->metatable.mapClass ||
 	        AS_CLASS(args[0]) == vm->metatable.rangeClass ||
-	        AS_CLASS(args[0]) == vm->metatable.stringClass) {
+	        AS_CLASS(args[0]) == vm->metatable.stringClass ||
+	        AS_CLASS(args[0]) == vm->metatable.stringBuilderClass ||
+	        AS_CLASS(args[0]) == vm->metatable.typedArrayClass ||
+	        AS_CLASS(args[0]) == vm->metatable.float64ArrayClass ||
+	        AS_CLASS(args[0]) == vm->metatable.int32ArrayClass ||
+	        AS_CLASS(args[0]) == vm->metatable.byteArrayClass ||
+	        AS_CLASS(args[0]) == vm->metatable.dequeClass ||
+	        AS_CLASS(args[0]) == vm->metatable.setClass ||
+	        AS_CLASS(args[0]) == vm->metatable.priorityQueueClass ||
+	        AS_CLASS(args[0]) == vm->metatable.pipelineClass) {
 				return false;
 			}
 		args[0] = cardinalNewInstance(vm, AS_CLASS(args[0]), ptr);
@@ -855,6 +980,38 @@ bool checkMethodManual(CardinalVM* vm, ObjClass*& classObj, stackTop& stacktop,
 //// INTERPRETER
 ///////////////////////////////////////////////////////////////////////////////////
 
+// Joins the [numParts] strings at [parts] into a new string, which is allocated
+// once. Returns `NULL_VAL` if a part is not a string, or `UNDEFINED_VAL` if the
+// result would exceed the heap limit.
+//
+// This is kept out of [runInterpreter], so the instructions that run most do
+// not pay for its code.
+static Value concatStrings(CardinalVM* vm, Value* parts, int numParts) {
+	// Add up the lengths first, so the result is allocated once.
+	size_t length = 0;
+	bool isAscii = true;
+	for (int i = 0; i < numParts; i++) {
+		if (!IS_STRING(parts[i])) return NULL_VAL;
+		
+		length += AS_STRING(parts[i])->length;
+		isAscii = isAscii && AS_STRING(parts[i])->encoding == STRING_ASCII;
+	}
+
+	if (!cardinalReserveMemory(vm, length)) return UNDEFINED_VAL;
+
+	// The parts stay on the stack until they are copied, so a collection
+	// doesn't free them.
+	ObjString* result = AS_STRING(cardinalNewUninitializedString(vm, length));
+	char* out = result->value;
+	for (int i = 0; i < numParts; i++) {
+		ObjString* part = AS_STRING(parts[i]);
+		memcpy(out, part->value, part->length);
+		out += part->length;
+	}
+	if (isAscii) result->encoding = STRING_ASCII;
+	return OBJ_VAL(result);
+}
+
 bool runInterpreter(CardinalVM* vm) {
 	//Load the DispatchTable
 #ifdef COMPUTED_GOTO
@@ -924,6 +1081,16 @@ bool runInterpreter(CardinalVM* vm) {
 							return false; \
 						}					
 
+// Fails the current fiber if the heap limit was exceeded since the last check.
+#define CHECK_MEMORY() \
+	if (vm->garbageCollector.outOfMemory) { \
+		STORE_FRAME(); \
+		fiber = outOfMemoryError(vm, fiber); \
+		if (fiber == NULL) return false; \
+		LOAD_FRAME(); \
+		DISPATCH(); \
+	}
+
 // These macros are designed to only be invoked within this function.
 #define PUSH(value)  (*fiber->stacktop++ = value)
 #define POP()        (*(--fiber->stacktop))
@@ -1144,18 +1311,11 @@ bool runInterpreter(CardinalVM* vm) {
 			
 			bool checkManual = false;
 			
-			// If the class's method table doesn't include the symbol, bail.
+			// If neither the class nor its superclasses define the symbol, bail.
 			int adj = 0;
-			Method* method;
-			if (symbol >= classObj->methods.count) {
+			Method* method = cardinalGetMethod(vm, classObj, symbol, adj);
+			if (method == NULL || method->type == METHOD_NONE) {
 				checkManual = true;
-			} else {
-				adj = 0;
-				method = cardinalGetMethod(vm, classObj, symbol, adj);
-			
-				if (method == NULL || method->type == METHOD_NONE) {
-					checkManual = true;
-				}
 			}
 			
 			if (checkManual) {
@@ -1221,6 +1381,7 @@ bool runInterpreter(CardinalVM* vm) {
 					break;
 			}
 			CHECK_CALLFRAME();
+			CHECK_MEMORY();
 			DISPATCH();
 		}
 		
@@ -1285,12 +1446,12 @@ bool runInterpreter(CardinalVM* vm) {
 				cardinalStackPush(vm, &instance->stack, adj);
 			}
 
-			// If the class's method table doesn't include the symbol, bail.
-			if (symbol >= classObj->methods.count) {
+			// If the class doesn't define the symbol itself, bail.
+			Method* method = cardinalFindMethod(classObj, (int) symbol);
+			if (method == NULL) {
 				RUNTIME_ERROR(methodNotFound(vm, classObj, symbol));
 			}
 
-			Method* method = &classObj->methods.data[symbol];
 			switch (method->type) {
 				case METHOD_PRIMITIVE:
 				{
@@ -1339,6 +1500,7 @@ bool runInterpreter(CardinalVM* vm) {
 					break;
 			}
 			CHECK_CALLFRAME();
+			CHECK_MEMORY();
 			DISPATCH();
 		}
 		
@@ -1419,6 +1581,7 @@ bool runInterpreter(CardinalVM* vm) {
 			// Jump back to the top of the loop.
 			cardinal_integer offset = READ_OFFSET();
 			ip -= offset;
+			CHECK_MEMORY();
 			DISPATCH();
 		}
 		
@@ -1432,6 +1595,84 @@ bool runInterpreter(CardinalVM* vm) {
 			DISPATCH();
 		}
 
+		// Check whether a for loop over a range can count through numbers
+		CASECODE(FOR_RANGE_SETUP):
+		{
+			int slot = READ_LOCAL();
+			cardinal_integer offset = READ_OFFSET();
+			
+			if (IS_NUM(stackStart[slot]) && IS_NUM(stackStart[slot + 1])) ip += offset;
+			DISPATCH();
+		}
+		
+		// Advance a for loop over a range of numbers, this follows [range_iterate]
+		CASECODE(FOR_RANGE):
+		{
+			int slot = READ_LOCAL();
+			bool isInclusive = READ_BOOL();
+			cardinal_integer exitOffset = READ_OFFSET();
+			cardinal_integer bodyOffset = READ_OFFSET();
+			
+			// Ranges that are objects are iterated by the code that follows.
+			Value* locals = stackStart + slot;
+			if (!IS_NUM(locals[1])) DISPATCH();
+			
+			// Counting between small integers stays in integers. The iterator is
+			// then a small integer too, as it never passes [to].
+			if (IS_INT(locals[0]) && IS_INT(locals[1])) {
+				int64_t from = AS_INT(locals[0]);
+				int64_t to = AS_INT(locals[1]);
+				int64_t iterator = from;
+				bool done = from == to && !isInclusive;
+				
+				if (!IS_NULL(locals[2])) {
+					iterator = AS_INT(locals[2]) + (from < to ? 1 : -1);
+					done = from < to ? iterator > to : iterator < to;
+					if (!isInclusive && iterator == to) done = true;
+				}
+				
+				if (done) {
+					PUSH(FALSE_VAL);
+					ip += exitOffset;
+					DISPATCH();
+				}
+				
+				locals[2] = INT_VAL(iterator);
+				PUSH(locals[2]);
+				ip += bodyOffset;
+				DISPATCH();
+			}
+			
+			double from = AS_NUM(locals[0]);
+			double to = AS_NUM(locals[1]);
+			double iterator = from;
+			bool done = from == to && !isInclusive;
+			
+			if (!IS_NULL(locals[2])) {
+				iterator = AS_NUM(locals[2]);
+				if (from < to) {
+					iterator++;
+					done = iterator > to;
+				}
+				else {
+					iterator--;
+					done = iterator < to;
+				}
+				if (!isInclusive && iterator == to) done = true;
+			}
+			
+			if (done) {
+				PUSH(FALSE_VAL);
+				ip += exitOffset;
+				DISPATCH();
+			}
+			
+			locals[2] = NUM_VAL(iterator);
+			PUSH(locals[2]);
+			ip += bodyOffset;
+			DISPATCH();
+		}
+
 		// Jump if top of the stack is [false] or [null], else pop the top of the stack
 		CASECODE(AND):
 		{
@@ -1485,6 +1726,27 @@ bool runInterpreter(CardinalVM* vm) {
 			CHECK_STACK();
 			DISPATCH();
 		}
+
+		// Join the strings on top of the stack
+		CASECODE(CONCAT_N):
+		{
+			int numParts = READ_BYTE();
+			Value* parts = fiber->stacktop - numParts;
+			Value result = concatStrings(vm, parts, numParts);
+
+			if (IS_NULL(result)) {
+				const char* message = "Right operand must be a string.";
+				RUNTIME_ERROR(AS_STRING(cardinalNewString(vm, message, strlen(message))));
+			}
+			if (IS_UNDEFINED(result)) {
+				vm->garbageCollector.outOfMemory = true;
+				CHECK_MEMORY();
+			}
+
+			fiber->stacktop = parts;
+			PUSH(result);
+			DISPATCH();
+		}
 	
 		// Close the upvalue closest to the top of the stack
 		CASECODE(CLOSE_UPVALUE):
@@ -1506,9 +1768,18 @@ bool runInterpreter(CardinalVM* vm) {
 
 			// Close any upvalues still in scope.
 			Value* firstValue = stackStart;
-			while (fiber->openUpvalues != NULL && fiber->openUpvalues->value >= firstValue) {
+			Value* segmentEnd = fiber->stack + fiber->stacksize;
+			while (fiber->openUpvalues != NULL && fiber->openUpvalues->value >= firstValue &&
+			       fiber->openUpvalues->value < segmentEnd) {
 				closeUpvalue(fiber);
 			}
+			
+			// If the frame was moved into its own stack segment, go back to the
+			// segment it was called from.
+			Value* resultSlot = stackStart;
+			if (fiber->segment->previous != NULL && fiber->segment->frame == fiber->numFrames) {
+				resultSlot = popStackSegment(fiber);
+			}
 
 			// If the fiber is complete, end it.
 			if (fiber->numFrames == 0) {
@@ -1528,11 +1799,11 @@ bool runInterpreter(CardinalVM* vm) {
 			else {
 				// Store the result of the block in the first slot, which is where the
 				// caller expects it.
-				stackStart[0] = result;
+				*resultSlot = result;
 
 				// Discard the stack slots for the call frame (leaving one slot for the
 				// result).
-				fiber->stacktop = frame->top + 1;
+				fiber->stacktop = resultSlot + 1;
 			}
 
 			LOAD_FRAME();
@@ -1853,7 +2124,7 @@ void cardinalPopRoot(CardinalVM* vm) {
 
 void cardinalAddGCObject(CardinalVM* vm, Obj* obj) {
 	// Check if the garbage collector is in use
-	if (obj->type == OBJ_TABLE_ELEM || obj->type == OBJ_UPVALUE || vm->garbageCollector.isCoupled) {
+	if (obj->type == OBJ_UPVALUE || vm->garbageCollector.isCoupled) {
 		obj->gcflag = (GCFlag) 0;
 		
 		obj->next = vm->garbageCollector.first;
@@ -1878,7 +2149,24 @@ void cardinalGetGCStatistics(CardinalVM* vm, int* size, int* destroyed, int* det
 	*detected = vm->garbageCollector.destroyed;
 	*newObj = vm->garbageCollector.active;
 	*nextCycle = vm->garbageCollector.nextGC;
-	*nbHosts = vm->hostObjects.hostObjects->count;
+	*nbHosts = vm->hostObjects.count;
+}
+
+void cardinalGetMemoryStatistics(CardinalVM* vm, size_t* usage, size_t* peak, size_t* limit) {
+	*usage = vm->garbageCollector.bytesAllocated;
+	*peak = vm->garbageCollector.peakBytesAllocated;
+	*limit = vm->garbageCollector.maxBytes;
+}
+
+// Removes the strings that were not reached while marking from the string
+// table. The table only holds weak references, so it never keeps a string alive.
+static void sweepStringTable(CardinalVM* vm) {
+	for (uint32_t i = 0; i < vm->strings.capacity; i++) {
+		Value entry = vm->strings.entries[i];
+		if (IS_OBJ(entry) && !(AS_OBJ(entry)->gcflag & FLAG_MARKED)) {
+			vm->strings.entries[i] = TRUE_VAL;
+		}
+	}
 }
 
 static void collectGarbage(CardinalVM* vm) {
@@ -1911,10 +2199,7 @@ static void collectGarbage(CardinalVM* vm) {
 		cardinalMarkObj(vm, vm->garbageCollector.tempRoots[i]);
 	}
 	
-	if (vm->hostObjects.freeNums != NULL)
-		cardinalMarkObj(vm, (Obj*) vm->hostObjects.freeNums);
-	if (vm->hostObjects.hostObjects != NULL)
-		cardinalMarkObj(vm, (Obj*) vm->hostObjects.hostObjects);
+	cardinalMarkHostObjects(vm);
 	
 	// The current fiber.
 	if (vm->fiber != NULL) cardinalMarkObj(vm, (Obj*)vm->fiber);
@@ -1922,6 +2207,9 @@ static void collectGarbage(CardinalVM* vm) {
 	// Any object the compiler is using (if there is one).
 	if (vm->compiler != NULL) cardinalMarkCompiler(vm, vm->compiler);
 	
+	// Forget the interned strings that are about to be freed.
+	sweepStringTable(vm);
+	
 	// Collect any unmarked objects.
 	vm->garbageCollector.active = 0;
 	Obj** obj = &vm->garbageCollector.first;
@@ -1962,6 +2250,28 @@ static void collectGarbage(CardinalVM* vm) {
 //// MEMORY ALLOCATOR
 ///////////////////////////////////////////////////////////////////////////////////
 
+// Enforces the heap limit of [vm] for an allocation that grows by [growth]
+// bytes. A collection is forced first, and only if that does not free enough
+// memory the running fiber is marked to fail. The allocation itself still
+// succeeds, so the VM stays consistent until the error is raised. Large
+// allocations are refused up front through [cardinalReserveMemory] instead.
+static void checkHeapLimit(CardinalVM* vm, size_t growth) {
+	CardinalGC* gc = &vm->garbageCollector;
+	if (gc->maxBytes == 0 || gc->outOfMemory || gc->bytesAllocated <= gc->maxBytes) return;
+	
+	collectGarbage(vm);
+	gc->bytesAllocated += growth;
+	if (gc->bytesAllocated > gc->maxBytes) gc->outOfMemory = true;
+}
+
+bool cardinalReserveMemory(CardinalVM* vm, size_t bytes) {
+	CardinalGC* gc = &vm->garbageCollector;
+	if (gc->maxBytes == 0 || gc->bytesAllocated + bytes <= gc->maxBytes) return true;
+
+	collectGarbage(vm);
+	return gc->bytesAllocated + bytes <= gc->maxBytes;
+}
+
 void* cardinalReallocate(CardinalVM* vm, void* buffer, size_t oldSize, size_t newSize) {
 #if CARDINAL_DEBUG_TRACE_MEMORY
 	vm->printFunction("reallocate %p %ld -> %ld\n", buffer, oldSize, newSize);
@@ -1980,14 +2290,26 @@ void* cardinalReallocate(CardinalVM* vm, void* buffer, size_t oldSize, size_t ne
 	// track the original size). Instead, that will be handled while marking
 	// during the next GC.
 	vm->garbageCollector.bytesAllocated += newSize - oldSize;
+	if (vm->garbageCollector.bytesAllocated > vm->garbageCollector.peakBytesAllocated) {
+		vm->garbageCollector.peakBytesAllocated = vm->garbageCollector.bytesAllocated;
+	}
 	
 #if CARDINAL_DEBUG_GC_STRESS
 	// Since collecting calls this function to free things, make sure we don't
 	// recurse.
-	if (newSize > 0) collectGarbage(vm);
+	bool collect = newSize > 0;
 #else
-	if (newSize > 0 && vm->garbageCollector.bytesAllocated > vm->garbageCollector.nextGC) collectGarbage(vm);
+	bool collect = newSize > 0 && vm->garbageCollector.bytesAllocated > vm->garbageCollector.nextGC;
 #endif
+	if (collect && !vm->garbageCollector.isWorking) {
+		collectGarbage(vm);
+		
+		// The collection only counts the objects that it reaches, which does not
+		// include the growth of the block that is being allocated here.
+		if (newSize > oldSize) vm->garbageCollector.bytesAllocated += newSize - oldSize;
+	}
+
+	if (newSize > oldSize) checkHeapLimit(vm, newSize - oldSize);
 
 	return vm->reallocate(buffer, oldSize, newSize);
 }
@@ -2162,10 +2484,73 @@ static ObjFn* makeCallStub(CardinalVM* vm, ObjModule* module, const char* signat
 	cardinalSymbolTableInit(vm, &locals);
 	cardinalSymbolTableInit(vm, &lines);
 	FnDebug* debug = cardinalNewDebug(vm, NULL, signature, signatureLength, debugLines, locals, lines);
-	return cardinalNewFunction(vm, module, NULL, 0, 0, 0, bytecode, end+2, debug);
+	return cardinalNewFunction(vm, module, NULL, 0, 0, numParams, bytecode, end+2, debug);
 }
 
-static CardinalValue* getMethod(CardinalVM* vm, ObjModule* moduleObj, Value variable,
+// The number of arguments the call stub of [fiber] passes to its method.
+static inline int callArity(ObjFiber* fiber) {
+	return ((ObjFn*) fiber->frames[0].fn)->numParams;
+}
+
+// Lays out the stack of the call stub [fiber] for the next call: the receiver,
+// an empty slot for every argument and the result of the last call.
+static void clearCallSlots(ObjFiber* fiber, Value receiver, Value result) {
+	int numParams = callArity(fiber);
+	
+	fiber->stacktop = fiber->stack;
+	*fiber->stacktop++ = receiver;
+	for (int i = 0; i < numParams; i++) {
+		*fiber->stacktop++ = NULL_VAL;
+	}
+	*fiber->stacktop++ = result;
+}
+
+// Runs the call stub [fiber] with the arguments that are in its slots, and
+// gets it ready for the next call on [receiver].
+static bool runCallStub(CardinalVM* vm, ObjFiber* fiber, Value receiver) {
+	Obj* fn = fiber->frames[0].fn;
+	
+	// Only the receiver and the arguments are passed to the method.
+	fiber->stacktop = fiber->stack + 1 + callArity(fiber);
+	
+	// The host may call in while a fiber is running, for instance from a
+	// foreign method. That fiber is resumed afterwards, so it stays current and
+	// the stub keeps it alive.
+	ObjFiber* current = vm->fiber;
+	fiber->nativeCaller = current;
+	
+	vm->fiber = fiber;
+	bool succeeded = runInterpreter(vm);
+	vm->fiber = current;
+	
+	// The main fiber leaves its result in the second slot.
+	Value result = succeeded ? fiber->stack[1] : NULL_VAL;
+
+	// Reset the fiber to get ready for the next call.
+	cardinalResetFiber(fiber, fn);
+	clearCallSlots(fiber, receiver, result);
+	
+	return succeeded;
+}
+
+// Returns the stack slot of the call stub of [method] that holds argument
+// [slot], slot 0 holds the result of the last call. Returns NULL if [method] is
+// not a method or has no such slot.
+static Value* callSlot(CardinalVM* vm, CardinalValue* method, int slot) {
+	Value stub = cardinalGetHostObject(vm, method);
+	if (!IS_FIBER(stub)) return NULL;
+	
+	ObjFiber* fiber = AS_FIBER(stub);
+	int numParams = callArity(fiber);
+	if (slot < 0 || slot > numParams) return NULL;
+	
+	if (slot == 0) return &fiber->stack[numParams + 1];
+	return &fiber->stack[slot];
+}
+
+// Creates a fiber that calls the method with [signature] on [receiver] each
+// time it is run.
+static ObjFiber* newCallStubFiber(CardinalVM* vm, ObjModule* moduleObj, Value receiver,
                           const char* signature) {
 	ObjFn* fn = makeCallStub(vm, moduleObj, signature);
 	cardinalPushRoot(vm, (Obj*)fn);
@@ -2173,17 +2558,81 @@ static CardinalValue* getMethod(CardinalVM* vm, ObjModule* moduleObj, Value vari
 	// Create a single fiber that we can reuse each time the method is invoked.
 	ObjFiber* fiber = cardinalNewFiber(vm, (Obj*)fn);
 	cardinalPushRoot(vm, (Obj*)fiber);
-
-	// Create a handle that keeps track of the function that calls the method.
-	CardinalValue* ret = cardinalCreateHostObject(vm, OBJ_VAL(fiber));
+	
+	// The receiver, the arguments and the result of a call all stay in the
+	// first stack segment, so the host can access them directly.
+	if (fiber->stacksize < (size_t) fn->numParams + 2) {
+		StackSegment* segment = cardinalNewStackSegment(vm, NULL, fn->numParams + 2);
+		cardinalFreeStackSegments(vm, fiber->segment);
+		fiber->segment = segment;
+		cardinalResetFiber(fiber, (Obj*)fn);
+	}
 
 	// Store the receiver in the fiber's stack so we can use it later in the call.
-	*fiber->stacktop++ = variable;
+	clearCallSlots(fiber, receiver, NULL_VAL);
 
 	cardinalPopRoot(vm); // fiber.
 	cardinalPopRoot(vm); // fn.
 
-	return ret;
+	return fiber;
+}
+
+static CardinalValue* getMethod(CardinalVM* vm, ObjModule* moduleObj, Value variable,
+                          const char* signature) {
+	ObjFiber* fiber = newCallStubFiber(vm, moduleObj, variable, signature);
+	
+	// Create a handle that keeps track of the function that calls the method.
+	return cardinalCreateHostObject(vm, OBJ_VAL(fiber));
+}
+
+ObjFiber* cardinalNewCallFiber(CardinalVM* vm, const char* signature) {
+	return newCallStubFiber(vm, getCoreModule(vm), NULL_VAL, signature);
+}
+
+bool cardinalRunCallFiber(CardinalVM* vm, ObjFiber* fiber, Value* args, Value* result) {
+	if (vm->nativeCallDepth >= NATIVE_CALL_MAX) {
+		*result = cardinalNewString(vm, "Native calls nest too deeply.", 29);
+		return false;
+	}
+	
+	Obj* fn = fiber->frames[0].fn;
+	int numParams = callArity(fiber);
+	for (int i = 0; i <= numParams; i++) {
+		fiber->stack[i] = args[i];
+	}
+	fiber->stacktop = fiber->stack + 1 + numParams;
+	
+	// The fiber has no caller, so it would report its errors itself. Marking it
+	// as tried makes it hand them back to us instead.
+	fiber->callerIsTrying = true;
+	
+	// The fiber that called the native code is resumed afterwards, so the call
+	// fiber keeps it alive. Native calls can nest deeper than the temporary
+	// roots allow, so it is not pinned.
+	ObjFiber* current = vm->fiber;
+	fiber->nativeCaller = current;
+	
+	vm->fiber = fiber;
+	vm->nativeCallDepth++;
+	bool succeeded = runInterpreter(vm);
+	vm->nativeCallDepth--;
+	vm->fiber = current;
+	
+	if (!succeeded) {
+		*result = OBJ_VAL(fiber->error);
+	}
+	else if (fiber->numFrames > 0) {
+		// The method yielded instead of returning, there is nothing to resume.
+		*result = cardinalNewString(vm, "Cannot yield from a method called by native code.", 49);
+		succeeded = false;
+	}
+	else {
+		*result = fiber->stack[1];
+	}
+	
+	cardinalResetFiber(fiber, fn);
+	clearCallSlots(fiber, NULL_VAL, NULL_VAL);
+	return succeeded;
 }
 
 CardinalValue* cardinalGetMethod(CardinalVM* vm, const char* module, const char* variable,
@@ -2225,91 +2674,126 @@ CardinalValue* cardinalGetMethodObject(CardinalVM* vm, const char* module, Cardi
 }
 
 static CardinalValue* staticCardinalCall(CardinalVM* vm, CardinalValue* method, int args, CardinalValue* arg, va_list argList) {
-	// TODO: Validate that the number of arguments matches what the method
-	// expects.
-
-	// Push the arguments.
 	ObjFiber* fiber = AS_FIBER(cardinalGetHostObject(vm, method));
+	int numParams = callArity(fiber);
 	
-	Value value = NULL_VAL;
-	value = cardinalGetHostObject(vm, arg);
-	*fiber->stacktop++ = value;
-		
-	while (args > 0) {
-		value = NULL_VAL;
-		
-		value = cardinalGetHostObject(vm, va_arg(argList, CardinalValue*));
-		
-		*fiber->stacktop++ = value;
-		args--;
-	}
-	va_end(argList);
-
-	vm->fiber = fiber;
-	
+	// The method is called on [arg] instead of the receiver of [method].
 	Value receiver = fiber->stack[0];
-	Obj* fn = fiber->frames[0].fn;
-
-	// TODO: How does this handle a runtime error occurring?
-	runInterpreter(vm);
+	fiber->stack[0] = cardinalGetHostObject(vm, arg);
 	
-	Value returnValue = fiber->stack[1];
-
-	// Reset the fiber to get ready for the next call.
-	cardinalResetFiber(fiber, fn);
+	// Arguments the method does not expect are ignored, missing ones are null.
+	for (int i = 0; i < args; i++) {
+		Value value = cardinalGetHostObject(vm, va_arg(argList, CardinalValue*));
+		if (i < numParams) fiber->stack[i + 1] = value;
+	}
+	va_end(argList);
 
-	// Push the receiver back on the stack.
-	*fiber->stacktop++ = receiver;
+	runCallStub(vm, fiber, receiver);
 	
-	return cardinalCreateHostObject(vm, returnValue);
+	return cardinalCreateHostObject(vm, fiber->stack[numParams + 1]);
 }
 
 CardinalValue* cardinalCall(CardinalVM* vm, CardinalValue* method, int args, ...) {
-	// TODO: Validate that the number of arguments matches what the method
-	// expects.
-
-	// Push the arguments.
-	va_list argList;
-	va_start(argList, args);
 	Value val = cardinalGetHostObject(vm, method);
-	if (IS_NULL(val))
+	if (!IS_FIBER(val))
 		return NULL;
 	ObjFiber* fiber = AS_FIBER(val);
+	int numParams = callArity(fiber);
 	
-	while (args > 0) {
-		Value value = NULL_VAL;
-		
-		value = cardinalGetHostObject(vm, va_arg(argList, CardinalValue*));
-		
-		*fiber->stacktop++ = value;
-		args--;
+	// Arguments the method does not expect are ignored, missing ones are null.
+	va_list argList;
+	va_start(argList, args);
+	for (int i = 0; i < args; i++) {
+		Value value = cardinalGetHostObject(vm, va_arg(argList, CardinalValue*));
+		if (i < numParams) fiber->stack[i + 1] = value;
 	}
 	va_end(argList);
 
-	vm->fiber = fiber;
+	runCallStub(vm, fiber, fiber->stack[0]);
 	
-	Value receiver = fiber->stack[0];
-	Obj* fn = fiber->frames[0].fn;
+	return cardinalCreateHostObject(vm, fiber->stack[numParams + 1]);
+}
 
-	// TODO: How does this handle a runtime error occurring?
-	runInterpreter(vm);
+CardinalLangResult cardinalCallSlots(CardinalVM* vm, CardinalValue* method) {
+	Value val = cardinalGetHostObject(vm, method);
+	if (!IS_FIBER(val)) return CARDINAL_RUNTIME_ERROR;
+	ObjFiber* fiber = AS_FIBER(val);
 	
-	Value returnValue = fiber->stack[1];
+	if (runCallStub(vm, fiber, fiber->stack[0])) {
+		return CARDINAL_SUCCESS;
+	}
+	else {
+		return CARDINAL_RUNTIME_ERROR;
+	}
+}
 
-	// Reset the fiber to get ready for the next call.
-	cardinalResetFiber(fiber, fn);
+void cardinalSetSlotDouble(CardinalVM* vm, CardinalValue* method, int slot, double value) {
+	Value* target = callSlot(vm, method, slot);
+	if (target != NULL) *target = NUM_VAL(value);
+}
 
-	// Push the receiver back on the stack.
-	*fiber->stacktop++ = receiver;
+void cardinalSetSlotBool(CardinalVM* vm, CardinalValue* method, int slot, bool value) {
+	Value* target = callSlot(vm, method, slot);
+	if (target != NULL) *target = BOOL_VAL(value);
+}
+
+void cardinalSetSlotString(CardinalVM* vm, CardinalValue* method, int slot, const char* text, int length) {
+	Value* target = callSlot(vm, method, slot);
+	if (target == NULL) return;
+	
+	size_t size = length;
+	if (length == -1) size = strlen(text);
 	
-	return cardinalCreateHostObject(vm, returnValue);
+	// The call stub is kept alive by the host object and its stack does not
+	// move, so [target] stays valid while the string is allocated.
+	*target = cardinalNewString(vm, text, size);
+}
+
+void cardinalSetSlotNull(CardinalVM* vm, CardinalValue* method, int slot) {
+	Value* target = callSlot(vm, method, slot);
+	if (target != NULL) *target = NULL_VAL;
+}
+
+void cardinalSetSlotValue(CardinalVM* vm, CardinalValue* method, int slot, CardinalValue* value) {
+	Value* target = callSlot(vm, method, slot);
+	if (target != NULL) *target = cardinalGetHostObject(vm, value);
+}
+
+double cardinalGetSlotDouble(CardinalVM* vm, CardinalValue* method, int slot) {
+	Value* source = callSlot(vm, method, slot);
+	if (source == NULL || !IS_NUM(*source)) return 0.0;
+	return AS_NUM(*source);
+}
+
+bool cardinalGetSlotBool(CardinalVM* vm, CardinalValue* method, int slot) {
+	Value* source = callSlot(vm, method, slot);
+	if (source == NULL || !IS_BOOL(*source)) return false;
+	return AS_BOOL(*source);
+}
+
+const char* cardinalGetSlotString(CardinalVM* vm, CardinalValue* method, int slot) {
+	Value* source = callSlot(vm, method, slot);
+	if (source == NULL || !IS_STRING(*source)) return NULL;
+	return AS_CSTRING(*source);
+}
+
+bool cardinalIsSlotNull(CardinalVM* vm, CardinalValue* method, int slot) {
+	Value* source = callSlot(vm, method, slot);
+	return source == NULL || IS_NULL(*source);
+}
+
+CardinalValue* cardinalGetSlotValue(CardinalVM* vm, CardinalValue* method, int slot) {
+	Value* source = callSlot(vm, method, slot);
+	if (source == NULL) return NULL;
+	return cardinalCreateHostObject(vm, *source);
 }
 
 // Flush all host objects
 void cardinalFlushHostObjects(CardinalVM* vm) {
-	vm->hostObjects.freeNums = cardinalNewList(vm, 0);
-	vm->hostObjects.hostObjects = cardinalNewTable(vm, 0);
-	vm->hostObjects.max = 0;
+	for (int i = 0; i < vm->hostObjects.max; i++) {
+		CardinalValue* key = cardinalHostObjectAt(vm, i);
+		if (key != NULL) cardinalRemoveHostObject(vm, key);
+	}
 }
 
 // Will create an object with a certain name
@@ -2403,6 +2887,24 @@ void cardinalObjectMapSet(CardinalVM* vm, CardinalValue* list, CardinalValue* ke
 	cardinalMapSet(vm, AS_MAP(l), k, v);
 }
 
+// Creates a new typed array
+CardinalValue* cardinalCreateTypedArray(CardinalVM* vm, CardinalArrayType type, size_t count) {
+	// The array stores its count in 32 bits, larger counts would be truncated.
+	if (count > TYPED_ARRAY_MAX_COUNT) return NULL;
+	return cardinalCreateHostObject(vm, OBJ_VAL(cardinalNewTypedArray(vm, type, (uint32_t) count)));
+}
+
+// Gets the elements of a typed array
+void* cardinalGetTypedArray(CardinalVM* vm, CardinalValue* val, CardinalArrayType* type, size_t* count) {
+	Value obj = cardinalGetHostObject(vm, val);
+	if (!IS_TYPEDARRAY(obj)) return NULL;
+	
+	ObjTypedArray* array = AS_TYPEDARRAY(obj);
+	if (type != NULL) *type = array->type;
+	if (count != NULL) *count = array->count;
+	return array->data;
+}
+
 // Release's a certain object
 void cardinalReleaseObject(CardinalVM* vm, CardinalValue* val) {
 	if (val != NULL)
@@ -2693,9 +3195,12 @@ void cardinalRemoveMethod(CardinalVM* vm, const char* module, const char* variab
 		if (!IS_CLASS(val)) return;
 		ObjClass* obj = AS_CLASS(val);
 		
-		int method =  cardinalSymbolTableFind(&vm->methodNames,
+		int methodSymbol = cardinalSymbolTableFind(&vm->methodNames,
 	                                    signature, strlen(signature));
-		obj->methods.data[method].type = METHOD_NONE;
+		if (methodSymbol < 0) return;
+		
+		Method* method = cardinalFindMethod(obj, methodSymbol);
+		if (method != NULL) method->type = METHOD_NONE;
 	}
 }
 
@@ -2707,9 +3212,12 @@ void cardinalRemoveMethodObject(CardinalVM* vm, CardinalValue* variable, const c
 	if (!IS_CLASS(val)) return;
 	ObjClass* obj = AS_CLASS(val);
 	
-	int method =  cardinalSymbolTableFind(&vm->methodNames,
+	int symbol = cardinalSymbolTableFind(&vm->methodNames,
 									signature, strlen(signature));
-	obj->methods.data[method].type = METHOD_NONE;
+	if (symbol < 0) return;
+	
+	Method* method = cardinalFindMethod(obj, symbol);
+	if (method != NULL) method->type = METHOD_NONE;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -65,6 +65,16 @@ typedef struct CardinalGC {
 
 	/// The number of total allocated bytes that will trigger the next GC.
 	size_t nextGC;
+	
+	/// The maximum number of bytes that may be in use, 0 if there is no limit.
+	size_t maxBytes;
+	
+	/// The highest value [bytesAllocated] has reached.
+	size_t peakBytesAllocated;
+	
+	/// Indicates that [maxBytes] was exceeded even after a collection. The
+	/// running fiber fails with an out of memory error at the next safe point.
+	bool outOfMemory;
 
 	/// The minimum value for [nextGC] when recalculated after a collection.
 	size_t minNextGC;
@@ -168,6 +178,24 @@ typedef struct CardinalMetaTable {
 	ObjClass* moduleClass;
 	/// Metatable for methods
 	ObjClass* methodClass;
+	/// Metatable for string builders
+	ObjClass* stringBuilderClass;
+	/// Metatable for the base class of typed arrays
+	ObjClass* typedArrayClass;
+	/// Metatable for arrays of doubles
+	ObjClass* float64ArrayClass;
+	/// Metatable for arrays of 32 bit integers
+	ObjClass* int32ArrayClass;
+	/// Metatable for arrays of bytes
+	ObjClass* byteArrayClass;
+	/// Metatable for double-ended queues
+	ObjClass* dequeClass;
+	/// Metatable for sets
+	ObjClass* setClass;
+	/// Metatable for priority queues
+	ObjClass* priorityQueueClass;
+	/// Metatable for sequence pipelines
+	ObjClass* pipelineClass;
 	/// Metatable for pointers
 	ObjClass* pointerClass;
 	
@@ -186,18 +214,64 @@ void cardinalRemoveGCObject(CardinalVM* vm, Obj* obj);
 /// Used to get statistics from the Garbage collector
 void cardinalGetGCStatistics(CardinalVM* vm, int* size, int* destroyed, int* detected, int* newobj, int* gcNext, int* nbHosts);
 
+/// Fibers that were collected, kept so that new fibers can reuse them together
+/// with their stack and call frames
+typedef struct CardinalFiberPool {
+	/// The first fiber in the pool, the others are linked through [Obj::next]
+	ObjFiber* first;
+	
+	/// The number of fibers in the pool
+	int count;
+} CardinalFiberPool;
+
+/// A slot in the host object table
+typedef struct HostSlot {
+	/// The value the host refers to, `NULL_VAL` if the slot is free
+	Value value;
+	
+	/// Incremented every time the slot is released, so a handle to a released
+	/// slot is recognised when the slot is reused.
+	uintptr_t generation;
+	
+	/// The index of the next free slot when this slot is free, -1 at the end of
+	/// the list and -2 while the slot is in use
+	int nextFree;
+} HostSlot;
+
 /// The host objects from this application
+/// A [CardinalValue] handle is not allocated, it encodes the index and the
+/// generation of its slot.
 typedef struct CardinalHost {
-	/// The host objects from this application
-	ObjTable* hostObjects;
+	/// The slots of the table, marked directly by the GC
+	HostSlot* slots;
+	
+	/// Number of allocated slots
+	int capacity;
 	
-	/// Index of all free indexes to use as a key
-	ObjList* freeNums;
+	/// Number of slots that have ever been used
+	int max;
 	
-	/// highest index
-	cardinal_number max;
+	/// Number of handles in use
+	int count;
+	
+	/// The index of the first free slot, -1 if there is none below [max]
+	int firstFree;
 } CardinalHost;
 
+/// Weak set of all interned strings
+/// Strings are removed from the table once the GC finds them unreachable
+typedef struct CardinalStringTable {
+	/// Open addressed array of the strings, empty slots are UNDEFINED_VAL
+	/// and deleted slots are TRUE_VAL
+	Value* entries;
+	
+	/// Number of slots in [entries]
+	uint32_t capacity;
+	
+	/// Number of slots in use, including the deleted slots
+	uint32_t count;
+} CardinalStringTable;
+
 /// The declaration for the VM
 /// Is used as the main source for script execution
 typedef struct CardinalVM {
@@ -227,6 +301,9 @@ typedef struct CardinalVM {
 	/// The host objects from this application
 	CardinalHost hostObjects;
 	
+	/// All interned strings
+	CardinalStringTable strings;
+	
 	/// Compiler used by the VM
 	CardinalCompiler* compiler;
 		
@@ -250,12 +327,36 @@ typedef struct CardinalVM {
 	
 	/// The maximum callframe depth
 	int callDepth;
+	
+	/// The initial stack size of a new fiber
+	int fiberStackSize;
+	
+	/// The initial number of callframes of a new fiber
+	int fiberCallFrames;
+	
+	/// The number of calls from native code into scripts that are running
+	int nativeCallDepth;
+	
+	/// Collected fibers that can be reused
+	CardinalFiberPool fiberPool;
 } CardinalVM;
 
 ObjFiber* loadModuleFiber(CardinalVM* vm, Value name, Value source);
 
 bool runInterpreter(CardinalVM* vm); 
 
+// Creates a fiber that calls the method with [signature] each time it is run
+// by [cardinalRunCallFiber]. Reusing the fiber saves creating a new one for
+// every call that native code makes into a script.
+ObjFiber* cardinalNewCallFiber(CardinalVM* vm, const char* signature);
+
+// Calls the method of the call fiber [fiber] with the receiver in [args][0] and
+// the arguments after it, and waits until it returns. Stores the result in
+// [result] and returns true, or stores the error and returns false if the
+// method failed, or if more than [NATIVE_CALL_MAX] calls would be running. The
+// caller must keep [fiber] alive.
+bool cardinalRunCallFiber(CardinalVM* vm, ObjFiber* fiber, Value* args, Value* result);
+
 ObjModule* cardinalImportModuleVar(CardinalVM* vm, Value name);
 
 ObjModule* cardinalGetModule(CardinalVM* vm, Value nameValue);
@@ -331,6 +432,7 @@ static inline ObjClass* cardinalGetClassInline(CardinalVM* vm, Value value) {
 	
     case VAL_NULL: return vm->metatable.nullClass;
     case VAL_NUM: return vm->metatable.numClass;
+    case VAL_INT: return vm->metatable.numClass;
     
     case VAL_OBJ: return AS_OBJ(value)->classObj;
 	default:
@@ -363,7 +465,15 @@ static inline ObjClass* cardinalGetClassInline(CardinalVM* vm, Value value) {
 //   [oldSize] will be zero. It should return NULL.
 void* cardinalReallocate(CardinalVM* vm, void* buffer, size_t oldSize, size_t newSize);
 
-// Check if we need to grow or shrink the stack
+// Checks that [bytes] more can be allocated without exceeding the heap limit of
+// [vm], collecting garbage first if needed. Natives whose allocation size is
+// chosen by the script call this before allocating, since [cardinalReallocate]
+// cannot refuse an allocation. Returns false if the limit would be exceeded.
+bool cardinalReserveMemory(CardinalVM* vm, size_t bytes);
+
+// Makes sure there is room on the stack of [fiber]. When its current segment is
+// full, the slots of the running frame move into a new segment and
+// [stackstart] is updated. Returns true when the stack limit is reached.
 bool cardinalFiberStack(CardinalVM* vm, ObjFiber* fiber, Value** stackstart);
 bool cardinalFiberCallFrame(CardinalVM* vm, ObjFiber* fiber, CallFrame** frame);
 